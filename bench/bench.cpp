@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "bench.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "main.hpp"
+#include "mob/creature.hpp"
+#include "scene.hpp"
+
+namespace bench {
+static Options options;
+
+std::vector<Benchmark>& getBenchmarks() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+const Options& getOptions() { return options; }
+
+struct Result {
+  std::string name;
+  int64_t iterations;
+  int repetitions;
+  double meanNs, medianNs, minNs, stddevNs;  // per iteration
+  double itemsPerSecond;
+};
+
+static double runOnce(const Benchmark& benchmark, int arg, int64_t iterations, int64_t* items) {
+  State state(iterations, arg);
+  benchmark.function(state);
+  *items = state.getItemsPerIteration();
+  return state.getElapsedSeconds();
+}
+
+static Result run(const Benchmark& benchmark, int arg, float minTime, int repetitions) {
+  // find an iteration count so that one repetition lasts at least minTime
+  int64_t items = 0;
+  int64_t iterations = 1;
+  double elapsed = runOnce(benchmark, arg, iterations, &items);
+  while (elapsed < minTime && iterations < 1000000000) {
+    int64_t next = elapsed > 0.0 ? (int64_t)(iterations * minTime * 1.2 / elapsed) : iterations * 100;
+    iterations = std::clamp<int64_t>(next, iterations + 1, iterations * 100);
+    elapsed = runOnce(benchmark, arg, iterations, &items);
+  }
+  std::vector<double> samples;
+  samples.push_back(elapsed * 1E9 / iterations);
+  for (int i = 1; i < repetitions; i++) {
+    samples.push_back(runOnce(benchmark, arg, iterations, &items) * 1E9 / iterations);
+  }
+  Result result;
+  result.name = benchmark.name;
+  if (!benchmark.args.empty()) result.name += "/" + std::to_string(arg);
+  result.iterations = iterations;
+  result.repetitions = repetitions;
+  std::sort(samples.begin(), samples.end());
+  double sum = 0.0, sum2 = 0.0;
+  for (double s : samples) {
+    sum += s;
+    sum2 += s * s;
+  }
+  int n = (int)samples.size();
+  result.meanNs = sum / n;
+  result.medianNs = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+  result.minNs = samples[0];
+  result.stddevNs = sqrt(std::max(0.0, sum2 / n - result.meanNs * result.meanNs));
+  result.itemsPerSecond = items > 0 ? items * 1E9 / result.medianNs : 0.0;
+  return result;
+}
+
+static bool writeJson(const char* filename, const char* tag, const std::vector<Result>& results) {
+  FILE* f = fopen(filename, "wt");
+  if (!f) return false;
+  char date[32];
+  time_t now = time(NULL);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+  fprintf(f, "{\n  \"context\": {\n");
+  fprintf(f, "    \"tag\": \"%s\",\n", tag ? tag : "");
+  fprintf(f, "    \"date\": \"%s\",\n", date);
+#ifdef NDEBUG
+  fprintf(f, "    \"build\": \"release\",\n");
+#else
+  fprintf(f, "    \"build\": \"debug\",\n");
+#endif
+  fprintf(f, "    \"threads\": %u,\n", std::thread::hardware_concurrency());
+  fprintf(f, "    \"dungeon_size\": %d,\n", options.dungeonSize);
+  fprintf(f, "    \"seed\": %u\n", options.seed);
+  fprintf(f, "  },\n  \"benchmarks\": [\n");
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result& r = results[i];
+    fprintf(
+        f,
+        "    {\"name\": \"%s\", \"iterations\": %lld, \"repetitions\": %d, \"mean_ns\": %.1f, \"median_ns\": %.1f, "
+        "\"min_ns\": %.1f, \"stddev_ns\": %.1f, \"items_per_second\": %.1f}%s\n",
+        r.name.c_str(),
+        (long long)r.iterations,
+        r.repetitions,
+        r.meanNs,
+        r.medianNs,
+        r.minNs,
+        r.stddevNs,
+        r.itemsPerSecond,
+        i + 1 < results.size() ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  fclose(f);
+  return true;
+}
+
+static void usage() {
+  printf(
+      "usage : treeburner_bench [options]\n"
+      "  --list             list the benchmarks\n"
+      "  --filter <text>    only run the benchmarks whose name contains text\n"
+      "  --size <n>         synthetic dungeon size (default %d)\n"
+      "  --seed <n>         synthetic dungeon seed\n"
+      "  --min-time <s>     minimum duration of a repetition (default 0.5)\n"
+      "  --repetitions <n>  number of measures of each benchmark (default 3)\n"
+      "  --json <file>      write the results in json\n"
+      "  --tag <text>       stored in the json context, typically the commit hash\n"
+      "must be run from the game directory (it reads data/cfg)\n",
+      options.dungeonSize);
+}
+}  // namespace bench
+
+int main(int argc, char* argv[]) {
+  const char* filter = NULL;
+  const char* jsonFile = NULL;
+  const char* tag = NULL;
+  float minTime = 0.5f;
+  int repetitions = 3;
+  bool list = false;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--list") == 0) {
+      list = true;
+    } else if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--size") == 0 && hasValue) {
+      bench::options.dungeonSize = std::max(32, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+      bench::options.seed = (uint32_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--min-time") == 0 && hasValue) {
+      minTime = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "--repetitions") == 0 && hasValue) {
+      repetitions = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--json") == 0 && hasValue) {
+      jsonFile = argv[++i];
+    } else if (strcmp(argv[i], "--tag") == 0 && hasValue) {
+      tag = argv[++i];
+    } else {
+      bench::usage();
+      return 1;
+    }
+  }
+  if (list) {
+    for (const bench::Benchmark& b : bench::getBenchmarks()) {
+      printf("%s%s\n", b.name, b.args.empty() ? "" : "/<n>");
+    }
+    return 0;
+  }
+
+  // same initialisation as the game, without window
+  config.run("data/cfg/config.txt", NULL);
+  mob::ConditionType::init();
+  headless = true;
+  threadPool = new util::ThreadPool();
+  saveGame.init();
+  rng = new TCODRandom(bench::options.seed, TCOD_RNG_CMWC);
+  TCODConsole::root = new TCODConsole(CON_W, CON_H);
+
+  std::vector<bench::Result> results;
+  printf("%-40s %14s %14s %14s %12s\n", "benchmark", "median (us)", "min (us)", "stddev (us)", "iterations");
+  for (const bench::Benchmark& b : bench::getBenchmarks()) {
+    std::vector<int> args = b.args.empty() ? std::vector<int>{0} : b.args;
+    for (int arg : args) {
+      std::string name = b.name;
+      if (!b.args.empty()) name += "/" + std::to_string(arg);
+      if (filter && !strstr(name.c_str(), filter)) continue;
+      bench::Result r = bench::run(b, arg, minTime, repetitions);
+      printf(
+          "%-40s %14.2f %14.2f %14.2f %12lld\n",
+          r.name.c_str(),
+          r.medianNs * 1E-3,
+          r.minNs * 1E-3,
+          r.stddevNs * 1E-3,
+          (long long)r.iterations);
+      fflush(stdout);
+      results.push_back(r);
+    }
+  }
+  bench::Scene::release();
+  if (jsonFile && !bench::writeJson(jsonFile, tag, results)) {
+    printf("ERROR : cannot write %s\n", jsonFile);
+    return 1;
+  }
+  delete threadPool;
+  return 0;
+}
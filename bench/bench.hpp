@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <stdint.h>
+
+#include <chrono>
+#include <initializer_list>
+#include <vector>
+
+// minimal benchmark harness for treeburner_bench.
+// a benchmark function does its setup, then loops on keepRunning(). only the loop is timed :
+//   static void lightmapApply(bench::State& state) {
+//     ... setup ...
+//     while (state.keepRunning()) lightMap.applyToImage(img);
+//   }
+//   BENCHMARK("lighting/applyToImage", lightmapApply);
+// an optional list of arguments runs the benchmark once per value (state.getArg()).
+namespace bench {
+class State {
+ public:
+  State(int64_t iterations, int arg) : iterations(iterations), arg(arg) {}
+
+  inline bool keepRunning() {
+    if (done == 0) {
+      start = Clock::now();
+    }
+    if (done++ < iterations) return true;
+    elapsed += Clock::now() - start;
+    return false;
+  }
+  // exclude some per iteration setup from the measure
+  void pauseTiming() { elapsed += Clock::now() - start; }
+  void resumeTiming() { start = Clock::now(); }
+
+  int getArg() const { return arg; }
+  int64_t getIterations() const { return iterations; }
+  // work items per iteration (cells, creatures...), to report a throughput
+  void setItemsPerIteration(int64_t items) { itemsPerIteration = items; }
+  int64_t getItemsPerIteration() const { return itemsPerIteration; }
+  double getElapsedSeconds() const { return std::chrono::duration<double>(elapsed).count(); }
+
+ protected:
+  typedef std::chrono::steady_clock Clock;
+  int64_t iterations;
+  int64_t done = 0;
+  int arg;
+  int64_t itemsPerIteration = 0;
+  Clock::time_point start;
+  Clock::duration elapsed{0};
+};
+
+typedef void (*Function)(State& state);
+
+struct Benchmark {
+  const char* name;
+  Function function;
+  std::vector<int> args;
+};
+
+std::vector<Benchmark>& getBenchmarks();
+
+struct Registration {
+  Registration(const char* name, Function function, std::initializer_list<int> args = {}) {
+    getBenchmarks().push_back({name, function, args});
+  }
+};
+
+// options from the command line
+struct Options {
+  int dungeonSize = 200;
+  uint32_t seed = 0x7ee;
+};
+const Options& getOptions();
+}  // namespace bench
+
+#define BENCHMARK_CONCAT2(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT2(a, b)
+#define BENCHMARK(name, ...) static bench::Registration BENCHMARK_CONCAT(benchmark, __LINE__)(name, __VA_ARGS__)
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+// map generation kernels
+#include "bench.hpp"
+#include "main.hpp"
+#include "map/distancetransform.hpp"
+#include "util/cellular.hpp"
+#include "util/worldgen.hpp"
+
+namespace bench {
+// arg = map size
+static void cellularGenerate(State& state) {
+  TCODRandom caRng(getOptions().seed, TCOD_RNG_CMWC);
+  util::CellularAutomata cell(state.getArg(), state.getArg(), 45, &caRng);
+  state.setItemsPerIteration(state.getArg() * state.getArg());
+  while (state.keepRunning()) cell.generate(&util::CellularAutomata::CAFunc_cave, 1);
+}
+BENCHMARK("generation/CellularAutomata::generate", cellularGenerate, {100, 400});
+
+static void cellularConnect(State& state) {
+  TCODRandom caRng(getOptions().seed, TCOD_RNG_CMWC);
+  util::CellularAutomata original(state.getArg(), state.getArg(), 45, &caRng);
+  original.generate(&util::CellularAutomata::CAFunc_cave, 4);
+  original.generate(&util::CellularAutomata::CAFunc_cave2, 3);
+  state.setItemsPerIteration(state.getArg() * state.getArg());
+  util::CellularAutomata cell;
+  while (state.keepRunning()) {
+    state.pauseTiming();
+    cell = original;
+    state.resumeTiming();
+    cell.connect();
+  }
+}
+BENCHMARK("generation/CellularAutomata::connect", cellularConnect, {100, 400});
+
+// cave of size x size cells
+static TCODMap* makeCave(int size) {
+  TCODRandom caRng(getOptions().seed, TCOD_RNG_CMWC);
+  util::CellularAutomata cell(size, size, 45, &caRng);
+  cell.generate(&util::CellularAutomata::CAFunc_cave, 4);
+  cell.generate(&util::CellularAutomata::CAFunc_cave2, 3);
+  cell.connect();
+  cell.seal();
+  TCODMap* map = new TCODMap(size, size);
+  cell.apply(map);
+  return map;
+}
+
+// arg = map size
+static void distanceTransformCompute(State& state) {
+  TCODMap* map = makeCave(state.getArg());
+  map::DistanceTransform transform;
+  state.setItemsPerIteration(state.getArg() * state.getArg());
+  while (state.keepRunning()) transform.compute(map);
+  delete map;
+}
+BENCHMARK("generation/DistanceTransform::compute", distanceTransformCompute, {100, 400});
+
+// a random cell changes walkability, like a tree burning down
+static void distanceTransformUpdate(State& state) {
+  int size = state.getArg();
+  TCODMap* map = makeCave(size);
+  map::DistanceTransform transform;
+  transform.compute(map);
+  TCODRandom rng(getOptions().seed, TCOD_RNG_CMWC);
+  while (state.keepRunning()) {
+    int x = rng.getInt(1, size - 2);
+    int y = rng.getInt(1, size - 2);
+    map->setProperties(x, y, true, !map->isWalkable(x, y));
+    transform.update(map, x, y);
+  }
+  delete map;
+}
+BENCHMARK("generation/DistanceTransform::update", distanceTransformUpdate, {400});
+
+// gives access to the world generation steps
+class WorldGeneratorBench : public util::WorldGenerator {
+ public:
+  // state of generate() just before the precipitations
+  void prepare(TCODRandom* rng) {
+    wg_rng_ = rng;
+    noise_ = TCODNoise(2, wg_rng_);
+    buildBaseMap();
+    baseMap.copy(&heightmap_);
+  }
+  void computePrecipitations() {
+    precipitation_.clear();
+    util::WorldGenerator::computePrecipitations();
+  }
+  void erodeMap() { util::WorldGenerator::erodeMap(); }
+  void restoreBaseMap() { heightmap_.copy(&baseMap); }
+
+ protected:
+  TCODHeightMap baseMap{util::HM_WIDTH, util::HM_HEIGHT};
+};
+
+static void worldPrecipitations(State& state) {
+  TCODRandom worldRng(getOptions().seed, TCOD_RNG_CMWC);
+  WorldGeneratorBench* world = new WorldGeneratorBench();
+  world->prepare(&worldRng);
+  state.setItemsPerIteration(util::HM_WIDTH * util::HM_HEIGHT);
+  while (state.keepRunning()) world->computePrecipitations();
+  delete world;
+}
+BENCHMARK("worldgen/WorldGenerator::computePrecipitations", worldPrecipitations);
+
+static void worldErosion(State& state) {
+  TCODRandom worldRng(getOptions().seed, TCOD_RNG_CMWC);
+  WorldGeneratorBench* world = new WorldGeneratorBench();
+  world->prepare(&worldRng);
+  world->computePrecipitations();
+  state.setItemsPerIteration(util::HM_WIDTH * util::HM_HEIGHT);
+  while (state.keepRunning()) {
+    state.pauseTiming();
+    world->restoreBaseMap();
+    state.resumeTiming();
+    world->erodeMap();
+  }
+  delete world;
+}
+BENCHMARK("worldgen/WorldGenerator::erodeMap", worldErosion);
+}  // namespace bench
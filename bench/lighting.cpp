@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+// light map and fov kernels, on the visible part of the synthetic dungeon
+#include <vector>
+
+#include "bench.hpp"
+#include "main.hpp"
+#include "map/light.hpp"
+#include "scene.hpp"
+
+namespace bench {
+// a single light. arg = range in subcells
+static void lightAdd(State& state) {
+  Scene* scene = Scene::get();
+  map::LightMap& lightMap = scene->engine.lightMap;
+  map::Light light((float)state.getArg(), TCODColor::lightAmber);
+  light.setPos(scene->viewx * 2, scene->viewy * 2);
+  lightMap.clear(TCODColor::black);
+  state.setItemsPerIteration(state.getArg() * state.getArg() * 4);
+  while (state.keepRunning()) light.addToLightMap(lightMap);
+}
+BENCHMARK("lighting/Light::add", lightAdd, {8, 16, 32});
+
+// a light moving one subcell per frame, so that its fov cache is never reused
+static void lightAddMoving(State& state) {
+  Scene* scene = Scene::get();
+  map::LightMap& lightMap = scene->engine.lightMap;
+  map::Light light((float)state.getArg(), TCODColor::lightAmber);
+  lightMap.clear(TCODColor::black);
+  state.setItemsPerIteration(state.getArg() * state.getArg() * 4);
+  int step = 0;
+  while (state.keepRunning()) {
+    light.setPos(scene->viewx * 2 + (step++ & 1), scene->viewy * 2);
+    light.addToLightMap(lightMap);
+  }
+}
+BENCHMARK("lighting/Light::add_moving", lightAddMoving, {8, 16, 32});
+
+// same with the angular noise of torches
+static void lightAddRandomRad(State& state) {
+  Scene* scene = Scene::get();
+  map::LightMap& lightMap = scene->engine.lightMap;
+  map::Light light((float)state.getArg(), TCODColor::lightAmber, true);
+  light.setPos(scene->viewx * 2, scene->viewy * 2);
+  lightMap.clear(TCODColor::black);
+  state.setItemsPerIteration(state.getArg() * state.getArg() * 4);
+  while (state.keepRunning()) light.addToLightMap(lightMap);
+}
+BENCHMARK("lighting/Light::add_randomRad", lightAddRandomRad, {16});
+
+// all the lights of a frame. arg = number of lights
+static void renderLights(State& state) {
+  Scene* scene = Scene::get();
+  scene->addLights(state.getArg(), 16.0f, true);
+  state.setItemsPerIteration(state.getArg());
+  while (state.keepRunning()) {
+    // force a full render
+    scene->engine.lightMap.hasLights = false;
+    scene->dungeon->renderLightsToLightMap(scene->engine.lightMap, NULL, NULL, NULL, NULL, true);
+  }
+  scene->clearLights();
+}
+BENCHMARK("lighting/renderLightsToLightMap", renderLights, {10, 50});
+
+// static lights and a single moving one, so that only its part of the lightmap is rendered again
+static void renderLightsIncremental(State& state) {
+  Scene* scene = Scene::get();
+  scene->addLights(state.getArg(), 16.0f, false);
+  map::Light light(16.0f, TCODColor::lightAmber);
+  scene->dungeon->addLight(&light);
+  state.setItemsPerIteration(state.getArg() + 1);
+  int step = 0;
+  while (state.keepRunning()) {
+    light.setPos(scene->viewx * 2 + (step++ & 1), scene->viewy * 2);
+    scene->dungeon->renderLightsToLightMap(scene->engine.lightMap, NULL, NULL, NULL, NULL, true);
+  }
+  scene->dungeon->removeLight(&light);
+  scene->clearLights();
+}
+BENCHMARK("lighting/renderLightsToLightMap_incremental", renderLightsIncremental, {10, 50});
+
+// same as renderLights with the lights computed per cell and upsampled
+static void renderLightsLowRes(State& state) {
+  Scene* scene = Scene::get();
+  scene->addLights(state.getArg(), 16.0f, true);
+  state.setItemsPerIteration(state.getArg());
+  bool lowRes = scene->engine.lightMap.lowRes;
+  scene->engine.lightMap.lowRes = true;
+  while (state.keepRunning()) {
+    scene->engine.lightMap.hasLights = false;
+    scene->dungeon->renderLightsToLightMap(scene->engine.lightMap, NULL, NULL, NULL, NULL, true);
+  }
+  scene->engine.lightMap.lowRes = lowRes;
+  scene->clearLights();
+}
+BENCHMARK("lighting/renderLightsToLightMap_lowRes", renderLightsLowRes, {10, 50});
+
+static void applyToImage(State& state) {
+  Scene* scene = Scene::get();
+  scene->addLights(20, 16.0f, true);
+  scene->dungeon->renderLightsToLightMap(scene->engine.lightMap, NULL, NULL, NULL, NULL, true);
+  scene->clearLights();
+  scene->engine.lightMap.fogRange = 15.0f;
+  state.setItemsPerIteration(CON_W * CON_H * 4);
+  while (state.keepRunning()) scene->engine.lightMap.applyToImage(scene->engine.frame);
+}
+BENCHMARK("lighting/LightMap::applyToImage", applyToImage);
+
+// fog of the whole view, one fBm per subcell as before the fog field
+static void playerFog(State& state) {
+  Scene* scene = Scene::get();
+  map::LightMap& lightMap = scene->engine.lightMap;
+  lightMap.fogRange = 15.0f;
+  state.setItemsPerIteration(CON_W * CON_H * 4);
+  while (state.keepRunning()) {
+    lightMap.update(1.0f / 60);
+    for (int y = 0; y < lightMap.height; y++) {
+      for (int x = 0; x < lightMap.width; x++) {
+        lightMap.getPlayerFog(x + scene->engine.xOffset * 2, y + scene->engine.yOffset * 2);
+      }
+    }
+  }
+}
+BENCHMARK("fog/LightMap::getPlayerFog", playerFog);
+
+// same from the time sliced fog field, at 60 fps
+static void playerFogField(State& state) {
+  Scene* scene = Scene::get();
+  map::LightMap& lightMap = scene->engine.lightMap;
+  lightMap.fogRange = 15.0f;
+  std::vector<float> fog(lightMap.width);
+  state.setItemsPerIteration(CON_W * CON_H * 4);
+  while (state.keepRunning()) {
+    lightMap.update(1.0f / 60);
+    lightMap.updateFogField();
+    for (int y = 0; y < lightMap.height; y++) lightMap.getPlayerFogRow(0, y, lightMap.width, fog.data());
+  }
+}
+BENCHMARK("fog/LightMap::getPlayerFogRow", playerFogField);
+
+static void applyToImageOutdoor(State& state) {
+  Scene* scene = Scene::get();
+  scene->engine.lightMap.clear(TCODColor::white);
+  state.setItemsPerIteration(CON_W * CON_H * 4);
+  while (state.keepRunning()) scene->engine.lightMap.applyToImageOutdoor(scene->engine.frame);
+}
+BENCHMARK("lighting/LightMap::applyToImageOutdoor", applyToImageOutdoor);
+
+// final quantization of the hdr frame
+static void toneMap(State& state) {
+  Scene* scene = Scene::get();
+  scene->engine.frame.clear(TCODColor::grey);
+  state.setItemsPerIteration(CON_W * CON_H * 4);
+  while (state.keepRunning()) scene->engine.frame.toImage(scene->engine.ground);
+}
+BENCHMARK("lighting/HDRImage::toImage", toneMap);
+
+static void lightMapClear(State& state) {
+  Scene* scene = Scene::get();
+  state.setItemsPerIteration(CON_W * CON_H * 4);
+  while (state.keepRunning()) scene->engine.lightMap.clear(TCODColor::darkGrey);
+}
+BENCHMARK("lighting/LightMap::clear", lightMapClear);
+
+static void computeFov(State& state) {
+  Scene* scene = Scene::get();
+  state.setItemsPerIteration(CON_W * CON_H * 4);
+  while (state.keepRunning()) scene->dungeon->computeFov(scene->viewx, scene->viewy);
+}
+BENCHMARK("fov/Dungeon::computeFov", computeFov);
+}  // namespace bench
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+// minions tracking the player, with a path each or with the shared flow field.
+// long range paths, with A* or with the hierarchical pathfinder
+#include <vector>
+
+#include "bench.hpp"
+#include "main.hpp"
+#include "map/hpa.hpp"
+#include "mob/behavior.hpp"
+#include "scene.hpp"
+
+namespace bench {
+// creatures of type id at random visible positions
+static void spawnCreatures(Scene* scene, mob::CreatureTypeId id, int count, TCODList<mob::Creature*>* list) {
+  TCODRandom rng(scene->context.seed, TCOD_RNG_CMWC);
+  for (int i = 0; i < count; i++) {
+    mob::Creature* cr = mob::Creature::getCreature(id);
+    int x, y;
+    scene->getRandomVisiblePosition(&rng, &x, &y);
+    cr->setPos(x, y);
+    scene->dungeon->addCreature(cr);
+    list->push(cr);
+  }
+}
+
+static void removeCreatures(Scene* scene, TCODList<mob::Creature*>* list) {
+  for (mob::Creature** it = list->begin(); it != list->end(); it++) {
+    scene->dungeon->removeCreature(*it, false);
+    mob::Creature::removeFromType(*it);
+  }
+  list->clearAndDelete();
+}
+
+// the player alternates between two cells so that every iteration has to track a new position
+static void movePlayer(Scene* scene, int iteration, const int* playerx, const int* playery) {
+  scene->engine.player.setPos(playerx[iteration & 1], playery[iteration & 1]);
+}
+
+// arg = number of minions
+static void minionAStar(State& state) {
+  Scene* scene = Scene::get();
+  TCODList<mob::Creature*> minions;
+  spawnCreatures(scene, mob::CREATURE_MINION, state.getArg(), &minions);
+  TCODRandom rng(scene->context.seed + 1, TCOD_RNG_CMWC);
+  int playerx[2], playery[2];
+  for (int i = 0; i < 2; i++) scene->getRandomVisiblePosition(&rng, &playerx[i], &playery[i]);
+  std::vector<TCODPath*> paths;
+  for (mob::Creature** it = minions.begin(); it != minions.end(); it++) {
+    paths.push_back(new TCODPath(scene->dungeon->width, scene->dungeon->height, *it, &scene->engine));
+  }
+  state.setItemsPerIteration(state.getArg());
+  int iteration = 0;
+  while (state.keepRunning()) {
+    movePlayer(scene, iteration++, playerx, playery);
+    int px = (int)scene->engine.player.x, py = (int)scene->engine.player.y;
+    for (int i = 0; i < minions.size(); i++) {
+      mob::Creature* cr = minions.get(i);
+      int nx, ny;
+      if (paths[i]->compute((int)cr->x, (int)cr->y, px, py)) paths[i]->get(0, &nx, &ny);
+    }
+  }
+  for (TCODPath* path : paths) delete path;
+  removeCreatures(scene, &minions);
+}
+BENCHMARK("pathfinding/Minion_astar", minionAStar, {200});
+
+// arg = number of minions
+static void minionFlowField(State& state) {
+  Scene* scene = Scene::get();
+  TCODList<mob::Creature*> minions;
+  spawnCreatures(scene, mob::CREATURE_MINION, state.getArg(), &minions);
+  TCODRandom rng(scene->context.seed + 1, TCOD_RNG_CMWC);
+  int playerx[2], playery[2];
+  for (int i = 0; i < 2; i++) scene->getRandomVisiblePosition(&rng, &playerx[i], &playery[i]);
+  state.setItemsPerIteration(state.getArg());
+  int iteration = 0;
+  while (state.keepRunning()) {
+    movePlayer(scene, iteration++, playerx, playery);
+    const map::FlowField& field = scene->dungeon->getPlayerFlowField();
+    for (mob::Creature** it = minions.begin(); it != minions.end(); it++) {
+      int nx, ny;
+      field.getNextStep((int)(*it)->x, (int)(*it)->y, &nx, &ny,
+                        [scene](int cx, int cy) { return !scene->dungeon->hasCreature(cx, cy); });
+    }
+  }
+  removeCreatures(scene, &minions);
+}
+BENCHMARK("pathfinding/Minion_flowField", minionFlowField, {200});
+
+// path between two random walkable cells of the whole dungeon
+static void longRangePath(State& state, map::Path* path) {
+  Scene* scene = Scene::get();
+  map::Dungeon* dungeon = scene->dungeon;
+  TCODRandom rng(scene->context.seed, TCOD_RNG_CMWC);
+  while (state.keepRunning()) {
+    state.pauseTiming();
+    int ox = rng.getInt(0, dungeon->width - 1), oy = rng.getInt(0, dungeon->height - 1);
+    int dx = rng.getInt(0, dungeon->width - 1), dy = rng.getInt(0, dungeon->height - 1);
+    dungeon->getClosestWalkable(&ox, &oy, true, false, true);
+    dungeon->getClosestWalkable(&dx, &dy, true, false, true);
+    state.resumeTiming();
+    path->compute(ox, oy, dx, dy);
+  }
+}
+
+static void longRangeAStar(State& state) {
+  Scene* scene = Scene::get();
+  mob::AvoidWaterWalkPattern walkPattern;
+  map::AStarPath path(scene->dungeon->width, scene->dungeon->height, &walkPattern, NULL);
+  longRangePath(state, &path);
+}
+BENCHMARK("pathfinding/AStarPath::compute", longRangeAStar);
+
+static void longRangeHierarchical(State& state) {
+  Scene* scene = Scene::get();
+  mob::AvoidWaterWalkPattern walkPattern;
+  map::HierarchicalPath path(&walkPattern, NULL);
+  scene->dungeon->getPathGraph();  // build the graph out of the timing
+  longRangePath(state, &path);
+}
+BENCHMARK("pathfinding/HierarchicalPath::compute", longRangeHierarchical);
+}  // namespace bench
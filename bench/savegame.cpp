@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+// savegame round trip of the synthetic dungeon
+#include <filesystem>
+
+#include "bench.hpp"
+#include "main.hpp"
+#include "scene.hpp"
+
+namespace bench {
+static std::string getSaveDirectory() {
+  return (std::filesystem::temp_directory_path() / "treeburner_bench").string();
+}
+
+static void saveRoundTrip(State& state) {
+  Scene* scene = Scene::get();
+  std::string dir = getSaveDirectory();
+  // never touch the player savegame
+  saveGame.setDirectory(dir.c_str());
+  saveGame.registerListener(DUNG_CHUNK_ID, base::PHASE_START, scene->dungeon);
+  state.setItemsPerIteration(scene->dungeon->width * scene->dungeon->height);
+  while (state.keepRunning()) {
+    saveGame.save();
+    if (!saveGame.load(base::PHASE_START)) {
+      printf("ERROR : cannot load the savegame back\n");
+      break;
+    }
+  }
+  saveGame.unregisterListener(scene->dungeon);
+  std::filesystem::remove_all(dir);
+}
+BENCHMARK("savegame/SaveGame::save+load", saveRoundTrip);
+}  // namespace bench
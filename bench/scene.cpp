@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "scene.hpp"
+
+#include "bench.hpp"
+#include "main.hpp"
+#include "map/light.hpp"
+
+namespace bench {
+Scene* Scene::instance = NULL;
+
+Scene* Scene::get() {
+  if (!instance) instance = new Scene(getOptions().dungeonSize, getOptions().seed);
+  return instance;
+}
+
+void Scene::release() {
+  delete instance;
+  instance = NULL;
+}
+
+Scene::Scene(int size, uint32_t seed) : context(seed) {
+  dungeon = new map::Dungeon(size, size, &context);
+  // cave
+  util::CellularAutomata cell(size, size, 45, &context.rng);
+  cell.generate(&util::CellularAutomata::CAFunc_cave, 4);
+  cell.generate(&util::CellularAutomata::CAFunc_cave2, 3);
+  cell.connect();
+  cell.seal();
+  cell.apply(dungeon->map);
+  // clearing with a lake in the middle
+  viewx = viewy = size / 2;
+  int radius = MIN(CON_H / 2, size / 4);
+  for (int x = viewx - radius; x <= viewx + radius; x++) {
+    for (int y = viewy - radius; y <= viewy + radius; y++) {
+      if (SQRDIST(x, y, viewx, viewy) <= radius * radius) dungeon->setProperties(x, y, true, true);
+    }
+  }
+  lake = base::Rect(viewx + 2, viewy - radius / 2, radius / 2 + 2, radius);
+  for (int x = (int)lake.x; x < (int)(lake.x + lake.w); x++) {
+    for (int y = (int)lake.y; y < (int)(lake.y + lake.h); y++) {
+      dungeon->setTerrainType(x, y, map::TERRAIN_SHALLOW_WATER);
+    }
+  }
+  dungeon->finalizeMap(&context, true, true);
+  for (int x = (int)lake.x * 2; x < (int)(lake.x + lake.w) * 2; x++) {
+    for (int y = (int)lake.y * 2; y < (int)(lake.y + lake.h) * 2; y++) {
+      dungeon->getSubCell(x, y)->waterCoef = 1.0f;
+    }
+  }
+  dungeon->setAmbient(TCODColor::darkGrey);
+  dungeon->computeSpawnSources(context.config.spawnSourceRange);
+
+  engine.dungeon = dungeon;
+  engine.player.setPos(viewx, viewy);
+  engine.xOffset = viewx - CON_W / 2;
+  engine.yOffset = viewy - CON_H / 2;
+  dungeon->computeFov(viewx, viewy);
+}
+
+Scene::~Scene() {
+  clearLights();
+  engine.dungeon = NULL;
+  delete dungeon;
+}
+
+void Scene::getRandomVisiblePosition(TCODRandom* rng, int* x, int* y) {
+  *x = rng->getInt(MAX(0, engine.xOffset), MIN(dungeon->width - 1, engine.xOffset + CON_W - 1));
+  *y = rng->getInt(MAX(0, engine.yOffset), MIN(dungeon->height - 1, engine.yOffset + CON_H - 1));
+  dungeon->getClosestWalkable(x, y, true, true, false);
+}
+
+void Scene::addLights(int count, float range, bool randomRad) {
+  TCODRandom lightRng(context.seed, TCOD_RNG_CMWC);
+  for (int i = 0; i < count; i++) {
+    map::Light* light = new map::Light(range, TCODColor::lightAmber, randomRad);
+    int x, y;
+    getRandomVisiblePosition(&lightRng, &x, &y);
+    // lights use subcell coordinates
+    light->setPos(x * 2, y * 2);
+    dungeon->addLight(light);
+    benchLights.push(light);
+  }
+}
+
+void Scene::clearLights() {
+  for (map::Light** it = benchLights.begin(); it != benchLights.end(); it++) {
+    dungeon->removeLight(*it);
+    delete *it;
+  }
+  benchLights.clear();
+}
+}  // namespace bench
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <libtcod.hpp>
+
+#include "base/gameengine.hpp"
+#include "map/dungeon.hpp"
+#include "util/gencontext.hpp"
+
+namespace bench {
+// game engine without window nor rendering. the game code reaches it through the gameEngine global
+class BenchEngine : public base::GameEngine {
+ public:
+  void render() override {}
+  void setRippleManager(util::RippleManager* manager) { rippleManager = manager; }
+  void setFireManager(util::FireManager* manager) { fireManager = manager; }
+};
+
+// synthetic cave shared by the benchmarks. created on first use, with the size from the command line.
+// a clearing with a lake is dug in the middle and the view is centered on it
+class Scene {
+ public:
+  static Scene* get();
+  static void release();
+
+  BenchEngine engine;
+  util::GenerationContext context;
+  map::Dungeon* dungeon;
+  int viewx, viewy;  // view center, in dungeon cells
+  base::Rect lake;  // shallow water, in dungeon cells
+
+  // random lights in the visible part of the dungeon. removed with clearLights
+  void addLights(int count, float range, bool randomRad);
+  void clearLights();
+  // random walkable position in the visible part of the dungeon
+  void getRandomVisiblePosition(TCODRandom* rng, int* x, int* y);
+
+ protected:
+  Scene(int size, uint32_t seed);
+  ~Scene();
+  TCODList<map::Light*> benchLights;
+  static Scene* instance;
+};
+}  // namespace bench
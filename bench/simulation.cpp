@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+// per frame simulation kernels
+#include "bench.hpp"
+#include "main.hpp"
+#include "mob/behavior.hpp"
+#include "scene.hpp"
+#include "util/fire.hpp"
+#include "util/ripples.hpp"
+
+namespace bench {
+// fire effect update period
+static const float FIRE_DELAY = 0.05f;
+
+static void fireUpdate(State& state) {
+  int w = CON_W * 2, h = CON_H * 2;
+  util::Fire fire(w, h);
+  state.setItemsPerIteration(w * h);
+  while (state.keepRunning()) {
+    for (int x = 1; x <= w; x++) fire.spark(x, h - 1);
+    fire.update(FIRE_DELAY);
+  }
+}
+BENCHMARK("simulation/Fire::update", fireUpdate);
+
+// arg = number of burning zones in the view
+static void fireManagerUpdate(State& state) {
+  Scene* scene = Scene::get();
+  util::FireManager fireManager(scene->dungeon);
+  TCODRandom zoneRng(scene->context.seed, TCOD_RNG_CMWC);
+  for (int i = 0; i < state.getArg(); i++) {
+    int x, y;
+    scene->getRandomVisiblePosition(&zoneRng, &x, &y);
+    fireManager.addZone(x * 2 - 6, y * 2 - 6, 12, 12);
+  }
+  scene->engine.setFireManager(&fireManager);
+  state.setItemsPerIteration(CON_W * CON_H * 4);
+  while (state.keepRunning()) fireManager.update(FIRE_DELAY);
+  scene->engine.setFireManager(NULL);
+}
+BENCHMARK("simulation/FireManager::update", fireManagerUpdate, {1, 10});
+
+static void updateRipples(State& state) {
+  Scene* scene = Scene::get();
+  util::RippleManager rippleManager(scene->dungeon);
+  scene->engine.setRippleManager(&rippleManager);
+  TCODRandom rippleRng(scene->context.seed, TCOD_RNG_CMWC);
+  const base::Rect& lake = scene->lake;
+  state.setItemsPerIteration(lake.w * lake.h * 4);
+  while (state.keepRunning()) {
+    // keep the water moving
+    int x = rippleRng.getInt((int)lake.x, (int)lake.x + lake.w - 1);
+    int y = rippleRng.getInt((int)lake.y, (int)lake.y + lake.h - 1);
+    rippleManager.startRipple(x, y);
+    // the ripples are updated 10 times per second
+    rippleManager.updateRipples(0.11f);
+  }
+  scene->engine.setRippleManager(NULL);
+  // remove the fishes
+  TCODList<mob::Creature*> fishes;
+  for (mob::Creature** it = scene->dungeon->creatures.begin(); it != scene->dungeon->creatures.end(); it++) {
+    if ((*it)->type == mob::CREATURE_FISH) fishes.push(*it);
+  }
+  for (mob::Creature** it = fishes.begin(); it != fishes.end(); it++) {
+    scene->dungeon->removeCreature(*it, false);
+    mob::Creature::removeFromType(*it);
+  }
+}
+BENCHMARK("simulation/RippleManager::updateRipples", updateRipples);
+
+// arg = number of deers in the herd
+static void herdUpdate(State& state) {
+  Scene* scene = Scene::get();
+  TCODRandom herdRng(scene->context.seed, TCOD_RNG_CMWC);
+  TCODList<mob::Creature*> herd;
+  for (int i = 0; i < state.getArg(); i++) {
+    mob::Creature* deer = mob::Creature::getCreature(mob::CREATURE_DEER);
+    int x, y;
+    scene->getRandomVisiblePosition(&herdRng, &x, &y);
+    deer->setPos(x, y);
+    scene->dungeon->addCreature(deer);
+    herd.push(deer);
+  }
+  state.setItemsPerIteration(state.getArg());
+  while (state.keepRunning()) {
+    for (mob::Creature** it = herd.begin(); it != herd.end(); it++) {
+      (*it)->currentBehavior->update(*it, 0.033f);
+    }
+  }
+  for (mob::Creature** it = herd.begin(); it != herd.end(); it++) {
+    scene->dungeon->removeCreature(*it, false);
+    mob::Creature::removeFromType(*it);
+  }
+  herd.clearAndDelete();
+}
+BENCHMARK("simulation/HerdBehavior::update", herdUpdate, {50, 200, 800});
+}  // namespace bench
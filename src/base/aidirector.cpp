@@ -87,7 +87,7 @@ void AiDirector::update(float elapsed) {
     status = STATUS_MED;
   else
     status = STATUS_HIGH;
-  const int nbCreatures = mob::Creature::creatureByType[baseCreature].size();
+  const int nbCreatures = mob::Creature::getNbOfType(baseCreature);
   if (nbCreatures >= maxCreatures) return;
   if (spawnTimer > 60.0f) {
     spawnTimer -= 60.0f;
@@ -47,7 +47,7 @@ void GameEngine::onActivate() {
   computeAspectRatio();
   gui.activate();
   stats = {};
-  TCODConsole::mapAsciiCodeToFont(TCOD_CHAR_PROGRESSBAR, 26, 3);
+  if (!headless) TCODConsole::mapAsciiCodeToFont(TCOD_CHAR_PROGRESSBAR, 26, 3);
   isUpdatingFireballs = false;
 }
 
@@ -105,9 +105,31 @@ void GameEngine::recomputeCanopy(item::Item* it) {
 }
 
 void GameEngine::setCanopy(int x, int y, const item::ItemType* treeType, const Rect* pr) {
+  static const int treeRadius = config.getIntProperty("config.display.treeRadius");
+  drawCanopy(dungeon, aspectRatio, treeRadius, TCODRandom::getInstance(), x, y, treeType, pr);
+}
+
+void GameEngine::setCanopy(
+    map::Dungeon* dungeon,
+    util::GenerationContext* context,
+    int x,
+    int y,
+    const item::ItemType* treeType,
+    const Rect* pr) {
+  drawCanopy(dungeon, context->aspectRatio, context->config.treeRadius, &context->detailRng, x, y, treeType, pr);
+}
+
+void GameEngine::drawCanopy(
+    map::Dungeon* dungeon,
+    float aspectRatio,
+    int treeRadiusW,
+    TCODRandom* rng,
+    int x,
+    int y,
+    const item::ItemType* treeType,
+    const Rect* pr) {
   static TCODColor green1 = TCODColor::darkChartreuse;
   static TCODColor green2 = TCODColor::green * 0.7f;
-  static const int treeRadiusW = config.getIntProperty("config.display.treeRadius");
   Rect r(0, 0, dungeon->width * 2, dungeon->height * 2);
   if (pr) r = *pr;
   for (int tx = -treeRadiusW; tx <= treeRadiusW; tx++) {
@@ -117,10 +139,10 @@ void GameEngine::setCanopy(int x, int y, const item::ItemType* treeType, const R
       for (int ty = -dy; ty <= dy; ty++) {
         if (y + ty >= r.y && y + ty < r.y + r.h) {
           if (dungeon->getShadowHeight(x + tx, y + ty) < 2.0f) {
-            TCODColor treecol = TCODColor::lerp(green1, green2, TCODRandom::getInstance()->getFloat(0.0f, 1.0f));
+            TCODColor treecol = TCODColor::lerp(green1, green2, rng->getFloat(0.0f, 1.0f));
             if (treeType->name == "pine tree") treecol = treecol * 0.75f;
             treecol = treecol * (0.6f + 0.4f * (tx + treeRadiusW) / (2 * treeRadiusW));
-            if (treeType->name == "apple tree" && TCODRandom::getInstance()->getInt(0, 80) == 0)
+            if (treeType->name == "apple tree" && rng->getInt(0, 80) == 0)
               treecol = TCODColor::darkOrange;
             dungeon->canopy->putPixel(x + tx, y + ty, treecol);
             if (x + tx >= 2) {
@@ -144,6 +166,11 @@ void GameEngine::setCanopy(int x, int y, const item::ItemType* treeType, const R
 }
 
 void GameEngine::computeAspectRatio() {
+  if (headless) {
+    // no font
+    aspectRatio = 1.0f;
+    return;
+  }
   int charw, charh;
   TCODSystem::getCharSize(&charw, &charh);
   aspectRatio = (float)(charw) / charh;
@@ -269,6 +296,7 @@ void GameEngine::updateFireballs(float elapsed) {
 
 void GameEngine::displayProgress(float prog) {
   // printf ("==> %g \n",prog);
+  if (headless) return;
   int l = (int)(CON_W / 2 * prog);
   if (l > 0) {
     TCODConsole::root->setDefaultBackground(TCODColor::red);
@@ -38,7 +38,9 @@
 #include "ui/dialog.hpp"
 #include "ui/gui.hpp"
 #include "util/fire.hpp"
+#include "util/gencontext.hpp"
 #include "util/packer.hpp"
+#include "util/progress.hpp"
 #include "util/ripples.hpp"
 
 namespace base {
@@ -60,7 +62,8 @@ class GameEngine : public screen::Screen {
   map::Dungeon* dungeon{};  // current dungeon map
   int xOffset{}, yOffset{};  // coordinate of console cell 0,0 in dungeon
   int mousex{}, mousey{};  // cell under mouse cursor
-  TCODImage ground{CON_W * 2, CON_H * 2};  // visible part of the ground
+  map::HDRImage frame{CON_W * 2, CON_H * 2};  // visible part of the ground, lit, before tone mapping
+  TCODImage ground{CON_W * 2, CON_H * 2};  // tone mapped frame
 
   map::LightMap lightMap{CON_W * 2, CON_H * 2};  // store light reaching each cell
   util::Packer packer{0, 0, CON_W, CON_H};
@@ -95,6 +98,14 @@ class GameEngine : public screen::Screen {
   void removeFireZone(int x, int y, int w, int h);
   void recomputeCanopy(item::Item* it = NULL);
   void setCanopy(int x, int y, const item::ItemType* treeType, const Rect* r = NULL);
+  // same thing on a map being generated. doesn't use the engine state so that it can run on a worker thread
+  static void setCanopy(
+      map::Dungeon* dungeon,
+      util::GenerationContext* context,
+      int x,
+      int y,
+      const item::ItemType* treeType,
+      const Rect* r = NULL);
 
   // base utilities. to be moved elsewhere
   static TCODColor setSepia(const TCODColor& col, float coef);
@@ -121,5 +132,27 @@ class GameEngine : public screen::Screen {
   void onActivate() override;
   void onDeactivate() override;
   void computeAspectRatio();
+  static void drawCanopy(
+      map::Dungeon* dungeon,
+      float aspectRatio,
+      int treeRadius,
+      TCODRandom* rng,
+      int x,
+      int y,
+      const item::ItemType* treeType,
+      const Rect* pr);
+};
+
+// progress bar drawn on the root console each time the generation code reports. main thread only
+class ProgressBar : public util::Progress {
+ public:
+  explicit ProgressBar(GameEngine* engine) : engine(engine) {}
+  void set(float value) override {
+    util::Progress::set(value);
+    engine->displayProgress(value);
+  }
+
+ protected:
+  GameEngine* engine;
 };
 }  // namespace base
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "base/headless.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "main.hpp"
+#include "screen/screen.hpp"
+
+namespace base {
+static bool parseKey(const char* name, TCOD_key_t* key) {
+  static const struct {
+    const char* name;
+    TCOD_keycode_t vk;
+    char c;
+  } namedKeys[] = {
+      {"up", TCODK_UP, 0},
+      {"down", TCODK_DOWN, 0},
+      {"left", TCODK_LEFT, 0},
+      {"right", TCODK_RIGHT, 0},
+      {"space", TCODK_SPACE, ' '},
+      {"enter", TCODK_ENTER, '\r'},
+      {"escape", TCODK_ESCAPE, 27},
+      {"tab", TCODK_TAB, '\t'},
+  };
+  for (const auto& named : namedKeys) {
+    if (strcmp(name, named.name) == 0) {
+      key->vk = named.vk;
+      key->c = named.c;
+      return true;
+    }
+  }
+  if (name[0] == 0 || name[1] != 0) return false;
+  key->vk = TCODK_CHAR;
+  key->c = name[0];
+  return true;
+}
+
+bool ScriptedInput::load(const char* filename) {
+  FILE* f = fopen(filename, "rt");
+  if (!f) return false;
+  char line[256];
+  int lineNum = 0;
+  while (fgets(line, sizeof(line), f)) {
+    lineNum++;
+    char action[32] = "";
+    char arg[32] = "";
+    Event ev{};
+    if (line[0] == '#' || line[0] == '\n') continue;
+    if (sscanf(line, "%f %31s %31s %d", &ev.time, action, arg, &ev.cy) < 3) {
+      printf("WARNING : %s:%d : bad input event\n", filename, lineNum);
+      continue;
+    }
+    if (strcmp(action, "press") == 0 || strcmp(action, "release") == 0) {
+      ev.isKey = true;
+      ev.key.pressed = action[0] == 'p';
+      if (!parseKey(arg, &ev.key)) {
+        printf("WARNING : %s:%d : unknown key %s\n", filename, lineNum, arg);
+        continue;
+      }
+    } else if (strcmp(action, "mouse") == 0 || strcmp(action, "click") == 0) {
+      ev.cx = atoi(arg);
+      ev.click = action[0] == 'c';
+    } else {
+      printf("WARNING : %s:%d : unknown action %s\n", filename, lineNum, action);
+      continue;
+    }
+    events.push_back(ev);
+  }
+  fclose(f);
+  return true;
+}
+
+void ScriptedInput::getInput(float time, TCOD_key_t* key, TCOD_mouse_t* mouse) {
+  mouseState.lbutton_pressed = false;
+  if (nextEvent < events.size() && events[nextEvent].time <= time) {
+    const Event& ev = events[nextEvent++];
+    if (ev.isKey) {
+      *key = ev.key;
+    } else {
+      mouseState.dcx = ev.cx - mouseState.cx;
+      mouseState.dcy = ev.cy - mouseState.cy;
+      mouseState.cx = ev.cx;
+      mouseState.cy = ev.cy;
+      mouseState.lbutton_pressed = ev.click;
+    }
+  }
+  *mouse = mouseState;
+}
+
+bool HeadlessRunner::run(const char* moduleName, InputSource* input) {
+  static float timeScale = config.getFloatProperty("config.gameplay.timeScale");
+  screen::Screen* module = dynamic_cast<screen::Screen*>(engine.getModule(moduleName));
+  if (!module) {
+    printf("FATAL : unknown module '%s'\n", moduleName);
+    return false;
+  }
+  auto t0 = std::chrono::steady_clock::now();
+  module->setActive(true);
+  auto t1 = std::chrono::steady_clock::now();
+  int nbSteps = 0;
+  float time = 0.0f;
+  while (time < duration) {
+    TCOD_key_t key{};
+    TCOD_mouse_t mouse{};
+    if (input) input->getInput(time, &key, &mouse);
+    float elapsed = timestep * timeScale;
+    // end of the replay
+    if (!screen::Screen::beginTick(&elapsed, &key, &mouse)) break;
+    time += timestep;
+    nbSteps++;
+    // the module has finished (player death, victory...)
+    if (!module->step(elapsed, key, mouse)) break;
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  module->setActive(false);
+  float initTime = std::chrono::duration<float>(t1 - t0).count();
+  float runTime = std::chrono::duration<float>(t2 - t1).count();
+  printf(
+      "headless %s : init %.3fs, %d steps, %.1f simulated seconds in %.3fs (x%.1f)\n",
+      moduleName,
+      initTime,
+      nbSteps,
+      time,
+      runTime,
+      runTime > 0.0f ? time / runTime : 0.0f);
+  return true;
+}
+}  // namespace base
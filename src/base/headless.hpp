@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <libtcod.hpp>
+#include <vector>
+
+namespace base {
+// provides the keyboard and mouse state for each headless simulation step
+class InputSource {
+ public:
+  virtual ~InputSource() {}
+  // time is the simulated time at the start of the step, in seconds
+  virtual void getInput(float time, TCOD_key_t* key, TCOD_mouse_t* mouse) = 0;
+};
+
+// input read from a text file. one event per line, sorted by time :
+//   <time> press <key>
+//   <time> release <key>
+//   <time> mouse <cellx> <celly>
+//   <time> click <cellx> <celly>
+// key is a printable character or one of up, down, left, right, space, enter, escape, tab.
+// at most one event is applied per step, like the real game loop
+class ScriptedInput : public InputSource {
+ public:
+  bool load(const char* filename);
+  void getInput(float time, TCOD_key_t* key, TCOD_mouse_t* mouse) override;
+
+ protected:
+  struct Event {
+    float time;
+    bool isKey;
+    TCOD_key_t key;
+    int cx, cy;
+    bool click;
+  };
+  std::vector<Event> events;
+  size_t nextEvent = 0;
+  TCOD_mouse_t mouseState{};
+};
+
+// drives a game module without window nor rendering, with a fixed timestep.
+// runs as fast as possible : used for soak tests and perf runs on machines without display
+class HeadlessRunner {
+ public:
+  HeadlessRunner(float timestep, float duration) : timestep(timestep), duration(duration) {}
+  // input can be NULL (the player does nothing). returns false if the module doesn't exist
+  bool run(const char* moduleName, InputSource* input);
+
+ protected:
+  float timestep;  // simulated seconds per step
+  float duration;  // simulated seconds before stopping
+};
+}  // namespace base
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "base/inputlog.hpp"
+
+#include <filesystem>
+
+#include "main.hpp"
+
+namespace base {
+#define INPUTLOG_MAGIC 0x4c504e49  // INPL
+#define INPUTLOG_VERSION 1
+
+// frame flags
+#define FRAME_KEY 1  // a key event follows
+#define FRAME_MOUSE 2  // the mouse state changed. it follows
+#define FRAME_CTRL 4
+#define FRAME_SHIFT 8
+
+// key flags
+#define KEY_PRESSED 1
+#define KEY_LALT 2
+#define KEY_LCTRL 4
+#define KEY_LMETA 8
+#define KEY_RALT 16
+#define KEY_RCTRL 32
+#define KEY_RMETA 64
+#define KEY_SHIFT 128
+
+InputLog::~InputLog() {
+  if (frameTimeFile) fclose(frameTimeFile);
+}
+
+// the simulation also uses the default libtcod generator. it's seeded with the time
+void InputLog::resetRandom(uint32_t seed) {
+  TCODRandom seeded(seed, TCOD_RNG_CMWC);
+  TCODRandom::getInstance()->restore(&seeded);
+}
+
+bool InputLog::startRecord(const char* filename, uint32_t seed) {
+  this->filename = filename;
+  mode = MODE_RECORD;
+  zip.putInt(INPUTLOG_MAGIC);
+  zip.putInt(INPUTLOG_VERSION);
+  zip.putInt((int)seed);
+  // changes how the input is interpreted
+  zip.putChar(userPref.mouseOnly ? 1 : 0);
+  resetRandom(seed);
+  return true;
+}
+
+bool InputLog::startReplay(const char* filename, uint32_t* seed) {
+  this->filename = filename;
+  if (zip.loadFromFile(filename) == 0 || zip.getInt() != INPUTLOG_MAGIC) {
+    printf("FATAL : %s is not an input log\n", filename);
+    return false;
+  }
+  if (zip.getInt() != INPUTLOG_VERSION) {
+    printf("FATAL : bad input log version in %s\n", filename);
+    return false;
+  }
+  *seed = (uint32_t)zip.getInt();
+  userPref.mouseOnly = zip.getChar() != 0;
+  mode = MODE_REPLAY;
+  resetRandom(*seed);
+  return true;
+}
+
+bool InputLog::setFrameTimeFile(const char* filename) {
+  frameTimeFile = fopen(filename, "wt");
+  if (!frameTimeFile) return false;
+  fprintf(frameTimeFile, "frame,elapsed,ms\n");
+  lastFrameTime = std::chrono::steady_clock::now();
+  return true;
+}
+
+bool InputLog::processFrame(float* elapsed, TCOD_key_t* key, TCOD_mouse_t* mouse) {
+  if (mode == MODE_RECORD) {
+    ctrl = TCODConsole::isKeyPressed(TCODK_CONTROL);
+    shift = TCODConsole::isKeyPressed(TCODK_SHIFT);
+    writeFrame(*elapsed, *key, *mouse);
+  } else if (mode == MODE_REPLAY) {
+    if (!readFrame(elapsed, key, mouse)) {
+      printf("end of replay after %d frames\n", frame);
+      return false;
+    }
+  }
+  if (frameTimeFile) {
+    // duration of the previous frame, rendering included
+    auto now = std::chrono::steady_clock::now();
+    if (frame > 0) {
+      float ms = std::chrono::duration<float, std::milli>(now - lastFrameTime).count();
+      fprintf(frameTimeFile, "%d,%g,%g\n", frame - 1, *elapsed, ms);
+    }
+    lastFrameTime = now;
+  }
+  frame++;
+  return true;
+}
+
+bool InputLog::isKeyPressed(TCOD_keycode_t key) const {
+  if (mode == MODE_NONE) return TCODConsole::isKeyPressed(key);
+  if (key == TCODK_CONTROL) return ctrl;
+  if (key == TCODK_SHIFT) return shift;
+  return false;
+}
+
+static bool isSameMouse(const TCOD_mouse_t& m1, const TCOD_mouse_t& m2) {
+  return m1.x == m2.x && m1.y == m2.y && m1.dx == m2.dx && m1.dy == m2.dy && m1.cx == m2.cx && m1.cy == m2.cy &&
+         m1.dcx == m2.dcx && m1.dcy == m2.dcy && m1.lbutton == m2.lbutton && m1.rbutton == m2.rbutton &&
+         m1.mbutton == m2.mbutton && m1.lbutton_pressed == m2.lbutton_pressed &&
+         m1.rbutton_pressed == m2.rbutton_pressed && m1.mbutton_pressed == m2.mbutton_pressed &&
+         m1.wheel_up == m2.wheel_up && m1.wheel_down == m2.wheel_down;
+}
+
+void InputLog::writeFrame(float elapsed, const TCOD_key_t& key, const TCOD_mouse_t& mouse) {
+  bool mouseChanged = !isSameMouse(mouse, lastMouse);
+  int flags = 0;
+  if (key.vk != TCODK_NONE) flags |= FRAME_KEY;
+  if (mouseChanged) flags |= FRAME_MOUSE;
+  if (ctrl) flags |= FRAME_CTRL;
+  if (shift) flags |= FRAME_SHIFT;
+  zip.putFloat(elapsed);
+  zip.putChar((char)flags);
+  if (flags & FRAME_KEY) {
+    int keyFlags = (key.pressed ? KEY_PRESSED : 0) | (key.lalt ? KEY_LALT : 0) | (key.lctrl ? KEY_LCTRL : 0) |
+                   (key.lmeta ? KEY_LMETA : 0) | (key.ralt ? KEY_RALT : 0) | (key.rctrl ? KEY_RCTRL : 0) |
+                   (key.rmeta ? KEY_RMETA : 0) | (key.shift ? KEY_SHIFT : 0);
+    zip.putChar((char)key.vk);
+    zip.putChar(key.c);
+    zip.putChar((char)keyFlags);
+  }
+  if (flags & FRAME_MOUSE) {
+    zip.putInt(mouse.x);
+    zip.putInt(mouse.y);
+    zip.putInt(mouse.dx);
+    zip.putInt(mouse.dy);
+    zip.putInt(mouse.cx);
+    zip.putInt(mouse.cy);
+    zip.putInt(mouse.dcx);
+    zip.putInt(mouse.dcy);
+    int buttons = (mouse.lbutton ? 1 : 0) | (mouse.rbutton ? 2 : 0) | (mouse.mbutton ? 4 : 0) |
+                  (mouse.lbutton_pressed ? 8 : 0) | (mouse.rbutton_pressed ? 16 : 0) |
+                  (mouse.mbutton_pressed ? 32 : 0) | (mouse.wheel_up ? 64 : 0) | (mouse.wheel_down ? 128 : 0);
+    zip.putChar((char)buttons);
+    lastMouse = mouse;
+  }
+}
+
+bool InputLog::readFrame(float* elapsed, TCOD_key_t* key, TCOD_mouse_t* mouse) {
+  if (zip.getRemainingBytes() == 0) return false;
+  *elapsed = zip.getFloat();
+  int flags = (uint8_t)zip.getChar();
+  ctrl = (flags & FRAME_CTRL) != 0;
+  shift = (flags & FRAME_SHIFT) != 0;
+  *key = TCOD_key_t{};
+  if (flags & FRAME_KEY) {
+    key->vk = (TCOD_keycode_t)(uint8_t)zip.getChar();
+    key->c = zip.getChar();
+    int keyFlags = (uint8_t)zip.getChar();
+    key->pressed = (keyFlags & KEY_PRESSED) != 0;
+    key->lalt = (keyFlags & KEY_LALT) != 0;
+    key->lctrl = (keyFlags & KEY_LCTRL) != 0;
+    key->lmeta = (keyFlags & KEY_LMETA) != 0;
+    key->ralt = (keyFlags & KEY_RALT) != 0;
+    key->rctrl = (keyFlags & KEY_RCTRL) != 0;
+    key->rmeta = (keyFlags & KEY_RMETA) != 0;
+    key->shift = (keyFlags & KEY_SHIFT) != 0;
+  }
+  if (flags & FRAME_MOUSE) {
+    lastMouse.x = zip.getInt();
+    lastMouse.y = zip.getInt();
+    lastMouse.dx = zip.getInt();
+    lastMouse.dy = zip.getInt();
+    lastMouse.cx = zip.getInt();
+    lastMouse.cy = zip.getInt();
+    lastMouse.dcx = zip.getInt();
+    lastMouse.dcy = zip.getInt();
+    int buttons = (uint8_t)zip.getChar();
+    lastMouse.lbutton = (buttons & 1) != 0;
+    lastMouse.rbutton = (buttons & 2) != 0;
+    lastMouse.mbutton = (buttons & 4) != 0;
+    lastMouse.lbutton_pressed = (buttons & 8) != 0;
+    lastMouse.rbutton_pressed = (buttons & 16) != 0;
+    lastMouse.mbutton_pressed = (buttons & 32) != 0;
+    lastMouse.wheel_up = (buttons & 64) != 0;
+    lastMouse.wheel_down = (buttons & 128) != 0;
+  }
+  *mouse = lastMouse;
+  return true;
+}
+
+void InputLog::finish() {
+  if (mode == MODE_RECORD) {
+    std::filesystem::path path(filename);
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path());
+    if (zip.saveToFile(filename.c_str()) == 0) printf("ERROR : cannot write input log %s\n", filename.c_str());
+    printf("%d frames recorded in %s\n", frame, filename.c_str());
+  }
+  mode = MODE_NONE;
+  if (frameTimeFile) {
+    fclose(frameTimeFile);
+    frameTimeFile = nullptr;
+  }
+}
+}  // namespace base
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <libtcod.hpp>
+#include <stdio.h>
+
+#include <chrono>
+#include <string>
+
+namespace base {
+// records or replays everything that feeds the simulation : the seed, the frame length,
+// the keyboard and the mouse. a replayed session takes the same decisions as the recorded one,
+// frame by frame, so it can be used to compare the performances of two builds
+class InputLog {
+ public:
+  enum Mode { MODE_NONE, MODE_RECORD, MODE_REPLAY };
+
+  ~InputLog();
+  // the log is written when finish() is called
+  bool startRecord(const char* filename, uint32_t seed);
+  // seed receives the recorded seed
+  bool startReplay(const char* filename, uint32_t* seed);
+  // write the duration of each frame in a csv file
+  bool setFrameTimeFile(const char* filename);
+  // called once per engine tick. records the frame, or replaces it with the recorded one.
+  // returns false when the replay is over
+  bool processFrame(float* elapsed, TCOD_key_t* key, TCOD_mouse_t* mouse);
+  // keyboard state outside of key events. replayed too
+  bool isKeyPressed(TCOD_keycode_t key) const;
+  void finish();
+  Mode getMode() const { return mode; }
+  int getFrame() const { return frame; }
+
+ protected:
+  Mode mode = MODE_NONE;
+  std::string filename;
+  TCODZip zip;
+  int frame = 0;
+  bool ctrl = false, shift = false;  // modifiers state during the current frame
+  TCOD_mouse_t lastMouse{};
+  FILE* frameTimeFile = nullptr;
+  std::chrono::steady_clock::time_point lastFrameTime;
+
+  void resetRandom(uint32_t seed);
+  void writeFrame(float elapsed, const TCOD_key_t& key, const TCOD_mouse_t& mouse);
+  bool readFrame(float* elapsed, TCOD_key_t* key, TCOD_mouse_t* mouse);
+};
+}  // namespace base
@@ -101,12 +101,12 @@ void SaveGame::clear() {
 
 bool SaveGame::load(SavePhase phase) {
   zip = new TCODZip();
-  if (zip->loadFromFile("data/sav/savegame.dat") == 0) {
+  if (zip->loadFromFile((directory + "/savegame.dat").c_str()) == 0) {
     clear();
     return false;
   }
   idx = new TCODZip();
-  if (idx->loadFromFile("data/sav/savegame.idx") == 0) {
+  if (idx->loadFromFile((directory + "/savegame.idx").c_str()) == 0) {
     clear();
     return false;
   }
@@ -189,14 +189,14 @@ void SaveGame::save() {
   }
   sizes.push(zip->getCurrentBytes() - startPos.pop());
   // DBG(("size : %d\n",sizes.peek()));
-  std::filesystem::create_directories("data/sav");
-  zip->saveToFile("data/sav/savegame.dat");
+  std::filesystem::create_directories(directory);
+  zip->saveToFile((directory + "/savegame.dat").c_str());
   idx = new TCODZip();
   idx->putInt(sizes.size());
   for (uint32_t* offset = sizes.begin(); offset != sizes.end(); offset++) {
     idx->putInt(*offset);
   }
-  idx->saveToFile("data/sav/savegame.idx");
+  idx->saveToFile((directory + "/savegame.idx").c_str());
 }
 
 #define GAME_CHUNK_VERSION 1
@@ -25,6 +25,7 @@
  */
 #pragma once
 #include <libtcod.hpp>
+#include <string>
 
 namespace base {
 #define SAVEGAME_MAGIC_NUMBER 0xFD051E4F
@@ -78,6 +79,8 @@ class SaveGame : public SaveListener {
   void unregisterListener(SaveListener* listener);
   bool load(SavePhase phase);
   void save();
+  // where savegame.dat/.idx are stored. data/sav by default
+  void setDirectory(const char* dir) { directory = dir; }
 
   // load/save the GAME chunk
   bool loadData(uint32_t chunkId, uint32_t chunkVersion, TCODZip* zip);
@@ -107,5 +110,6 @@ class SaveGame : public SaveListener {
   // size of the chunks currently saved
   TCODList<uint32_t> sizes;
   uint32_t nbChunks;
+  std::string directory{"data/sav"};
 };
 }  // namespace base
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+// globals declared in main.hpp. kept out of main.cpp so that other executables (treeburner_bench)
+// can link the game code with their own entry point
+#include "main.hpp"
+
+TCODNoise noise1d(1);
+TCODNoise noise2d(2);
+TCODNoise noise3d(3);
+TCODRandom* rng = nullptr;
+bool mouseControl = false;
+bool headless = false;
+bool newGame = false;
+base::SaveGame saveGame;
+base::UserPref userPref;
+base::InputLog inputLog;
+UmbraEngine engine("./data/cfg/umbra.txt", UMBRA_REGISTER_ALL);
+TCODImage background("./data/img/background.png");
+TCODParser config;
+util::Sound sound;
+util::ThreadPool* threadPool = nullptr;
+
+map::HDRColor getHDRColorProperty(const TCODParser& parser, const char* name) {
+  TCODList<float> l(parser.getListProperty(name, TCOD_TYPE_FLOAT));
+  return map::HDRColor(l.get(0), l.get(1), l.get(2));
+}
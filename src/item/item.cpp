@@ -36,7 +36,7 @@
 #include "item.hpp"
 #include "main.hpp"
 #include "map/building.hpp"
-#include "screen/game.hpp"
+#include "screen/school.hpp"
 #include "ui/inventory.hpp"
 #include "util/cellular.hpp"
 #include "util/textgen.hpp"
@@ -163,7 +163,7 @@ ItemFeature* ItemFeature::getContainer(int size) {
   return ret;
 }
 
-Item* ItemType::produce(float rng) const {
+Item* ItemType::produce(float roll, TCODRandom* rng) const {
   float odds = 0.0f;
   TCODList<ItemFeature*> produceFeatures;
   // select one of the produce features
@@ -173,12 +173,12 @@ Item* ItemType::produce(float rng) const {
       odds += (*it)->produce.chance;
     }
   }
-  rng *= odds;
+  roll *= odds;
   for (ItemFeature** it = produceFeatures.begin(); it != produceFeatures.end(); it++) {
-    rng -= (*it)->produce.chance;
-    if (rng < 0) {
+    roll -= (*it)->produce.chance;
+    if (roll < 0) {
       // this one wins!
-      return Item::getItem((*it)->produce.type, 0, 0);
+      return Item::getItem((*it)->produce.type, 0, 0, true, rng);
     }
   }
   return NULL;
@@ -772,12 +772,7 @@ ItemCombination* ItemType::getCombination() const {
   return NULL;
 }
 
-Item::Item(float x, float y, const ItemType& type) {
-  if (descCon == NULL) {
-    descCon = new TCODConsole(CON_W / 2, CON_H / 2);
-    descCon->setAlignment(TCOD_CENTER);
-    descCon->setDefaultBackground(ui::guiBackground);
-  }
+Item::Item(float x, float y, const ItemType& type, TCODRandom* rng) {
   setPos(x, y);
   typeName_ = type.name;
   name_ = {};
@@ -819,26 +814,26 @@ Item::Item(float x, float y, const ItemType& type) {
   an_ = false;
 }
 
-Item* Item::getItem(const char* typeName, float x, float y, bool createComponents) {
+Item* Item::getItem(const char* typeName, float x, float y, bool createComponents, TCODRandom* rng) {
   ItemType* type = Item::getType(typeName);
   if (!type) {
     printf("FATAL : unknown item type '%s'\n", typeName);
     return NULL;
   }
-  return Item::getItem(type, x, y, createComponents);
+  return Item::getItem(type, x, y, createComponents, rng);
 }
 
-Item* Item::getItem(const ItemType* type, float x, float y, bool createComponents) {
-  Item* ret = new Item(x, y, *type);
-  if (createComponents) ret->generateComponents();
+Item* Item::getItem(const ItemType* type, float x, float y, bool createComponents, TCODRandom* rng) {
+  if (!rng) rng = ::rng;
+  Item* ret = new Item(x, y, *type, rng);
+  if (createComponents) ret->generateComponents(rng);
   return ret;
 }
 
-#define MAX_RELOAD_BONUS 0.2f
-#define MAX_CAST_BONUS 0.2f
-Item* Item::getRandomWeapon(const char* typeName, ItemClass itemClass) {
+Item* Item::getRandomWeapon(const char* typeName, ItemClass itemClass, TCODRandom* rng) {
+  if (!rng) rng = ::rng;
   if (!textgen) {
-    textgen = new util::TextGenerator("data/cfg/weapon.txg", rng);
+    textgen = new util::TextGenerator("data/cfg/weapon.txg", ::rng);
     textgen->parseFile();
   }
   ItemType* type = getType(typeName);
@@ -846,7 +841,7 @@ Item* Item::getRandomWeapon(const char* typeName, ItemClass itemClass) {
     printf("FATAL : unknown weapon type '%s'\n", typeName);
     return NULL;
   }
-  Item* weapon = Item::getItem(type, -1, -1, false);
+  Item* weapon = Item::getItem(type, -1, -1, false, rng);
   weapon->item_class_ = itemClass;
   weapon->color_ = Item::classColor[itemClass];
   if (itemClass > ITEM_CLASS_STANDARD) {
@@ -888,7 +883,7 @@ Item* Item::getRandomWeapon(const char* typeName, ItemClass itemClass) {
   weapon->damages_ += weapon->damages_ * (int)(itemClass)*0.2f;  // 20% increase per color level
   weapon->damages_ = MIN(1.0f, weapon->damages_);
   // build components
-  weapon->generateComponents();
+  weapon->generateComponents(rng);
   return weapon;
 }
 
@@ -899,7 +894,7 @@ void Item::addComponent(Item* component) {
   }
 }
 
-void Item::generateComponents() {
+void Item::generateComponents(TCODRandom* rng) {
   // check if this item type has components
   ItemCombination* combination = getCombination();
   if (!combination) return;
@@ -910,7 +905,7 @@ void Item::generateComponents() {
       if (combination->ingredients[i].optional) maxOptionals--;
       ItemType* componentType = combination->ingredients[i].type;
       if (componentType) {
-        Item* component = Item::getItem(componentType, x, y);
+        Item* component = Item::getItem(componentType, x, y, true, rng);
         addComponent(component);
       }
     }
@@ -1063,67 +1058,6 @@ void Item::computeBottleName() {
   }
 }
 
-void Item::render(map::LightMap& lightMap, TCODImage* ground) {
-  int conx = (int)(x - gameEngine->xOffset);
-  int cony = (int)(y - gameEngine->yOffset);
-  if (!IN_RECTANGLE(conx, cony, CON_W, CON_H)) return;
-  map::Dungeon* dungeon = gameEngine->dungeon;
-  TCODColor lightColor = lightMap.getColor(conx, cony);
-  float shadow = dungeon->getShadow(x * 2, y * 2);
-  float clouds = dungeon->getCloudCoef(x * 2, y * 2);
-  shadow = MIN(shadow, clouds);
-  lightColor = lightColor * shadow;
-  TCODConsole::root->setChar(conx, cony, ch_);
-  TCODConsole::root->setCharForeground(conx, cony, color_ * lightColor);
-  if (ground) {
-    TCODConsole::root->setCharBackground(conx, cony, ground->getPixel(conx * 2, cony * 2));
-  } else {
-    TCODConsole::root->setCharBackground(conx, cony, dungeon->getShadedGroundColor(getSubX(), getSubY()));
-  }
-}
-
-void Item::renderDescription(int x, int y, bool below) {
-  int cy = 0;
-  descCon->clear();
-  descCon->setDefaultForeground(Item::classColor[item_class_]);
-  if (name_) {
-    if (count_ > 1)
-      descCon->print(CON_W / 4, cy++, "%s(%d)", name_->c_str(), count_);
-    else
-      descCon->print(CON_W / 4, cy++, name_->c_str());
-    descCon->setDefaultForeground(ui::guiText);
-    descCon->print(CON_W / 4, cy++, typeName_.c_str());
-  } else {
-    if (count_ > 1)
-      descCon->print(CON_W / 4, cy++, "%s(%d)", typeName_.c_str(), count_);
-    else
-      descCon->print(CON_W / 4, cy++, typeName_.c_str());
-  }
-  descCon->setDefaultForeground(ui::guiText);
-  ItemFeature* feat = getFeature(ITEM_FEAT_FOOD);
-  if (feat) descCon->print(CON_W / 4, cy++, "Health:+%d", feat->food.health);
-  feat = getFeature(ITEM_FEAT_ATTACK);
-  if (feat) {
-    static const char* wieldname[] = {NULL, "One hand", "Main hand", "Off hand", "Two hands"};
-    if (feat->attack.wield) {
-      descCon->print(CON_W / 4, cy++, wieldname[feat->attack.wield]);
-    }
-    float rate = 1.0f / (cast_delay_ + reload_delay_);
-    int dmgPerSec = (int)(damages_ * rate + 0.5f);
-    descCon->print(CON_W / 4, cy++, "%d damages/sec", dmgPerSec);
-    descCon->print(CON_W / 4, cy++, "Attack rate:%s", getRateName(rate));
-    modifier::ItemModifier::renderDescription(descCon, 2, cy, modifiers_);
-  }
-
-  /*
-          y--;
-          if ( y < 0 ) y = 2;
-          TCODConsole::root->setDefaultForeground(Item::classColor[itemClass]);
-          TCODConsole::root->printEx(x,y,TCOD_BKGND_NONE,TCOD_CENTER,typeName);
-  */
-  renderDescriptionFrame(x, y, below);
-}
-
 const char* Item::getRateName(float rate) const {
   static const char* ratename[] = {"Very slow", "Slow", "Average", "Fast", "Very fast"};
   int rateIdx = 0;
@@ -1140,63 +1074,6 @@ const char* Item::getRateName(float rate) const {
   return ratename[rateIdx];
 }
 
-void Item::renderGenericDescription(int x, int y, bool below, bool frame) {
-  int cy = 0;
-  descCon->clear();
-  descCon->setDefaultForeground(Item::classColor[item_class_]);
-  if (name_) {
-    if (count_ > 1)
-      descCon->print(CON_W / 4, cy++, "%s(%d)", name_->c_str(), count_);
-    else
-      descCon->print(CON_W / 4, cy++, name_->c_str());
-    descCon->setDefaultForeground(ui::guiText);
-    descCon->print(CON_W / 4, cy++, typeName_.c_str());
-  } else {
-    if (count_ > 1)
-      descCon->print(CON_W / 4, cy++, "%s(%d)", typeName_.c_str(), count_);
-    else
-      descCon->print(CON_W / 4, cy++, typeName_.c_str());
-  }
-  descCon->setDefaultForeground(ui::guiText);
-  ItemFeature* feat = getFeature(ITEM_FEAT_FOOD);
-  if (feat) descCon->print(CON_W / 4, cy++, "Health:+%d", feat->food.health);
-  feat = getFeature(ITEM_FEAT_ATTACK);
-  if (feat) {
-    static const char* wieldname[] = {NULL, "One hand", "Main hand", "Off hand", "Two hands"};
-    if (feat->attack.wield) {
-      descCon->print(CON_W / 4, cy++, wieldname[feat->attack.wield]);
-    }
-    float minCast = feat->attack.minCastDelay - item_class_ * MAX_CAST_BONUS;
-    float minReload = feat->attack.minReloadDelay - item_class_ * MAX_RELOAD_BONUS;
-    float minDamages = 15 * (minCast + minReload) * feat->attack.minDamagesCoef;
-    float maxDamages = 15 * (feat->attack.maxCastDelay + feat->attack.maxReloadDelay) * feat->attack.maxDamagesCoef;
-    minDamages += minDamages * (int)(item_class_)*0.2f;
-    maxDamages += maxDamages * (int)(item_class_)*0.2f;
-    minDamages = (int)MIN(1.0f, minDamages);
-    maxDamages = (int)MIN(1.0f, maxDamages);
-
-    if (minDamages != maxDamages) {
-      descCon->print(CON_W / 4, cy++, "%d-%d damages/hit", (int)minDamages, (int)maxDamages);
-    } else {
-      descCon->print(CON_W / 4, cy++, "%d damages/hit", (int)minDamages);
-    }
-
-    float minRate = 1.0f / (feat->attack.maxCastDelay + feat->attack.maxReloadDelay);
-    float maxRate = 1.0f / (minCast + minReload);
-
-    const char* rate1 = getRateName(minRate);
-    const char* rate2 = getRateName(maxRate);
-    if (rate1 == rate2) {
-      descCon->print(CON_W / 4, cy++, "Attack rate:%s", rate1);
-    } else {
-      descCon->print(CON_W / 4, cy++, "Attack rate:%s-%s", rate1, rate2);
-    }
-    // ItemModifier::renderDescription(descCon,2,cy,modifiers);
-  }
-
-  renderDescriptionFrame(x, y, below, frame);
-}
-
 void Item::convertTo(ItemType* newType) {
   // create the new item
   Item* newItem = Item::getItem(newType, x, y);
@@ -1316,10 +1193,7 @@ bool Item::update(float elapsed, TCOD_key_t key, TCOD_mouse_t* mouse) {
         }
       }
     }
-    if ((int)x != (int)oldx || (int)y != (int)oldy) {
-      helpers::remove<item::Item*>(dungeon->getCell(oldx, oldy)->items, this);
-      dungeon->getCell(x, y)->items.push_back(this);
-    }
+    if ((int)x != (int)oldx || (int)y != (int)oldy) dungeon->moveItem(this, (int)oldx, (int)oldy);
     duration -= elapsed;
     if (duration < 0.0f) {
       speed = 0.0f;
@@ -1347,7 +1221,7 @@ bool Item::update(float elapsed, TCOD_key_t key, TCOD_mouse_t* mouse) {
               phase_ = IDLE;
             spell::FireBall* fb = new spell::FireBall(
                 owner_->x, owner_->y, target_x_, target_y_, spell::FB_STANDARD, feat->attack.spellCasted);
-            ((screen::Game*)gameEngine)->addFireball(fb);
+            gameEngine->addFireball(fb);
             gameEngine->stats.nbSpellStandard++;
           } else {
             if (feat->attack.flags & WEAPON_PROJECTILE) {
@@ -1404,32 +1278,23 @@ bool Item::update(float elapsed, TCOD_key_t key, TCOD_mouse_t* mouse) {
         // warm up adjacent items
         heat_timer_ = 0.0f;
         float radius = feat->heat.radius;
-        for (int tx = -(int)floor(radius); tx <= (int)ceil(radius); tx++) {
-          if ((int)(x) + tx >= 0 && (int)(x) + tx < dungeon->width) {
-            int dy = (int)(sqrtf(radius * radius - tx * tx));
-            for (int ty = -dy; ty <= dy; ty++) {
-              if ((int)(y) + ty >= 0 && (int)(y) + ty < dungeon->height) {
-                auto* items = dungeon->getItems((int)(x) + tx, (int)(y) + ty);
-                for (Item* it : *items) {
-                  // found an adjacent item
-                  ItemFeature* fireFeat = it->getFeature(ITEM_FEAT_FIRE_EFFECT);
-                  if (fireFeat) {
-                    // item is affected by fire
-                    it->fire_resistance_ -= feat->heat.intensity;
-                  }
-                }
-                mob::Creature* cr = dungeon->getCreature((int)(x) + tx, (int)(y) + ty);
-                if (cr) {
-                  cr->takeDamage(feat->heat.intensity);
-                  cr->burn = true;
-                }
-                if (gameEngine->player.x == x + tx && gameEngine->player.y == y + ty) {
-                  gameEngine->player.takeDamage(feat->heat.intensity);
-                }
-              }
-            }
+        float intensity = feat->heat.intensity;
+        dungeon->forEachItemInRadius((int)x, (int)y, radius, [intensity](Item* it) {
+          // found an adjacent item
+          ItemFeature* fireFeat = it->getFeature(ITEM_FEAT_FIRE_EFFECT);
+          if (fireFeat) {
+            // item is affected by fire
+            it->fire_resistance_ -= intensity;
           }
-        }
+        });
+        dungeon->forEachCreatureInRadius((int)x, (int)y, radius, [intensity](mob::Creature* cr) {
+          cr->takeDamage(intensity);
+          cr->burn = true;
+        });
+        // the player is not in the dungeon creatures
+        int pdx = (int)gameEngine->player.x - (int)x;
+        int pdy = (int)gameEngine->player.y - (int)y;
+        if (pdx * pdx + pdy * pdy <= radius * radius) gameEngine->player.takeDamage(intensity);
       }
     } else if (feat->id == ITEM_FEAT_FIRE_EFFECT && fire_resistance_ <= 0.0f) {
       if (feat->fireEffect.type) {
@@ -1603,65 +1468,6 @@ void Item::addModifier(modifier::ItemModifierId id, float value) {
   modifiers_.push(new modifier::ItemModifier(id, value));
 }
 
-void Item::renderDescriptionFrame(int x, int y, bool below, bool frame) {
-  int cx = 0, cy = 0, cw = CON_W / 2, ch = CON_H / 2;
-  bool stop = false;
-
-  // find the right border
-  for (cw = CON_W / 2; cw > cx && !stop; cw--) {
-    for (int ty = 0; ty < ch; ty++) {
-      if (descCon->getChar(cx + cw - 1, ty) != ' ') {
-        stop = true;
-        break;
-      }
-    }
-  }
-  // find the left border
-  stop = false;
-  for (cx = 0; cx < CON_W / 2 && !stop; cx++, cw--) {
-    for (int ty = 0; ty < ch; ty++) {
-      if (descCon->getChar(cx, ty) != ' ') {
-        stop = true;
-        break;
-      }
-    }
-  }
-  // find the bottom border
-  stop = false;
-  for (ch = CON_H / 2; ch > 0 && !stop; ch--) {
-    for (int tx = cx; tx < cx + cw; tx++) {
-      if (descCon->getChar(tx, cy + ch - 1) != ' ') {
-        stop = true;
-        break;
-      }
-    }
-  }
-  cx -= 2;
-  cw += 4;
-  ch += 2;
-  if (frame) {
-    // drawn the frame
-    descCon->setDefaultForeground(ui::guiText);
-    descCon->putChar(cx, cy, TCOD_CHAR_NW, TCOD_BKGND_NONE);
-    descCon->putChar(cx + cw - 1, cy, TCOD_CHAR_NE, TCOD_BKGND_NONE);
-    descCon->putChar(cx, cy + ch - 1, TCOD_CHAR_SW, TCOD_BKGND_NONE);
-    descCon->putChar(cx + cw - 1, cy + ch - 1, TCOD_CHAR_SE, TCOD_BKGND_NONE);
-    for (int tx = cx + 1; tx < cx + cw - 1; tx++) {
-      if (descCon->getChar(tx, cy) == ' ') descCon->setChar(tx, cy, TCOD_CHAR_HLINE);
-    }
-    descCon->hline(cx + 1, cy + ch - 1, cw - 2, TCOD_BKGND_NONE);
-    descCon->vline(cx, cy + 1, ch - 2, TCOD_BKGND_NONE);
-    descCon->vline(cx + cw - 1, cy + 1, ch - 2, TCOD_BKGND_NONE);
-  }
-  if (!below) y = y - ch + 1;
-  if (x - cw / 2 < 0)
-    x = cw / 2;
-  else if (x + cw / 2 > CON_W)
-    x = CON_W - cw / 2;
-  if (y + ch > CON_H) y = CON_H - ch;
-  TCODConsole::blit(descCon, cx, cy, cw, ch, TCODConsole::root, x - cw / 2, y, 1.0f, frame ? 0.7f : 0.0f);
-}
-
 static auto GetCountedName(const Item& item) -> std::string {
   const int count = item.count_ > 1 ? item.count_ : item.stack_.size() + 1;
   const auto& nameToUse = item.name_.value_or(item.typeName_);
@@ -53,6 +53,9 @@ enum ItemClass {
   ITEM_CLASS_GOLD,
   NB_ITEM_CLASSES
 };
+// cast and reload delay reduction per item class
+#define MAX_RELOAD_BONUS 0.2f
+#define MAX_CAST_BONUS 0.2f
 
 enum ItemFlags {
   ITEM_NOT_WALKABLE = 1,
@@ -239,7 +242,7 @@ struct ItemType {
   bool hasComponents() const;
   ItemCombination* getCombination() const;
   void computeActions();
-  Item* produce(float rng) const;  // for items with Produce feature(s)
+  Item* produce(float roll, TCODRandom* rng = NULL) const;  // for items with Produce feature(s)
 
   bool isIngredient() const;  // in any recipe
   bool isTool() const;  // in any recipeW
@@ -257,10 +260,11 @@ struct ItemType {
 
 class Item : public base::DynamicEntity {
  public:
-  // factories
-  static Item* getItem(const char* type, float x, float y, bool createComponents = true);
-  static Item* getItem(const ItemType* type, float x, float y, bool createComponents = true);
-  static Item* getRandomWeapon(const char* type, ItemClass itemClass);
+  // factories. the map generators pass their context rng, the game uses the global one
+  static Item* getItem(const char* type, float x, float y, bool createComponents = true, TCODRandom* rng = NULL);
+  static Item* getItem(
+      const ItemType* type, float x, float y, bool createComponents = true, TCODRandom* rng = NULL);
+  static Item* getRandomWeapon(const char* type, ItemClass itemClass, TCODRandom* rng = NULL);
 
   static bool initDatabase();
   static ItemType* getType(const char* name);
@@ -307,7 +311,7 @@ class Item : public base::DynamicEntity {
   // craft
   bool isIngredient() const { return typeData->isIngredient(); }  // in any recipe
   bool isTool() const { return typeData->isTool(); }  // in any recipe
-  Item* produce(float rng) { return typeData->produce(rng); }  // for items with Produce feature(s)
+  Item* produce(float roll) { return typeData->produce(roll); }  // for items with Produce feature(s)
 
   // containers
   Item* putInContainer(Item* it);  // put this in 'it' container (NULL if no more room)
@@ -361,7 +365,7 @@ class Item : public base::DynamicEntity {
   friend class ItemFileListener;
   static void addFeature(const char* typeName, ItemFeature* feat);
   static TCODList<ItemType*> types;
-  Item(float x, float y, const ItemType& type);
+  Item(float x, float y, const ItemType& type, TCODRandom* rng);
   bool active_{};
   float life_{};  // remaining time before aging effect turn this item into something else
   // attack feature data
@@ -376,11 +380,12 @@ class Item : public base::DynamicEntity {
   bool toggle_{};  // for doors, torchs, ... on = open/turned on, off = closed/turned off
 
   map::ExtendedLight* light_{};
-  static TCODConsole* descCon;  // offscreen console for item description
+  static TCODConsole* descCon;  // offscreen console for item description. created by the first rendering
 
   void initLight();
   void convertTo(ItemType* type);
   void renderDescriptionFrame(int x, int y, bool below = true, bool frame = true);
-  void generateComponents();
+  static void initDescriptionConsole();
+  void generateComponents(TCODRandom* rng);
 };
 }  // namespace item
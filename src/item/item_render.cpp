@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "item/item.hpp"
+
+#include "constants.hpp"
+#include "main.hpp"
+#include "ui/inventory.hpp"
+
+// console drawing of the items and their descriptions. the simulation side lives in item.cpp
+namespace item {
+void Item::render(map::LightMap& lightMap, TCODImage* ground) {
+  int conx = (int)(x - gameEngine->xOffset);
+  int cony = (int)(y - gameEngine->yOffset);
+  if (!IN_RECTANGLE(conx, cony, CON_W, CON_H)) return;
+  map::Dungeon* dungeon = gameEngine->dungeon;
+  map::HDRColor lightColor = lightMap.getHdrColor(conx, cony);
+  float shadow = dungeon->getShadow(x * 2, y * 2);
+  float clouds = dungeon->getCloudCoef(x * 2, y * 2);
+  shadow = MIN(shadow, clouds);
+  lightColor = lightColor * shadow;
+  TCODConsole::root->setChar(conx, cony, ch_);
+  TCODConsole::root->setCharForeground(conx, cony, map::HDRColor(color_) * lightColor);
+  if (ground) {
+    TCODConsole::root->setCharBackground(conx, cony, ground->getPixel(conx * 2, cony * 2));
+  } else {
+    TCODConsole::root->setCharBackground(conx, cony, dungeon->getShadedGroundColor(getSubX(), getSubY()));
+  }
+}
+
+void Item::initDescriptionConsole() {
+  if (descCon) return;
+  descCon = new TCODConsole(CON_W / 2, CON_H / 2);
+  descCon->setAlignment(TCOD_CENTER);
+  descCon->setDefaultBackground(ui::guiBackground);
+}
+
+void Item::renderDescription(int x, int y, bool below) {
+  int cy = 0;
+  initDescriptionConsole();
+  descCon->clear();
+  descCon->setDefaultForeground(Item::classColor[item_class_]);
+  if (name_) {
+    if (count_ > 1)
+      descCon->print(CON_W / 4, cy++, "%s(%d)", name_->c_str(), count_);
+    else
+      descCon->print(CON_W / 4, cy++, name_->c_str());
+    descCon->setDefaultForeground(ui::guiText);
+    descCon->print(CON_W / 4, cy++, typeName_.c_str());
+  } else {
+    if (count_ > 1)
+      descCon->print(CON_W / 4, cy++, "%s(%d)", typeName_.c_str(), count_);
+    else
+      descCon->print(CON_W / 4, cy++, typeName_.c_str());
+  }
+  descCon->setDefaultForeground(ui::guiText);
+  ItemFeature* feat = getFeature(ITEM_FEAT_FOOD);
+  if (feat) descCon->print(CON_W / 4, cy++, "Health:+%d", feat->food.health);
+  feat = getFeature(ITEM_FEAT_ATTACK);
+  if (feat) {
+    static const char* wieldname[] = {NULL, "One hand", "Main hand", "Off hand", "Two hands"};
+    if (feat->attack.wield) {
+      descCon->print(CON_W / 4, cy++, wieldname[feat->attack.wield]);
+    }
+    float rate = 1.0f / (cast_delay_ + reload_delay_);
+    int dmgPerSec = (int)(damages_ * rate + 0.5f);
+    descCon->print(CON_W / 4, cy++, "%d damages/sec", dmgPerSec);
+    descCon->print(CON_W / 4, cy++, "Attack rate:%s", getRateName(rate));
+    modifier::ItemModifier::renderDescription(descCon, 2, cy, modifiers_);
+  }
+
+  /*
+          y--;
+          if ( y < 0 ) y = 2;
+          TCODConsole::root->setDefaultForeground(Item::classColor[itemClass]);
+          TCODConsole::root->printEx(x,y,TCOD_BKGND_NONE,TCOD_CENTER,typeName);
+  */
+  renderDescriptionFrame(x, y, below);
+}
+
+void Item::renderGenericDescription(int x, int y, bool below, bool frame) {
+  int cy = 0;
+  initDescriptionConsole();
+  descCon->clear();
+  descCon->setDefaultForeground(Item::classColor[item_class_]);
+  if (name_) {
+    if (count_ > 1)
+      descCon->print(CON_W / 4, cy++, "%s(%d)", name_->c_str(), count_);
+    else
+      descCon->print(CON_W / 4, cy++, name_->c_str());
+    descCon->setDefaultForeground(ui::guiText);
+    descCon->print(CON_W / 4, cy++, typeName_.c_str());
+  } else {
+    if (count_ > 1)
+      descCon->print(CON_W / 4, cy++, "%s(%d)", typeName_.c_str(), count_);
+    else
+      descCon->print(CON_W / 4, cy++, typeName_.c_str());
+  }
+  descCon->setDefaultForeground(ui::guiText);
+  ItemFeature* feat = getFeature(ITEM_FEAT_FOOD);
+  if (feat) descCon->print(CON_W / 4, cy++, "Health:+%d", feat->food.health);
+  feat = getFeature(ITEM_FEAT_ATTACK);
+  if (feat) {
+    static const char* wieldname[] = {NULL, "One hand", "Main hand", "Off hand", "Two hands"};
+    if (feat->attack.wield) {
+      descCon->print(CON_W / 4, cy++, wieldname[feat->attack.wield]);
+    }
+    float minCast = feat->attack.minCastDelay - item_class_ * MAX_CAST_BONUS;
+    float minReload = feat->attack.minReloadDelay - item_class_ * MAX_RELOAD_BONUS;
+    float minDamages = 15 * (minCast + minReload) * feat->attack.minDamagesCoef;
+    float maxDamages = 15 * (feat->attack.maxCastDelay + feat->attack.maxReloadDelay) * feat->attack.maxDamagesCoef;
+    minDamages += minDamages * (int)(item_class_)*0.2f;
+    maxDamages += maxDamages * (int)(item_class_)*0.2f;
+    minDamages = (int)MIN(1.0f, minDamages);
+    maxDamages = (int)MIN(1.0f, maxDamages);
+
+    if (minDamages != maxDamages) {
+      descCon->print(CON_W / 4, cy++, "%d-%d damages/hit", (int)minDamages, (int)maxDamages);
+    } else {
+      descCon->print(CON_W / 4, cy++, "%d damages/hit", (int)minDamages);
+    }
+
+    float minRate = 1.0f / (feat->attack.maxCastDelay + feat->attack.maxReloadDelay);
+    float maxRate = 1.0f / (minCast + minReload);
+
+    const char* rate1 = getRateName(minRate);
+    const char* rate2 = getRateName(maxRate);
+    if (rate1 == rate2) {
+      descCon->print(CON_W / 4, cy++, "Attack rate:%s", rate1);
+    } else {
+      descCon->print(CON_W / 4, cy++, "Attack rate:%s-%s", rate1, rate2);
+    }
+    // ItemModifier::renderDescription(descCon,2,cy,modifiers);
+  }
+
+  renderDescriptionFrame(x, y, below, frame);
+}
+
+void Item::renderDescriptionFrame(int x, int y, bool below, bool frame) {
+  int cx = 0, cy = 0, cw = CON_W / 2, ch = CON_H / 2;
+  bool stop = false;
+
+  // find the right border
+  for (cw = CON_W / 2; cw > cx && !stop; cw--) {
+    for (int ty = 0; ty < ch; ty++) {
+      if (descCon->getChar(cx + cw - 1, ty) != ' ') {
+        stop = true;
+        break;
+      }
+    }
+  }
+  // find the left border
+  stop = false;
+  for (cx = 0; cx < CON_W / 2 && !stop; cx++, cw--) {
+    for (int ty = 0; ty < ch; ty++) {
+      if (descCon->getChar(cx, ty) != ' ') {
+        stop = true;
+        break;
+      }
+    }
+  }
+  // find the bottom border
+  stop = false;
+  for (ch = CON_H / 2; ch > 0 && !stop; ch--) {
+    for (int tx = cx; tx < cx + cw; tx++) {
+      if (descCon->getChar(tx, cy + ch - 1) != ' ') {
+        stop = true;
+        break;
+      }
+    }
+  }
+  cx -= 2;
+  cw += 4;
+  ch += 2;
+  if (frame) {
+    // drawn the frame
+    descCon->setDefaultForeground(ui::guiText);
+    descCon->putChar(cx, cy, TCOD_CHAR_NW, TCOD_BKGND_NONE);
+    descCon->putChar(cx + cw - 1, cy, TCOD_CHAR_NE, TCOD_BKGND_NONE);
+    descCon->putChar(cx, cy + ch - 1, TCOD_CHAR_SW, TCOD_BKGND_NONE);
+    descCon->putChar(cx + cw - 1, cy + ch - 1, TCOD_CHAR_SE, TCOD_BKGND_NONE);
+    for (int tx = cx + 1; tx < cx + cw - 1; tx++) {
+      if (descCon->getChar(tx, cy) == ' ') descCon->setChar(tx, cy, TCOD_CHAR_HLINE);
+    }
+    descCon->hline(cx + 1, cy + ch - 1, cw - 2, TCOD_BKGND_NONE);
+    descCon->vline(cx, cy + 1, ch - 2, TCOD_BKGND_NONE);
+    descCon->vline(cx + cw - 1, cy + 1, ch - 2, TCOD_BKGND_NONE);
+  }
+  if (!below) y = y - ch + 1;
+  if (x - cw / 2 < 0)
+    x = cw / 2;
+  else if (x + cw / 2 > CON_W)
+    x = CON_W - cw / 2;
+  if (y + ch > CON_H) y = CON_H - ch;
+  TCODConsole::blit(descCon, cx, cy, cw, ch, TCODConsole::root, x - cw / 2, y, 1.0f, frame ? 0.7f : 0.0f);
+}
+}  // namespace item
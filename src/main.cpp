@@ -25,34 +25,21 @@
  */
 #include "main.hpp"
 
+#include <float.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include "base/headless.hpp"
+#include "base/inputlog.hpp"
 #include "screen/end.hpp"
 #include "screen/forest.hpp"
 #include "screen/game.hpp"
 #include "screen/mainmenu.hpp"
 #include "screen/treeBurner.hpp"
 #include "util/powerup.hpp"
-
-TCODNoise noise1d(1);
-TCODNoise noise2d(2);
-TCODNoise noise3d(3);
-TCODRandom* rng = nullptr;
-bool mouseControl = false;
-bool newGame = false;
-base::SaveGame saveGame;
-base::UserPref userPref;
-UmbraEngine engine("./data/cfg/umbra.txt", UMBRA_REGISTER_ALL);
-TCODImage background("./data/img/background.png");
-TCODParser config;
-util::Sound sound;
-util::ThreadPool* threadPool = nullptr;
-
-map::HDRColor getHDRColorProperty(const TCODParser& parser, const char* name) {
-  TCODList<float> l(parser.getListProperty(name, TCOD_TYPE_FLOAT));
-  return map::HDRColor(l.get(0), l.get(1), l.get(2));
-}
+#include "util/profiler.hpp"
 
 class ModuleFactory : public UmbraModuleFactory {
  public:
@@ -191,12 +178,79 @@ class ModuleFactory : public UmbraModuleFactory {
   }
 };
 
+// simulation without window nor rendering. see config.headless
+static int runHeadless(const char* moduleName, float timestep, float duration, const char* inputFile) {
+  // the modules still draw in the root console when they are activated. give them an offscreen one
+  TCODConsole::root = new TCODConsole(CON_W, CON_H);
+  base::ScriptedInput scriptedInput;
+  base::InputSource* input = NULL;
+  if (inputFile) {
+    if (!scriptedInput.load(inputFile)) {
+      printf("FATAL : cannot open input script %s\n", inputFile);
+      return 1;
+    }
+    input = &scriptedInput;
+  }
+  base::HeadlessRunner runner(timestep, duration);
+  return runner.run(moduleName, input) ? 0 : 1;
+}
+
+// dump the last profiled frames
+static void saveTrace(const char* traceFile) {
+  if (traceFile && !util::Profiler::getInstance()->exportChromeTrace(traceFile)) {
+    printf("WARNING : cannot write %s\n", traceFile);
+  }
+}
+
 int main(int argc, char* argv[]) {
   // read main configuration file
   config.run("data/cfg/config.txt", NULL);
   mob::ConditionType::init();
   util::TextGenerator::setGlobalFunction("NUMBER_TO_LETTER", new util::NumberToLetterFunc());
 
+  // command line
+  // --headless <module> [--duration s] [--timestep s] [--input script] : see config.headless
+  // --record <log> / --replay <log> : record the session input or replay it. --frametimes <csv> : frame durations
+  // --seed <n> : seed for a new game
+  // --trace <json> : profiler trace of the last frames, written on exit (chrome://tracing format)
+  const char* headlessModule = NULL;
+  const char* inputFile = NULL;
+  float timestep = config.getFloatProperty("config.headless.timestep");
+  float duration = config.getFloatProperty("config.headless.duration");
+  const char* seedArg = NULL;
+  const char* recordFile = NULL;
+  const char* replayFile = NULL;
+  const char* frameTimeFile = NULL;
+  const char* traceFile = NULL;
+  bool hasDuration = false;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--headless") == 0 && hasValue) {
+      headlessModule = argv[++i];
+    } else if (strcmp(argv[i], "--duration") == 0 && hasValue) {
+      duration = (float)atof(argv[++i]);
+      hasDuration = true;
+    } else if (strcmp(argv[i], "--timestep") == 0 && hasValue) {
+      timestep = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "--input") == 0 && hasValue) {
+      inputFile = argv[++i];
+    } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+      seedArg = argv[++i];
+    } else if (strcmp(argv[i], "--record") == 0 && hasValue) {
+      recordFile = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+      replayFile = argv[++i];
+    } else if (strcmp(argv[i], "--frametimes") == 0 && hasValue) {
+      frameTimeFile = argv[++i];
+    } else if (strcmp(argv[i], "--trace") == 0 && hasValue) {
+      traceFile = argv[++i];
+    } else if (argc == 2 && config.getBoolProperty("config.debug")) {
+      // use a user-defined seed for RNG
+      seedArg = argv[i];
+    }
+  }
+  headless = headlessModule != NULL;
+
   // load user preferences (mouse control mode, ...)
   userPref.load();
   util::Powerup::init();
@@ -204,15 +258,27 @@ int main(int argc, char* argv[]) {
   threadPool = new util::ThreadPool();
 
   // initialise random number generator
-  if (!saveGame.load(base::PHASE_INIT)) {
+  bool reproducible = headless || recordFile || replayFile;
+  if (reproducible || !saveGame.load(base::PHASE_INIT)) {
+    // headless, recorded and replayed runs always start a new game so that they only depend on the seed
     newGame = true;
     saveGame.init();
-    if (config.getBoolProperty("config.debug") && argc == 2) {
-      // use a user-defined seed for RNG
-      saveGame.seed = (uint32_t)atoi(argv[1]);
+    if (seedArg) saveGame.seed = (uint32_t)atoi(seedArg);
+  }
+  if (replayFile) {
+    if (!inputLog.startReplay(replayFile, &saveGame.seed)) {
+      delete threadPool;
+      return 1;
     }
+    // the replay decides when to stop
+    if (!hasDuration) duration = FLT_MAX;
+  } else if (recordFile) {
+    inputLog.startRecord(recordFile, saveGame.seed);
+  }
+  if (frameTimeFile && !inputLog.setFrameTimeFile(frameTimeFile)) {
+    printf("WARNING : cannot open %s\n", frameTimeFile);
   }
-  if (config.getBoolProperty("config.debug")) {
+  if (config.getBoolProperty("config.debug") || headless) {
     printf("Random seed : %d\n", saveGame.seed);
   }
   userPref.nbLaunches++;
@@ -220,13 +286,25 @@ int main(int argc, char* argv[]) {
 
   engine.loadModuleConfiguration("data/cfg/modules.cfg", new ModuleFactory());
 
+  if (headless) {
+    int ret = runHeadless(headlessModule, timestep, duration, inputFile);
+    inputLog.finish();
+    saveTrace(traceFile);
+    delete threadPool;
+    return ret;
+  }
+
   sound.initialize();
   if (engine.initialise(TCOD_RENDERER_SDL2)) {
     engine.run();
+    inputLog.finish();
+    saveTrace(traceFile);
     // saveGame.save();
     userPref.save();
+    delete threadPool;
     return 0;
   }
 
+  delete threadPool;
   return 1;
 }
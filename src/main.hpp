@@ -29,6 +29,7 @@
 #include <umbra/umbra.hpp>
 
 #include "base/gameengine.hpp"
+#include "base/inputlog.hpp"
 #include "base/savegame.hpp"
 #include "base/userpref.hpp"
 #include "map/cell.hpp"
@@ -71,9 +72,11 @@ extern TCODNoise noise2d;
 extern TCODNoise noise3d;
 extern TCODRandom* rng;
 extern bool mouseControl;
+extern bool headless;  // no window, no rendering. see base::HeadlessRunner
 extern bool newGame;
 extern base::SaveGame saveGame;
 extern base::UserPref userPref;
+extern base::InputLog inputLog;
 extern UmbraEngine engine;
 extern base::GameEngine* gameEngine;
 extern TCODImage background;
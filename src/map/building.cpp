@@ -205,7 +205,7 @@ void Building::buildExternalWalls() {
   }
 }
 
-bool Building::getFreeFloor(int* fx, int* fy) {
+bool Building::getFreeFloor(TCODRandom* rng, int* fx, int* fy) {
   int ffx = rng->getInt(0, w - 1);
   int ffy = rng->getInt(0, h - 1);
   int count = w * h;
@@ -224,7 +224,7 @@ bool Building::getFreeFloor(int* fx, int* fy) {
   return true;
 }
 
-void Building::setHuntingHide(map::Dungeon* dungeon) {
+void Building::setHuntingHide(map::Dungeon* dungeon, TCODRandom* rng) {
   int ix, iy;
   /*
   if (getFreeFloor(&ix,&iy)) {
@@ -233,34 +233,34 @@ void Building::setHuntingHide(map::Dungeon* dungeon) {
           map[ix+iy*w] = BUILDING_ITEM;
   }
   */
-  if (getFreeFloor(&ix, &iy)) {
-    item::Item* chest = item::Item::getItem("chest", x + ix, y + iy);
+  if (getFreeFloor(rng, &ix, &iy)) {
+    item::Item* chest = item::Item::getItem("chest", x + ix, y + iy, true, rng);
     dungeon->addItem(chest);
     map[ix + iy * w] = BUILDING_ITEM;
     // fill the chest
 
-    item::Item* item = item::Item::getItem("short bronze blade", 0, 0);
+    item::Item* item = item::Item::getItem("short bronze blade", 0, 0, true, rng);
     // Item *knife=Item::getRandomWeapon(ITEM_KNIFE,ITEM_CLASS_STANDARD);
     // knife->name = "hunting knife";
     item->name_ = "knife blade";
     item->adjective_ = "hunting";
     item->putInContainer(chest);
 
-    item = item::Item::getItem("bottle", 0, 0);
+    item = item::Item::getItem("bottle", 0, 0, true, rng);
     item->putInContainer(chest);
     item->name_ = "empty bottle";
     item->an_ = true;
 
-    item = item::Item::getItem("linen thread", 0, 0);
+    item = item::Item::getItem("linen thread", 0, 0, true, rng);
     item->count_ = 2;
     item->putInContainer(chest);
 
-    item = item::Item::getItem("bone hook", 0, 0);
+    item = item::Item::getItem("bone hook", 0, 0, true, rng);
     item->putInContainer(chest);
   }
 }
 
-void Building::applyTo(map::Dungeon* dungeon, int dungeonDoorx, int dungeonDoory, bool cityWalls) {
+void Building::applyTo(map::Dungeon* dungeon, int dungeonDoorx, int dungeonDoory, bool cityWalls, TCODRandom* rng) {
   static TCODColor roofcol = TCODColor::darkOrange;
   x = dungeonDoorx - doorx;
   y = dungeonDoory - doory;
@@ -291,7 +291,7 @@ void Building::applyTo(map::Dungeon* dungeon, int dungeonDoorx, int dungeonDoory
               TCOD_CHAR_NE,
               TCOD_CHAR_SE,
               TCOD_CHAR_SW};
-          item::Item* wall = item::Item::getItem(cityWalls ? "city wall" : "wall", x + cx, y + cy);
+          item::Item* wall = item::Item::getItem(cityWalls ? "city wall" : "wall", x + cx, y + cy, true, rng);
           wall->ch_ = wallToChar[cellType];
           dungeon->addItem(wall);
         }
@@ -319,13 +319,13 @@ void Building::applyTo(map::Dungeon* dungeon, int dungeonDoorx, int dungeonDoory
             dungeon->canopy->putPixel(d2x, d2y, cx * 2 + subcx[i] < w ? roofcol * 0.7f : roofcol);
           }
           if (cellType == BUILDING_DOOR) {
-            dungeon->addItem(item::Item::getItem("door", x + cx, y + cy));
+            dungeon->addItem(item::Item::getItem("door", x + cx, y + cy, true, rng));
           } else if (cellType == BUILDING_WINDOW_H) {
-            item::Item* item = item::Item::getItem(cityWalls ? "arrow slit" : "window", x + cx, y + cy);
+            item::Item* item = item::Item::getItem(cityWalls ? "arrow slit" : "window", x + cx, y + cy, true, rng);
             item->ch_ = TCOD_CHAR_HLINE;
             dungeon->addItem(item);
           } else if (cellType == BUILDING_WINDOW_V) {
-            item::Item* item = item::Item::getItem(cityWalls ? "arrow slit" : "window", x + cx, y + cy);
+            item::Item* item = item::Item::getItem(cityWalls ? "arrow slit" : "window", x + cx, y + cy, true, rng);
             item->ch_ = TCOD_CHAR_VLINE;
             dungeon->addItem(item);
           }
@@ -55,8 +55,10 @@ class Building : public base::Rect {
 
   static Building* generate(int width, int height, int nbRooms, TCODRandom* rng);
   static Building* generateWallsOnly(int width, int height, int nbRooms, TCODRandom* rng);
-  void applyTo(map::Dungeon* dungeon, int dungeonDoorx, int dungeonDoory, bool cityWalls = false);
-  void setHuntingHide(map::Dungeon* dungeon);
+  // rng : for the items. the global one if NULL
+  void applyTo(
+      map::Dungeon* dungeon, int dungeonDoorx, int dungeonDoory, bool cityWalls = false, TCODRandom* rng = NULL);
+  void setHuntingHide(map::Dungeon* dungeon, TCODRandom* rng);
   static void buildCityWalls(int x, map::Dungeon* dungeon);
   void collapseRoof();
 
@@ -65,7 +67,7 @@ class Building : public base::Rect {
   void buildExternalWalls();
   void placeRandomDoor(TCODRandom* rng);
   void placeRandomWindow(TCODRandom* rng);
-  bool getFreeFloor(int* fx, int* fy);
+  bool getFreeFloor(TCODRandom* rng, int* fx, int* fy);
   static void setBuildingWallCell(int x, int y, int ysym, int ch, map::Dungeon* dungeon);
 };
 }  // namespace map
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "map/distancetransform.hpp"
+
+#include <float.h>
+#include <limits.h>
+
+#include "util/parallel.hpp"
+#include "util/profiler.hpp"
+
+namespace map {
+void DistanceTransform::compute(const TCODMap* map) {
+  PROFILE_SCOPE("distanceTransform");
+  width = map->getWidth();
+  height = map->getHeight();
+  nearest.assign(width * height, NONE);
+  // first pass : y of the closest walkable cell in the same column
+  std::vector<int> columnNearest(width * height, NONE);
+  util::parallelFor(width, [&](int x) {
+    int last = NONE;
+    for (int y = 0; y < height; y++) {
+      if (map->isWalkable(x, y)) last = y;
+      columnNearest[x + y * width] = last;
+    }
+    last = NONE;
+    for (int y = height - 1; y >= 0; y--) {
+      if (map->isWalkable(x, y)) last = y;
+      int& cur = columnNearest[x + y * width];
+      if (last != NONE && (cur == NONE || last - y < y - cur)) cur = last;
+    }
+  });
+  // second pass : along each row, the column x' minimizing (x - x')^2 + dy(x')^2.
+  // lower envelope of the parabolas rooted on the columns which have a walkable cell
+  util::parallelFor(height, [&](int y) {
+    std::vector<int> roots(width);  // columns of the parabolas of the envelope
+    std::vector<double> bounds(width + 1);  // parabola k is the lowest between bounds[k] and bounds[k + 1]
+    auto f = [&](int x) {
+      int dy = columnNearest[x + y * width] - y;
+      return (double)(dy * dy);
+    };
+    int k = -1;
+    for (int q = 0; q < width; q++) {
+      if (columnNearest[q + y * width] == NONE) continue;
+      if (k < 0) {
+        k = 0;
+        roots[0] = q;
+        bounds[0] = -DBL_MAX;
+        bounds[1] = DBL_MAX;
+        continue;
+      }
+      double s;
+      while (true) {
+        int p = roots[k];
+        // intersection of the parabolas of p and q
+        s = ((f(q) + q * q) - (f(p) + p * p)) / (2.0 * (q - p));
+        if (s > bounds[k]) break;
+        k--;
+      }
+      k++;
+      roots[k] = q;
+      bounds[k] = s;
+      bounds[k + 1] = DBL_MAX;
+    }
+    if (k < 0) return;  // no walkable cell in any column
+    k = 0;
+    for (int x = 0; x < width; x++) {
+      while (bounds[k + 1] < x) k++;
+      int root = roots[k];
+      nearest[x + y * width] = root + columnNearest[root + y * width] * width;
+    }
+  });
+}
+
+int DistanceTransform::search(const TCODMap* map, int x, int y) const {
+  int best = NONE;
+  int bestDist = INT_MAX;
+  int maxRadius = MAX(MAX(x, width - 1 - x), MAX(y, height - 1 - y));
+  // the cells at radius r are at least r away
+  for (int r = 0; r <= maxRadius && r * r < bestDist; r++) {
+    auto check = [&](int cx, int cy) {
+      if (cx < 0 || cy < 0 || cx >= width || cy >= height || !map->isWalkable(cx, cy)) return;
+      int dist = (cx - x) * (cx - x) + (cy - y) * (cy - y);
+      if (dist < bestDist) {
+        bestDist = dist;
+        best = cx + cy * width;
+      }
+    };
+    for (int dx = -r; dx <= r; dx++) {
+      check(x + dx, y - r);
+      if (r > 0) check(x + dx, y + r);
+    }
+    for (int dy = -r + 1; dy <= r - 1; dy++) {
+      check(x - r, y + dy);
+      check(x + r, y + dy);
+    }
+  }
+  return best;
+}
+
+void DistanceTransform::update(const TCODMap* map, int x, int y) {
+  static const int dirx[] = {-1, 0, 1, -1, 1, -1, 0, 1};
+  static const int diry[] = {-1, -1, -1, 0, 0, 1, 1, 1};
+  int cell = x + y * width;
+  std::vector<int> todo;
+  if (map->isWalkable(x, y)) {
+    // the new walkable cell becomes the closest one of the cells around it which are closer to it than to theirs
+    nearest[cell] = cell;
+    todo.push_back(cell);
+    while (!todo.empty()) {
+      int cur = todo.back();
+      todo.pop_back();
+      for (int i = 0; i < 8; i++) {
+        int nx = cur % width + dirx[i];
+        int ny = cur / width + diry[i];
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+        int& n = nearest[nx + ny * width];
+        if (n == cell) continue;
+        if (n == NONE || squaredDistance(nx + ny * width, cell) < squaredDistance(nx + ny * width, n)) {
+          n = cell;
+          todo.push_back(nx + ny * width);
+        }
+      }
+    }
+    return;
+  }
+  // the cells whose closest walkable cell was this one need another one
+  std::vector<int> region;
+  if (nearest[cell] == cell) {
+    nearest[cell] = NONE;
+    todo.push_back(cell);
+  }
+  while (!todo.empty()) {
+    int cur = todo.back();
+    todo.pop_back();
+    region.push_back(cur);
+    for (int i = 0; i < 8; i++) {
+      int nx = cur % width + dirx[i];
+      int ny = cur / width + diry[i];
+      if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+      int& n = nearest[nx + ny * width];
+      if (n == cell) {
+        n = NONE;
+        todo.push_back(nx + ny * width);
+      }
+    }
+  }
+  if ((int)region.size() > width * height / 16) {
+    // most of the map. faster to start over
+    compute(map);
+    return;
+  }
+  for (int cur : region) nearest[cur] = search(map, cur % width, cur / width);
+}
+}  // namespace map
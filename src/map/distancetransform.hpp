@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <libtcod.hpp>
+#include <vector>
+
+namespace map {
+// closest walkable cell (euclidean distance) of every cell of a map
+class DistanceTransform {
+ public:
+  static constexpr int NONE = -1;
+
+  // exact two pass transform of the whole map (Felzenszwalb & Huttenlocher) : closest walkable cell in the column,
+  // then lower envelope of the column distances along each row
+  void compute(const TCODMap* map);
+  bool isValid() const { return !nearest.empty(); }
+  // closest walkable cell of x,y. false if the map has none
+  inline bool getNearest(int x, int y, int* nx, int* ny) const {
+    int cell = nearest[x + y * width];
+    if (cell == NONE) return false;
+    *nx = cell % width;
+    *ny = cell / width;
+    return true;
+  }
+  // the walkability of x,y changed. repair the cells around it
+  void update(const TCODMap* map, int x, int y);
+
+ protected:
+  int width = 0, height = 0;
+  std::vector<int> nearest;  // x + y * width of the closest walkable cell, NONE if there is none
+
+  inline int squaredDistance(int cell1, int cell2) const {
+    int dx = cell1 % width - cell2 % width;
+    int dy = cell1 / width - cell2 / width;
+    return dx * dx + dy * dy;
+  }
+  // exact search of the closest walkable cell of x,y in growing squares
+  int search(const TCODMap* map, int x, int y) const;
+};
+}  // namespace map
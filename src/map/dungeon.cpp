@@ -30,21 +30,32 @@
 #include <math.h>
 #include <stdio.h>
 
+#include <atomic>
+
 #include "helpers.hpp"
 #include "main.hpp"
 #include "mob/player.hpp"
+#include "util/parallel.hpp"
+#include "util/profiler.hpp"
 
 namespace map {
-Dungeon::Dungeon(int width, int height) : level(0), ambient(TCODColor::black) {
+// maps are generated on worker threads too
+static std::atomic<int> nextSerial{0};
+
+Dungeon::Dungeon(int width, int height, util::GenerationContext* context) : level(0), ambient(TCODColor::black) {
   this->width = width;
   this->height = height;
-  initData(NULL);
-  clouds = new util::CloudBox(width * 2, height * 2);
+  initData(NULL, context);
+  clouds = new util::CloudBox(width * 2, height * 2, context);
   canopy = new TCODImage(width * 2, height * 2);
 }
 
 void Dungeon::computeSpawnSources() {
   static int spawnSourceRange = config.getIntProperty("config.aidirector.spawnSourceRange");
+  computeSpawnSources(spawnSourceRange);
+}
+
+void Dungeon::computeSpawnSources(int spawnSourceRange) {
   // generate spawn sources
   spawnSources.clear();
   for (int x = spawnSourceRange / 2; x < width; x += spawnSourceRange) {
@@ -55,9 +66,12 @@ void Dungeon::computeSpawnSources() {
 }
 
 // allocate all data
-void Dungeon::initData(util::CaveGenerator* caveGen) {
+void Dungeon::initData(util::CaveGenerator* caveGen, util::GenerationContext* context) {
+  serial = nextSerial++;
   cells = new map::Cell[width * height];
   subcells = new map::SubCell[width * height * 4];
+  creatureIndex.resize(width, height);
+  itemIndex.resize(width, height);
   stairx = stairy = -1;
   if (caveGen) {
     map = caveGen->map;
@@ -68,14 +82,14 @@ void Dungeon::initData(util::CaveGenerator* caveGen) {
       }
     }
   } else {
-    gameEngine->displayProgress(0.05f);
+    context->setProgress(0.05f);
     map = new TCODMap(width, height);
     map2x = new TCODMap(width * 2, height * 2);
   }
   hmap = new TCODHeightMap(width * 2, height * 2);
   smap = new TCODHeightMap(width * 2, height * 2);
   smapBeforeTree = new TCODHeightMap(width * 2, height * 2);
-  if (!caveGen) gameEngine->displayProgress(0.1f);
+  context->setProgress(0.1f);
   isUpdatingItems = false;
   isUpdatingCreatures = false;
 }
@@ -92,38 +106,37 @@ void Dungeon::cleanData() {
   if (clouds) delete clouds;
 }
 
-Dungeon::Dungeon(int level, util::CaveGenerator* caveGen) : level(level), ambient(TCODColor::black) {
+Dungeon::Dungeon(int level, util::CaveGenerator* caveGen, util::GenerationContext* context)
+    : level(level), ambient(TCODColor::black) {
   // get dungeons min/max size from config
-  static int nbLevels = config.getIntProperty("config.gameplay.nbLevels");
-  static int minSize = config.getIntProperty("config.gameplay.dungeonMinSize");
-  static int maxSize = config.getIntProperty("config.gameplay.dungeonMaxSize");
-  static bool debug = config.getBoolProperty("config.debug");
+  const util::GenerationConfig& cfg = context->config;
 
   clouds = NULL;
-  width = height = minSize + (maxSize - minSize) * (level + 1) / nbLevels;
-  initData(caveGen);
+  width = height = cfg.dungeonMinSize + (cfg.dungeonMaxSize - cfg.dungeonMinSize) * (level + 1) / cfg.nbLevels;
+  initData(caveGen, context);
 
-  setPlayerStartingPosition();
-  computeSpawnSources();
+  // the player is placed by the caller. this might run on a worker thread
+  chooseStartingPosition(&context->rng);
+  computeSpawnSources(cfg.spawnSourceRange);
 
-  finalizeMap(level >= 1, true);
+  finalizeMap(context, level >= 1, true);
 
-  if (debug) {
-    mob::Player* player = &gameEngine->player;
-    saveMap((int)player->x, (int)player->y);
-  }
+  if (cfg.debug) saveMap(startx, starty);
 }
 
-void Dungeon::finalizeMap(bool roundCorners, bool blurGround) {
-  static TCODColor groundColor = config.getColorProperty("config.display.groundColor");
-  static TCODColor memoryWallColor = config.getColorProperty("config.display.memoryWallColor");
+void Dungeon::finalizeMap(util::GenerationContext* context, bool roundCorners, bool blurGround) {
+  TCODColor groundColor = context->config.groundColor;
+  TCODColor memoryWallColor = context->config.memoryWallColor;
+  TCODNoise* noise = &context->noise2d;
 
   // scale the map 2x
-  for (int x = 0; x < width * 2; x++) {
-    for (int y = 0; y < height * 2; y++) {
-      map2x->setProperties(x, y, map->isTransparent(x / 2, y / 2), map->isWalkable(x / 2, y / 2));
+  util::parallelFor2D(width * 2, height * 2, [this](const util::Tile& tile) {
+    for (int y = tile.miny; y < tile.maxy; y++) {
+      for (int x = tile.minx; x < tile.maxx; x++) {
+        map2x->setProperties(x, y, map->isTransparent(x / 2, y / 2), map->isWalkable(x / 2, y / 2));
+      }
     }
-  }
+  });
 
   // apply cellular automata to 2x map
   if (roundCorners) {
@@ -150,49 +163,63 @@ void Dungeon::finalizeMap(bool roundCorners, bool blurGround) {
   // generate ground image
   float noiseDepth = 0.05f * (level - 1);
   noiseDepth = MIN(0.3f, noiseDepth);
-  for (int x = 0; x < width * 2; x++) {
-    for (int y = 0; y < height * 2; y++) {
-      if (map2x->isTransparent(x, y)) {
-        // ground
-        float f[2] = {x / 3.0f, y / 3.0f};
-        float coef = 1.0f + noiseDepth * noise2d.getFbm(f, 3.0f);
-        setGroundColor(x, y, groundColor * coef);
-      } else {
-        // wall
-        setGroundColor(x, y, memoryWallColor);
+  util::parallelFor2D(width * 2, height * 2, [&, this](const util::Tile& tile) {
+    for (int y = tile.miny; y < tile.maxy; y++) {
+      for (int x = tile.minx; x < tile.maxx; x++) {
+        if (map2x->isTransparent(x, y)) {
+          // ground
+          float f[2] = {x / 3.0f, y / 3.0f};
+          float coef = 1.0f + noiseDepth * noise->getFbm(f, 3.0f);
+          setGroundColor(x, y, groundColor * coef);
+        } else {
+          // wall
+          setGroundColor(x, y, memoryWallColor);
+        }
       }
     }
-  }
+  });
   // smooth it
   if (blurGround) {
-    for (int x = 0; x < width * 2 - 1; x++) {
-      for (int y = 0; y < height * 2 - 1; y++) {
-        int r = 0, g = 0, b = 0;
-        TCODColor col = getGroundColor(x, y);
-        r += col.r;
-        g += col.g;
-        b += col.b;
-        col = getGroundColor(x + 1, y);
-        r += col.r;
-        g += col.g;
-        b += col.b;
-        col = getGroundColor(x + 1, y + 1);
-        r += col.r;
-        g += col.g;
-        b += col.b;
-        col = getGroundColor(x, y + 1);
-        r += col.r;
-        g += col.g;
-        b += col.b;
-        setGroundColor(x, y, TCODColor(r / 4, g / 4, b / 4));
-      }
-    }
+    // the right and bottom neighbours are always read before being smoothed
+    // so the filter only depends on the original image
+    util::parallelStencil2D<TCODColor>(
+        width * 2,
+        height * 2,
+        1,
+        [this](int x, int y) { return getGroundColor(x, y); },
+        [this](const util::Tile& tile, const util::HaloBuffer<TCODColor>& src) {
+          int maxx = MIN(tile.maxx, width * 2 - 1);
+          int maxy = MIN(tile.maxy, height * 2 - 1);
+          for (int y = tile.miny; y < maxy; y++) {
+            for (int x = tile.minx; x < maxx; x++) {
+              int r = 0, g = 0, b = 0;
+              TCODColor col = src(x, y);
+              r += col.r;
+              g += col.g;
+              b += col.b;
+              col = src(x + 1, y);
+              r += col.r;
+              g += col.g;
+              b += col.b;
+              col = src(x + 1, y + 1);
+              r += col.r;
+              g += col.g;
+              b += col.b;
+              col = src(x, y + 1);
+              r += col.r;
+              g += col.g;
+              b += col.b;
+              setGroundColor(x, y, TCODColor(r / 4, g / 4, b / 4));
+            }
+          }
+        });
   }
+  nearestWalkable.compute(map);
 }
 
 void Dungeon::smoothShadow() {
-  // compute shadow from shadowheight
-  for (int y = 0; y < height * 2 - 1; y++) {
+  // compute shadow from shadowheight. rows are independent
+  util::parallelFor(height * 2 - 1, [this](int y) {
     float z = getShadowHeight(width * 2 - 1, y);
     float rayZ = z;
     for (int x = width * 2 - 2; x >= 0; x--) {
@@ -205,18 +232,27 @@ void Dungeon::smoothShadow() {
         setShadow(x, y, getShadow(x, y) * 0.9f);
       }
     }
-  }
+  });
   // smooth shadow
-  for (int x = 0; x < width * 2 - 1; x++) {
-    for (int y = 0; y < height * 2 - 1; y++) {
-      float shadow = 0.0f;
-      shadow += getShadow(x, y);
-      shadow += getShadow(x + 1, y);
-      shadow += getShadow(x + 1, y + 1);
-      shadow += getShadow(x, y + 1);
-      setShadow(x, y, 0.25f * shadow);
-    }
-  }
+  util::parallelStencil2D<float>(
+      width * 2,
+      height * 2,
+      1,
+      [this](int x, int y) { return getShadow(x, y); },
+      [this](const util::Tile& tile, const util::HaloBuffer<float>& src) {
+        int maxx = MIN(tile.maxx, width * 2 - 1);
+        int maxy = MIN(tile.maxy, height * 2 - 1);
+        for (int y = tile.miny; y < maxy; y++) {
+          for (int x = tile.minx; x < maxx; x++) {
+            float shadow = 0.0f;
+            shadow += src(x, y);
+            shadow += src(x + 1, y);
+            shadow += src(x + 1, y + 1);
+            shadow += src(x, y + 1);
+            setShadow(x, y, 0.25f * shadow);
+          }
+        }
+      });
 }
 
 void Dungeon::updateLights(float elapsed) {
@@ -225,22 +261,178 @@ void Dungeon::updateLights(float elapsed) {
   }
 }
 
+// grow the rectangle minx <= x < maxx, miny <= y < maxy. an empty rectangle is replaced
+static void mergeRect(int* minx, int* miny, int* maxx, int* maxy, int x1, int y1, int x2, int y2) {
+  if (x2 <= x1 || y2 <= y1) return;
+  if (*maxx <= *minx || *maxy <= *miny) {
+    *minx = x1;
+    *miny = y1;
+    *maxx = x2;
+    *maxy = y2;
+    return;
+  }
+  *minx = MIN(*minx, x1);
+  *miny = MIN(*miny, y1);
+  *maxx = MAX(*maxx, x2);
+  *maxy = MAX(*maxy, y2);
+}
+
+bool Dungeon::isLightVisible(const map::Light* light) const {
+  if (light->range == 0.0f) return false;
+  // cells the light can reach
+  int minx = (int)floorf((light->x - light->range) / 2);
+  int miny = (int)floorf((light->y - light->range) / 2);
+  int maxx = (int)floorf((light->x + light->range) / 2);
+  int maxy = (int)floorf((light->y + light->range) / 2);
+  // clamp them to the console and the map
+  minx = MAX(minx, MAX(0, gameEngine->xOffset));
+  miny = MAX(miny, MAX(0, gameEngine->yOffset));
+  maxx = MIN(maxx, MIN(width - 1, gameEngine->xOffset + CON_W - 1));
+  maxy = MIN(maxy, MIN(height - 1, gameEngine->yOffset + CON_H - 1));
+  if (minx > maxx || miny > maxy) return false;
+  if (fovBlocks.empty()) return true;  // fov not computed yet
+  for (int by = miny / FOV_BLOCK; by <= maxy / FOV_BLOCK; by++) {
+    for (int bx = minx / FOV_BLOCK; bx <= maxx / FOV_BLOCK; bx++) {
+      if (fovBlocks[bx + by * fovBlocksWidth]) return true;
+    }
+  }
+  return false;
+}
+
+void Dungeon::removeLight(map::Light* light) {
+  // the light may be deleted right after. remember the part it lit so that the next render clears it
+  int light_minx, light_miny, light_maxx, light_maxy;
+  if (light->getRenderedPart(&light_minx, &light_miny, &light_maxx, &light_maxy)) {
+    mergeRect(&removedLightsMinx, &removedLightsMiny, &removedLightsMaxx, &removedLightsMaxy, light_minx, light_miny,
+              light_maxx, light_maxy);
+  }
+  light->resetRendered();
+  lights.removeFast(light);
+}
+
 void Dungeon::renderLightsToLightMap(
     map::LightMap& lightMap, int* minx, int* miny, int* maxx, int* maxy, bool clearMap) {
+  PROFILE_SCOPE("lights");
   int minx2x = width * 2 - 1;
   int maxx2x = 0;
   int miny2x = height * 2 - 1;
   int maxy2x = 0;
-  if (clearMap) lightMap.clear(ambient);
+  // broad phase : lights that can't reach a visible cell don't need their fov
+  std::vector<bool> visible(lights.size());
   for (map::Light** it = lights.begin(); it != lights.end(); it++) {
     int light_minx, light_maxx, light_miny, light_maxy;
-    (*it)->addToLightMap(lightMap);
+    visible[it - lights.begin()] = isLightVisible(*it);
+    if (visible[it - lights.begin()]) (*it)->prepare(lightMap.lowRes);
     (*it)->getDungeonPart(&light_minx, &light_miny, &light_maxx, &light_maxy);
     if (minx2x > light_minx) minx2x = light_minx;
     if (maxx2x < light_maxx) maxx2x = light_maxx;
     if (miny2x > light_miny) miny2x = light_miny;
     if (maxy2x < light_maxy) maxy2x = light_maxy;
   }
+  // incremental rendering : if the map still holds the lights of the previous frame, only the parts covered by
+  // the lights that changed, the removed lights and the cells written over the lights are rendered again
+  map::LightMap::LightsKey key;
+  key.dungeonSerial = serial;
+  key.xOffset = gameEngine->xOffset;
+  key.yOffset = gameEngine->yOffset;
+  key.ambient = ambient;
+  key.fovVersion = fovVersion;
+  int dirtyMinx = 0, dirtyMiny = 0, dirtyMaxx = lightMap.width, dirtyMaxy = lightMap.height;
+  if (clearMap && lightMap.hasLights && lightMap.lightsKey == key) {
+    dirtyMinx = lightMap.touchedMinx;
+    dirtyMiny = lightMap.touchedMiny;
+    dirtyMaxx = lightMap.touchedMaxx;
+    dirtyMaxy = lightMap.touchedMaxy;
+    mergeRect(&dirtyMinx, &dirtyMiny, &dirtyMaxx, &dirtyMaxy, removedLightsMinx, removedLightsMiny,
+              removedLightsMaxx, removedLightsMaxy);
+    for (map::Light** it = lights.begin(); it != lights.end(); it++) {
+      if (!(*it)->hasChanged()) continue;
+      int light_minx, light_maxx, light_miny, light_maxy;
+      if ((*it)->getRenderedPart(&light_minx, &light_miny, &light_maxx, &light_maxy)) {
+        mergeRect(&dirtyMinx, &dirtyMiny, &dirtyMaxx, &dirtyMaxy, light_minx, light_miny, light_maxx, light_maxy);
+      }
+      if (visible[it - lights.begin()] &&
+          (*it)->getLightMapPart(
+              lightMap.width, lightMap.height, &light_minx, &light_miny, &light_maxx, &light_maxy)) {
+        mergeRect(&dirtyMinx, &dirtyMiny, &dirtyMaxx, &dirtyMaxy, light_minx, light_miny, light_maxx, light_maxy);
+      }
+    }
+    dirtyMinx = MAX(0, dirtyMinx);
+    dirtyMiny = MAX(0, dirtyMiny);
+    dirtyMaxx = MIN(lightMap.width, dirtyMaxx);
+    dirtyMaxy = MIN(lightMap.height, dirtyMaxy);
+    if (dirtyMaxx > dirtyMinx && dirtyMaxy > dirtyMiny) {
+      lightMap.clear(ambient, dirtyMinx, dirtyMiny, dirtyMaxx, dirtyMaxy);
+    }
+  } else if (clearMap) {
+    lightMap.clear(ambient);
+  }
+  // low res : the lights are rendered on the cells then upsampled to the dirty subcells, which read the cells
+  // around them
+  int scale = lightMap.lowRes ? 2 : 1;
+  int renderMinx = dirtyMinx, renderMiny = dirtyMiny, renderMaxx = dirtyMaxx, renderMaxy = dirtyMaxy;
+  if (lightMap.lowRes) {
+    renderMinx = MAX(0, dirtyMinx / 2 - 1);
+    renderMiny = MAX(0, dirtyMiny / 2 - 1);
+    renderMaxx = MIN(lightMap.width / 2, (dirtyMaxx + 1) / 2 + 1);
+    renderMaxy = MIN(lightMap.height / 2, (dirtyMaxy + 1) / 2 + 1);
+    if (renderMaxx > renderMinx && renderMaxy > renderMiny) {
+      lightMap.clearLowRes(renderMinx, renderMiny, renderMaxx, renderMaxy);
+    }
+  }
+  // deferred accumulation : bin the lights into lightmap tiles, then each tile adds its lights in the list order.
+  // tiles write disjoint parts of the lightmap so they run in parallel, with the same result as a serial loop
+  static constexpr int LIGHT_TILE_SIZE = 32;
+  std::vector<util::Tile> tiles =
+      util::makeTiles(lightMap.width / scale, lightMap.height / scale, LIGHT_TILE_SIZE / scale, 0);
+  std::vector<std::vector<map::Light*>> tileLights(tiles.size());
+  for (util::Tile& tile : tiles) {
+    // only render the dirty part
+    tile.minx = MAX(tile.minx, renderMinx);
+    tile.miny = MAX(tile.miny, renderMiny);
+    tile.maxx = MIN(tile.maxx, renderMaxx);
+    tile.maxy = MIN(tile.maxy, renderMaxy);
+  }
+  for (map::Light** it = lights.begin(); it != lights.end(); it++) {
+    int light_minx, light_maxx, light_miny, light_maxy;
+    if (!visible[it - lights.begin()] ||
+        !(*it)->getLightMapPart(
+            lightMap.width, lightMap.height, &light_minx, &light_miny, &light_maxx, &light_maxy)) {
+      (*it)->markRendered(0, 0, 0, 0);
+      continue;
+    }
+    (*it)->markRendered(light_minx, light_miny, light_maxx, light_maxy);
+    if (lightMap.lowRes) {
+      light_minx /= 2;
+      light_miny /= 2;
+      light_maxx = (light_maxx + 1) / 2;
+      light_maxy = (light_maxy + 1) / 2;
+    }
+    for (size_t i = 0; i < tiles.size(); i++) {
+      const util::Tile& tile = tiles[i];
+      if (light_minx < tile.maxx && light_maxx > tile.minx && light_miny < tile.maxy && light_maxy > tile.miny) {
+        tileLights[i].push_back(*it);
+      }
+    }
+  }
+  util::parallelFor((int)tiles.size(), [&](int i) {
+    const util::Tile& tile = tiles[i];
+    for (map::Light* light : tileLights[i]) {
+      if (lightMap.lowRes) {
+        light->addToLowResLightMap(lightMap, tile.minx, tile.miny, tile.maxx, tile.maxy);
+      } else {
+        light->addToLightMap(lightMap, tile.minx, tile.miny, tile.maxx, tile.maxy);
+      }
+    }
+  });
+  if (lightMap.lowRes && dirtyMaxx > dirtyMinx && dirtyMaxy > dirtyMiny) {
+    lightMap.upsampleLowRes(dirtyMinx, dirtyMiny, dirtyMaxx, dirtyMaxy);
+  }
+  removedLightsMinx = removedLightsMiny = removedLightsMaxx = removedLightsMaxy = 0;
+  // a map that was not cleared holds more than the lights
+  lightMap.hasLights = clearMap;
+  lightMap.lightsKey = key;
+  lightMap.resetTouched();
   if (minx) *minx = minx2x;
   if (miny) *miny = miny2x;
   if (maxx) *maxx = maxx2x;
@@ -305,6 +497,16 @@ void Dungeon::getClosestWalkable(
   if (map->isWalkable(*x, *y) && (includingStairs || *x != stairx || *y != stairy) &&
       (includingCreatures || !hasCreature(*x, *y)) && (includingWater || !hasRipples(*x, *y)))
     return;
+  // maps not finalized get their transform on the first query
+  if (!nearestWalkable.isValid()) nearestWalkable.compute(map);
+  int nx, ny;
+  if (nearestWalkable.getNearest(*x, *y, &nx, &ny) && (includingStairs || nx != stairx || ny != stairy) &&
+      (includingCreatures || !hasCreature(nx, ny)) && (includingWater || !hasRipples(nx, ny))) {
+    *x = nx;
+    *y = ny;
+    return;
+  }
+  // the closest walkable cell is excluded. search around
   int dist = 1000000;
   int bestx = 0, besty = 0;
   int range = 10;
@@ -402,7 +604,7 @@ void Dungeon::getClosestSpawnSource(int x, int y, int* ssx, int* ssy) const {
   *ssy = best >> 16;
 }
 
-void Dungeon::getRandomPositionInCorner(int cornerx, int cornery, int* px, int* py) {
+void Dungeon::getRandomPositionInCorner(TCODRandom* rng, int cornerx, int cornery, int* px, int* py) {
   int posx = rng->getInt(0, width / 2 - 1);
   int posy = rng->getInt(0, height / 2 - 1);
   posx += cornerx * width / 2;
@@ -412,30 +614,32 @@ void Dungeon::getRandomPositionInCorner(int cornerx, int cornery, int* px, int*
   *py = posy;
 }
 
-void Dungeon::setPlayerStartingPosition() {
-  mob::Player* player = &gameEngine->player;
+void Dungeon::chooseStartingPosition(TCODRandom* rng) {
   // choose a corner
   int cornerx = rng->getInt(0, 1);
   int cornery = rng->getInt(0, 1);
-  int px, py;
-  getRandomPositionInCorner(cornerx, cornery, &px, &py);
-  player->setPos(px, py);
+  getRandomPositionInCorner(rng, cornerx, cornery, &startx, &starty);
   // set the stair position in another corner
   int dist = 0;
   do {
     int r = rng->getInt(1, 3);
     if (r & 1) cornerx = 1 - cornerx;
     if (r & 2) cornery = 1 - cornery;
-    getRandomPositionInCorner(cornerx, cornery, &stairx, &stairy);
+    getRandomPositionInCorner(rng, cornerx, cornery, &stairx, &stairy);
     // check that the stair is not too close to player starting position
     TCODPath path(map);
     dist = 1000000;
-    if (path.compute((int)player->x, (int)player->y, stairx, stairy)) {
+    if (path.compute(startx, starty, stairx, stairy)) {
       dist = path.size();
     }
   } while (dist < width / 3);
 }
 
+void Dungeon::setPlayerStartingPosition() {
+  chooseStartingPosition(rng);
+  gameEngine->player.setPos(startx, starty);
+}
+
 void Dungeon::saveMap(int playerX, int playerY) {
   // save the map as png
   TCODImage tmp(width * 2, height * 2);
@@ -482,10 +686,11 @@ void Dungeon::saveMap(int playerX, int playerY) {
 mob::Creature* Dungeon::getCreature(int x, int y) const {
   if (!IN_RECTANGLE(x, y, width, height)) return NULL;
   if (getCell(x, y)->nbCreatures == 0) return NULL;
-  for (mob::Creature** it = creatures.begin(); it != creatures.end(); it++) {
-    if ((int)(*it)->x == x && (int)(*it)->y == y) return *it;
-  }
-  return NULL;
+  mob::Creature* ret = NULL;
+  creatureIndex.forEachInRectangle(x, y, x, y, [&ret](mob::Creature* cr) {
+    if (!ret) ret = cr;
+  });
+  return ret;
 }
 
 mob::Creature* Dungeon::getCreature(mob::CreatureTypeId id) const {
@@ -508,6 +713,7 @@ void Dungeon::moveCreature(mob::Creature* cr, int xFrom, int yFrom, int xTo, int
   getCell(xTo, yTo)->nbCreatures++;
   assert(getCell(xFrom, yFrom)->nbCreatures > 0);
   getCell(xFrom, yFrom)->nbCreatures--;
+  creatureIndex.move(cr, xFrom, yFrom, xTo, yTo);
 }
 
 void Dungeon::addCreature(mob::Creature* cr) {
@@ -516,6 +722,7 @@ void Dungeon::addCreature(mob::Creature* cr) {
   } else {
     creatures.push(cr);
     getCell(cr->x, cr->y)->nbCreatures++;
+    creatureIndex.add(cr, (int)cr->x, (int)cr->y);
   }
 }
 
@@ -526,8 +733,10 @@ bool Dungeon::hasCreature(int x, int y) const {
 }
 
 void Dungeon::removeCreature(mob::Creature* cr, bool kill) {
+  pathService.cancel(cr);
   map::Cell* cell = getCell(cr->x, cr->y);
   cell->nbCreatures--;
+  creatureIndex.remove(cr, (int)cr->x, (int)cr->y);
   if (kill) {
     if (!cell->hasCorpse) {
       cell->hasCorpse = true;
@@ -566,6 +775,7 @@ void Dungeon::renderSubcellCreatures(map::LightMap& lightMap) {
 }
 
 void Dungeon::updateCreatures(float elapsed) {
+  PROFILE_SCOPE("creatures");
   // can't use iterator because the boss update function summon creatures,
   // which may result in creatures reallocation
   TCODList<mob::Creature*> toDelete;
@@ -588,17 +798,29 @@ void Dungeon::updateCreatures(float elapsed) {
     addCreature(*it);
   }
   creaturesToAdd.clear();
+  updatePaths();
+}
+
+void Dungeon::updatePaths() {
+  static int pathBudget = config.getIntProperty("config.creatures.pathBudget");
+  static bool threadedPaths = config.getBoolProperty("config.creatures.threadedPaths");
+  PROFILE_COUNTER("paths queued", (int64_t)pathService.getQueueLength());
+  if (pathService.getQueueLength() == 0) return;
+  // repair the hierarchical pathfinder graph on this thread. the paths only read it, maybe from several threads
+  pathService.update(getPathGraph(), pathBudget, threadedPaths);
 }
 
 void Dungeon::killCreaturesAtRange(int radius) {
   float px = gameEngine->player.x;
   float py = gameEngine->player.y;
   int rad2 = radius * radius;
-  for (mob::Creature** it = creatures.begin(); it != creatures.end(); it++) {
-    float dx = (*it)->x - px;
-    float dy = (*it)->y - py;
-    if (dx * dx + dy * dy <= rad2) (*it)->life = 0;
-  }
+  forEachCreatureInRectangle(
+      (int)px - radius - 1, (int)py - radius - 1, (int)px + radius + 1, (int)py + radius + 1,
+      [px, py, rad2](mob::Creature* cr) {
+        float dx = cr->x - px;
+        float dy = cr->y - py;
+        if (dx * dx + dy * dy <= rad2) cr->life = 0;
+      });
 }
 
 void Dungeon::renderCorpses(map::LightMap& lightMap) {
@@ -664,6 +886,7 @@ void Dungeon::addItem(item::Item* it) {
     itemsToAdd.push_back(it);
   else {
     item::Item* newItem = it->addToList(getCell(it->x, it->y)->items);
+    reindexItems((int)it->x, (int)it->y);
     if (newItem == it) {
       items.push_back(newItem);
       if (newItem->getLight()) addLight(newItem->getLight());
@@ -689,24 +912,73 @@ void Dungeon::computeWalkTransp(int x, int y) {
 }
 
 void Dungeon::setProperties(int x, int y, bool transparent, bool walkable) {
+  if (map->isTransparent(x, y) != transparent) {
+    int* change = transparencyChanges[transparencyVersion % NB_TRANSPARENCY_CHANGES];
+    change[0] = x;
+    change[1] = y;
+    transparencyVersion++;
+  }
+  bool walkabilityChanged = map->isWalkable(x, y) != walkable;
   map->setProperties(x, y, transparent, walkable);
   map2x->setProperties(x * 2, y * 2, transparent, walkable);
   map2x->setProperties(x * 2 + 1, y * 2, transparent, walkable);
   map2x->setProperties(x * 2, y * 2 + 1, transparent, walkable);
   map2x->setProperties(x * 2 + 1, y * 2 + 1, transparent, walkable);
+  if (walkabilityChanged) onWalkabilityChange(x, y);
+}
+
+bool Dungeon::hasTransparencyChanged(int minx2x, int miny2x, int maxx2x, int maxy2x, int sinceVersion) const {
+  if (sinceVersion >= transparencyVersion) return false;
+  // too many changes, the log no longer covers them
+  if (transparencyVersion - sinceVersion > NB_TRANSPARENCY_CHANGES) return true;
+  for (int version = sinceVersion; version < transparencyVersion; version++) {
+    const int* change = transparencyChanges[version % NB_TRANSPARENCY_CHANGES];
+    // a cell covers 2x2 subcells
+    if (change[0] * 2 + 1 >= minx2x && change[0] * 2 <= maxx2x && change[1] * 2 + 1 >= miny2x &&
+        change[1] * 2 <= maxy2x)
+      return true;
+  }
+  return false;
 }
 
 void Dungeon::setWalkable(int x, int y, bool walkable) {
   bool transp = map->isTransparent(x, y);
+  bool walkabilityChanged = map->isWalkable(x, y) != walkable;
   map->setProperties(x, y, transp, walkable);
   map2x->setProperties(x * 2, y * 2, transp, walkable);
   map2x->setProperties(x * 2 + 1, y * 2, transp, walkable);
   map2x->setProperties(x * 2, y * 2 + 1, transp, walkable);
   map2x->setProperties(x * 2 + 1, y * 2 + 1, transp, walkable);
+  if (walkabilityChanged) onWalkabilityChange(x, y);
+}
+
+void Dungeon::onWalkabilityChange(int x, int y) {
+  walkabilityVersion++;
+  pathGraph.setDirty(x, y);
+  if (nearestWalkable.isValid()) nearestWalkable.update(map, x, y);
+}
+
+const map::FlowField& Dungeon::getPlayerFlowField() {
+  static int flowFieldRadius = config.getIntProperty("config.creatures.flowFieldRadius");
+  mob::Player& player = gameEngine->player;
+  if (!playerFlowField.isValid() || (int)player.x != playerFlowField.getGoalX() ||
+      (int)player.y != playerFlowField.getGoalY() || walkabilityVersion != playerFlowFieldVersion) {
+    PROFILE_SCOPE("playerFlowField");
+    playerFlowField.compute(map, (int)player.x, (int)player.y, flowFieldRadius);
+    playerFlowFieldVersion = walkabilityVersion;
+  }
+  return playerFlowField;
+}
+
+const map::ClusterGraph& Dungeon::getPathGraph() {
+  static int pathClusterSize = config.getIntProperty("config.creatures.pathClusterSize");
+  pathGraph.update(map, pathClusterSize);
+  return pathGraph;
 }
 
 item::Item* Dungeon::removeItem(item::Item* it, int count, bool del) {
   item::Item* newItem = it->removeFromList(getCell(it->x, it->y)->items, count);
+  reindexItems((int)it->x, (int)it->y);
   if (newItem == it) {
     if (it->getLight()) removeLight(it->getLight());
     if (del) it->to_delete_ = count;
@@ -715,17 +987,35 @@ item::Item* Dungeon::removeItem(item::Item* it, int count, bool del) {
   return newItem;
 }
 
+void Dungeon::moveItem(item::Item* it, int xFrom, int yFrom) {
+  helpers::remove<item::Item*>(getCell(xFrom, yFrom)->items, it);
+  getCell(it->x, it->y)->items.push_back(it);
+  itemIndex.move(it, xFrom, yFrom, (int)it->x, (int)it->y);
+}
+
+void Dungeon::reindexItems(int x, int y) {
+  // the stacks and containers may add or remove other items of the cell list, so index the whole list again
+  itemIndex.removeCell(x, y);
+  for (item::Item* it : getCell(x, y)->items) itemIndex.add(it, x, y);
+}
+
 void Dungeon::saveShadowBeforeTree() {
-  for (int i = 0; i < width * height * 4; i++) {
-    subcells[i].shadowBeforeTree = subcells[i].shadow;
-  }
+  util::parallelFor2D(width * 2, height * 2, [this](const util::Tile& tile) {
+    for (int y = tile.miny; y < tile.maxy; y++) {
+      map::SubCell* subcell = getSubCell(tile.minx, y);
+      for (int x = tile.minx; x < tile.maxx; x++, subcell++) subcell->shadowBeforeTree = subcell->shadow;
+    }
+  });
   smapBeforeTree->copy(smap);
 }
 
 void Dungeon::restoreShadowBeforeTree() {
-  for (int i = 0; i < width * height * 4; i++) {
-    subcells[i].shadow = subcells[i].shadowBeforeTree;
-  }
+  util::parallelFor2D(width * 2, height * 2, [this](const util::Tile& tile) {
+    for (int y = tile.miny; y < tile.maxy; y++) {
+      map::SubCell* subcell = getSubCell(tile.minx, y);
+      for (int x = tile.minx; x < tile.maxx; x++, subcell++) subcell->shadow = subcell->shadowBeforeTree;
+    }
+  });
   smap->copy(smapBeforeTree);
 }
 
@@ -758,6 +1048,7 @@ void Dungeon::renderItems(map::LightMap& lightMap, TCODImage* ground) {
 }
 
 void Dungeon::updateItems(float elapsed, TCOD_key_t k, TCOD_mouse_t* mouse) {
+  PROFILE_SCOPE("items");
   std::vector<item::Item*> toDelete;
   isUpdatingItems = true;
   for (item::Item* it : items) {
@@ -793,6 +1084,12 @@ bool Dungeon::hasLos(int xFrom, int yFrom, int xTo, int yTo, bool ignoreCreature
 }
 
 void Dungeon::computeFov(int x, int y) {
+  if (x != fovx || y != fovy || transparencyVersion != fovTransparencyVersion) {
+    fovx = x;
+    fovy = y;
+    fovTransparencyVersion = transparencyVersion;
+    fovVersion++;
+  }
   // compute fov on 2x map, then copy info to 1x map
   map2x->computeFov(2 * x, 2 * y, CON_W, true, FOV_RESTRICTIVE);
   // dungeon rectangle corresponding to console
@@ -805,25 +1102,29 @@ void Dungeon::computeFov(int x, int y) {
   miny = MAX(0, miny);
   maxx = MIN(width - 1, maxx);
   maxy = MIN(height - 1, maxy);
+  fovBlocksWidth = (width + FOV_BLOCK - 1) / FOV_BLOCK;
+  fovBlocksHeight = (height + FOV_BLOCK - 1) / FOV_BLOCK;
+  fovBlocks.assign(fovBlocksWidth * fovBlocksHeight, false);
   for (int cx = minx; cx <= maxx; cx++) {
     for (int cy = miny; cy <= maxy; cy++) {
-      map->setInFov(
-          cx,
-          cy,
-          map2x->isInFov(cx * 2, cy * 2) || map2x->isInFov(cx * 2 + 1, cy * 2) || map2x->isInFov(cx * 2, cy * 2 + 1) ||
-              map2x->isInFov(cx * 2 + 1, cy * 2 + 1));
+      bool inFov = map2x->isInFov(cx * 2, cy * 2) || map2x->isInFov(cx * 2 + 1, cy * 2) ||
+                   map2x->isInFov(cx * 2, cy * 2 + 1) || map2x->isInFov(cx * 2 + 1, cy * 2 + 1);
+      map->setInFov(cx, cy, inFov);
+      if (inFov) fovBlocks[cx / FOV_BLOCK + cy / FOV_BLOCK * fovBlocksWidth] = true;
     }
   }
 }
 
 void Dungeon::applyShadowMap() {
-  for (int x = 0; x < width * 2; x++) {
-    for (int y = 0; y < height * 2; y++) {
-      TCODColor col = getGroundColor(x, y);
-      col = col * getShadow(x, y);
-      setGroundColor(x, y, col);
+  util::parallelFor2D(width * 2, height * 2, [this](const util::Tile& tile) {
+    for (int y = tile.miny; y < tile.maxy; y++) {
+      for (int x = tile.minx; x < tile.maxx; x++) {
+        TCODColor col = getGroundColor(x, y);
+        col = col * getShadow(x, y);
+        setGroundColor(x, y, col);
+      }
     }
-  }
+  });
 }
 
 #define SQR(x) ((x) * (x))
@@ -835,33 +1136,60 @@ void Dungeon::computeOutdoorLight(float lightDir[3], TCODColor lightColor) {
   lightDir[0] *= len;
   lightDir[1] *= len;
   lightDir[2] *= len;
-  // compute light coef min/max
-  for (int x = 0; x < width * 2; x++) {
-    for (int y = 0; y < height * 2; y++) {
-      float n[3];
-      hmap->getNormal(x, y, n);
-      float lightCoef = (n[0] * lightDir[0] + n[1] * lightDir[1] + n[2] * lightDir[2] + 1.0f) * 0.5f;
-      if (lightCoef > max)
-        max = lightCoef;
-      else if (lightCoef < min)
-        min = lightCoef;
+  int w2 = width * 2, h2 = height * 2;
+  std::vector<float> lightCoefs(w2 * h2);
+  // compute light coef min/max on chunks of columns.
+  // the scan only lowers min with values that are not a new max, so each chunk is scanned again
+  // once the max of the previous chunks is known to get exactly the serial result
+  static constexpr int CHUNK_WIDTH = 16;
+  int nbChunks = (w2 + CHUNK_WIDTH - 1) / CHUNK_WIDTH;
+  std::vector<float> chunkMax(nbChunks, 0.0f), chunkMin(nbChunks, 1.0f);
+  util::parallelFor(nbChunks, [&](int chunk) {
+    for (int x = chunk * CHUNK_WIDTH; x < MIN(w2, (chunk + 1) * CHUNK_WIDTH); x++) {
+      for (int y = 0; y < h2; y++) {
+        float n[3];
+        hmap->getNormal(x, y, n);
+        float lightCoef = (n[0] * lightDir[0] + n[1] * lightDir[1] + n[2] * lightDir[2] + 1.0f) * 0.5f;
+        lightCoefs[x + y * w2] = lightCoef;
+        if (lightCoef > chunkMax[chunk]) chunkMax[chunk] = lightCoef;
+      }
     }
+  });
+  std::vector<float> prevMax(nbChunks);
+  for (int chunk = 0; chunk < nbChunks; chunk++) {
+    prevMax[chunk] = max;
+    if (chunkMax[chunk] > max) max = chunkMax[chunk];
+  }
+  util::parallelFor(nbChunks, [&](int chunk) {
+    float curMax = prevMax[chunk];
+    for (int x = chunk * CHUNK_WIDTH; x < MIN(w2, (chunk + 1) * CHUNK_WIDTH); x++) {
+      for (int y = 0; y < h2; y++) {
+        float lightCoef = lightCoefs[x + y * w2];
+        if (lightCoef > curMax)
+          curMax = lightCoef;
+        else if (lightCoef < chunkMin[chunk])
+          chunkMin[chunk] = lightCoef;
+      }
+    }
+  });
+  for (int chunk = 0; chunk < nbChunks; chunk++) {
+    if (chunkMin[chunk] < min) min = chunkMin[chunk];
   }
   float normcoef = 1.0f / (max - min);
   // apply normalized light coef to color
-  for (int x = 0; x < width * 2; x++) {
-    for (int y = 0; y < height * 2; y++) {
-      TCODColor col = getGroundColor(x, y);
-      float n[3];
-      hmap->getNormal(x, y, n);
-      float lightCoef = (n[0] * lightDir[0] + n[1] * lightDir[1] + n[2] * lightDir[2] + 1.0f) * 0.5f;
-      lightCoef = (lightCoef - min) * normcoef;
-      //			if ( lightCoef < 0.5f ) lightCoef *= 0.8f;
-      //			else lightCoef *= 1.2f;
-      col = col * (lightColor * lightCoef);
-      setGroundColor(x, y, col);
+  util::parallelFor2D(w2, h2, [&](const util::Tile& tile) {
+    for (int y = tile.miny; y < tile.maxy; y++) {
+      for (int x = tile.minx; x < tile.maxx; x++) {
+        TCODColor col = getGroundColor(x, y);
+        float lightCoef = lightCoefs[x + y * w2];
+        lightCoef = (lightCoef - min) * normcoef;
+        //			if ( lightCoef < 0.5f ) lightCoef *= 0.8f;
+        //			else lightCoef *= 1.2f;
+        col = col * (lightColor * lightCoef);
+        setGroundColor(x, y, col);
+      }
     }
-  }
+  });
 }
 
 #define DUNG_CHUNK_VERSION 3
@@ -31,10 +31,16 @@
 
 #include "base/savegame.hpp"
 #include "map/cell.hpp"
+#include "map/distancetransform.hpp"
+#include "map/flowfield.hpp"
+#include "map/hpa.hpp"
+#include "map/pathservice.hpp"
+#include "map/spatialindex.hpp"
 #include "mob/creature.hpp"
 #include "util/cavegen.hpp"
 #include "util/cellular.hpp"
 #include "util/clouds.hpp"
+#include "util/gencontext.hpp"
 
 namespace mob {
 class Player;
@@ -47,8 +53,9 @@ class LightMap;
 namespace map {
 class Dungeon : public base::SaveListener {
  public:
-  Dungeon(int width, int height);  // empty dungeon
-  Dungeon(int level, util::CaveGenerator* caveGen);  // bsp / cellular automate dungeon
+  // generation only reads the context so that several maps can be generated at the same time
+  Dungeon(int width, int height, util::GenerationContext* context);  // empty dungeon
+  Dungeon(int level, util::CaveGenerator* caveGen, util::GenerationContext* context);  // bsp / cellular automate dungeon
   virtual ~Dungeon();
 
   // the final dungeon map
@@ -68,6 +75,8 @@ class Dungeon : public base::SaveListener {
 
   // stair to next level
   int stairx, stairy;
+  // player starting position
+  int startx = -1, starty = -1;
   std::vector<item::Item*> items;
   TCODList<mob::Creature*> creatures;
   TCODList<mob::Creature*> corpses;
@@ -87,10 +96,22 @@ class Dungeon : public base::SaveListener {
   void addCorpse(mob::Creature* cr);
   void moveCreature(mob::Creature* cr, int xFrom, int yFrom, int xTo, int yTo);
   void removeCreature(mob::Creature* cr, bool kill = true);
+  // call f(creature) for the creatures whose cell is in minx <= x <= maxx, miny <= y <= maxy.
+  // f must not add, remove nor move creatures
+  template <typename F>
+  void forEachCreatureInRectangle(int minx, int miny, int maxx, int maxy, F&& f) const {
+    creatureIndex.forEachInRectangle(minx, miny, maxx, maxy, f);
+  }
+  // same for the creatures whose cell is at most radius cells away from the cell x,y
+  template <typename F>
+  void forEachCreatureInRadius(int x, int y, float radius, F&& f) const {
+    creatureIndex.forEachInRadius(x, y, radius, f);
+  }
   void renderCreatures(map::LightMap& lightMap);
   void renderSubcellCreatures(map::LightMap& lightMap);
   void renderCorpses(map::LightMap& lightMap);
   void computeSpawnSources();
+  void computeSpawnSources(int spawnSourceRange);
   void getClosestSpawnSource(float x, float y, int* ssx, int* ssy) const {
     return getClosestSpawnSource((int)x, (int)y, ssx, ssy);
   }
@@ -102,6 +123,7 @@ class Dungeon : public base::SaveListener {
   void getClosestSpawnSource(int x, int y, int* ssx, int* ssy) const;
   void updateCreatures(float elapsed);
   void killCreaturesAtRange(int radius);
+  void chooseStartingPosition(TCODRandom* rng);
   void setPlayerStartingPosition();
 
   // items
@@ -118,6 +140,14 @@ class Dungeon : public base::SaveListener {
   item::Item* getItem(int x, int y, const char* typeName);
   void addItem(item::Item* it);
   item::Item* removeItem(item::Item* it, int count = 1, bool del = true);
+  // an item on the ground moved from the cell xFrom,yFrom to its current position
+  void moveItem(item::Item* it, int xFrom, int yFrom);
+  // call f(item) for the items on the ground whose cell is at most radius cells away from the cell x,y.
+  // f must not add, remove nor move items
+  template <typename F>
+  void forEachItemInRadius(int x, int y, float radius, F&& f) const {
+    itemIndex.forEachInRadius(x, y, radius, f);
+  }
   void renderItems(map::LightMap& lightMap, TCODImage* ground = NULL);
   void updateItems(float elapsed, TCOD_key_t k, TCOD_mouse_t* mouse);
   void computeWalkTransp(int x, int y);
@@ -126,7 +156,9 @@ class Dungeon : public base::SaveListener {
   inline void setAmbient(const TCODColor& col) { ambient = col; }
   inline const TCODColor& getAmbient() { return ambient; }
   inline void addLight(map::Light* light) { lights.push(light); }
-  inline void removeLight(map::Light* light) { lights.removeFast(light); }
+  void removeLight(map::Light* light);
+  // can the light reach a cell on the console and in the player fov ? (conservative)
+  bool isLightVisible(const map::Light* light) const;
   void renderLightsToLightMap(
       map::LightMap& lightMap,
       int* minx = NULL,
@@ -163,6 +195,19 @@ class Dungeon : public base::SaveListener {
   inline float isCellWalkable(float x, float y) { return map->isWalkable((int)x, (int)y); }
   inline float getWaterCoef(int x2, int y2) const { return getSubCell(x2, y2)->waterCoef; }
   void setProperties(int x, int y, bool transparent, bool walkable);
+  // transparency changes. used to invalidate the lights fov cache
+  inline int getSerial() const { return serial; }
+  inline int getTransparencyVersion() const { return transparencyVersion; }
+  // did the transparency change in this part of the map (2x coords, inclusive) after sinceVersion ?
+  bool hasTransparencyChanged(int minx2x, int miny2x, int maxx2x, int maxy2x, int sinceVersion) const;
+  // walking distances to the player, shared by all the creatures tracking them.
+  // recomputed when the player changes cell or the walkability of the map changes
+  const map::FlowField& getPlayerFlowField();
+  // graph of the hierarchical pathfinder. repaired on demand when the walkability of the map changes
+  const map::ClusterGraph& getPathGraph();
+  // compute cr->pendingPath to destx,desty during a next updateCreatures. see map::PathService
+  inline void requestPath(mob::Creature* cr, int destx, int desty) { pathService.request(cr, destx, desty); }
+  inline bool isPathPending(const mob::Creature* cr) const { return pathService.isPending(cr); }
   inline void setTerrainType(int x, int y, map::TerrainId id) {
     cells[x + y * width].terrain = id;
     setWalkable(x, y, map::terrainTypes[id].walkable || map::terrainTypes[id].swimmable);
@@ -184,7 +229,7 @@ class Dungeon : public base::SaveListener {
   void setMemory(int x, int y);
 
   // apply blur to ground bitmap
-  void finalizeMap(bool roundCorners = true, bool blurGround = true);
+  void finalizeMap(util::GenerationContext* context, bool roundCorners = true, bool blurGround = true);
 
   // SaveListener
   bool loadData(uint32_t chunkId, uint32_t chunkVersion, TCODZip* zip);
@@ -198,11 +243,44 @@ class Dungeon : public base::SaveListener {
   TCODList<mob::Creature*> creaturesToAdd;
   bool isUpdatingCreatures;
   TCODColor ambient;  // ambient light
+  // where the creatures and the items on the ground stand, for the neighbourhood queries
+  map::SpatialIndex<mob::Creature> creatureIndex;
+  map::SpatialIndex<item::Item> itemIndex;
+  // index the items of the cell x,y after a change of its list
+  void reindexItems(int x, int y);
   util::CloudBox* clouds = nullptr;  // for outdoors
+  // unique among all the dungeons ever created, so that a cache never mistakes a new map for a deleted one
+  int serial;
+  // last cells (normal resolution) whose transparency changed. change n is at index (n - 1) % NB_TRANSPARENCY_CHANGES
+  static constexpr int NB_TRANSPARENCY_CHANGES = 64;
+  int transparencyVersion = 0;
+  int transparencyChanges[NB_TRANSPARENCY_CHANGES][2];
+  // incremented when a cell becomes walkable or unwalkable
+  int walkabilityVersion = 0;
+  map::FlowField playerFlowField;
+  int playerFlowFieldVersion = -1;
+  map::ClusterGraph pathGraph;
+  map::PathService pathService;
+  // closest walkable cell of each cell, for getClosestWalkable
+  mutable map::DistanceTransform nearestWalkable;
+  // repair the walkability caches after a change of x,y
+  void onWalkabilityChange(int x, int y);
+  // compute the requested paths within the frame budget
+  void updatePaths();
+  // incremented when computeFov changes the player fov
+  int fovVersion = 0;
+  // player position and transparency version of the last computeFov
+  int fovx = -1, fovy = -1, fovTransparencyVersion = -1;
+  // one flag per FOV_BLOCK x FOV_BLOCK cells, set if one of them was in the player fov on the console
+  static constexpr int FOV_BLOCK = 4;
+  int fovBlocksWidth = 0, fovBlocksHeight = 0;
+  std::vector<bool> fovBlocks;
+  // lightmap part lit by the lights removed since the last renderLightsToLightMap (max excluded)
+  int removedLightsMinx = 0, removedLightsMiny = 0, removedLightsMaxx = 0, removedLightsMaxy = 0;
 
-  void initData(util::CaveGenerator* caveGen);
+  void initData(util::CaveGenerator* caveGen, util::GenerationContext* context);
   void cleanData();
-  void getRandomPositionInCorner(int cornerx, int cornery, int* x, int* y);
+  void getRandomPositionInCorner(TCODRandom* rng, int cornerx, int cornery, int* x, int* y);
   void saveMap(int playerX, int playerY);
 };
 }  // namespace map
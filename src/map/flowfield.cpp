@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "map/flowfield.hpp"
+
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace map {
+void FlowField::compute(const TCODMap* map, int goalx, int goaly, int radius) {
+  compute(map, goalx, goaly, goalx - radius, goaly - radius, goalx + radius, goaly + radius, (float)radius);
+}
+
+void FlowField::compute(const TCODMap* map, int goalx, int goaly, int minx, int miny, int maxx, int maxy,
+                        float maxDistance, const ITCODPathCallback* cbk, void* userData) {
+  this->goalx = goalx;
+  this->goaly = goaly;
+  originx = minx;
+  originy = miny;
+  width = maxx - minx + 1;
+  height = maxy - miny + 1;
+  distances.assign(width * height, UNREACHABLE);
+  int mapw = map->getWidth();
+  int maph = map->getHeight();
+  if (goalx < minx || goaly < miny || goalx > maxx || goaly > maxy) return;
+  if (goalx < 0 || goaly < 0 || goalx >= mapw || goaly >= maph) return;
+  // cells to expand, closest first
+  typedef std::pair<float, int> Node;
+  std::priority_queue<Node, std::vector<Node>, std::greater<Node>> open;
+  int goal = (goalx - minx) + (goaly - miny) * width;
+  distances[goal] = 0.0f;
+  open.push(Node(0.0f, goal));
+  while (!open.empty()) {
+    Node node = open.top();
+    open.pop();
+    float dist = node.first;
+    if (dist > distances[node.second]) continue;  // already reached by a shorter path
+    int fx = node.second % width;
+    int fy = node.second / width;
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        if (dx == 0 && dy == 0) continue;
+        int nfx = fx + dx;
+        int nfy = fy + dy;
+        if (nfx < 0 || nfy < 0 || nfx >= width || nfy >= height) continue;
+        int x = nfx + originx;
+        int y = nfy + originy;
+        if (x < 0 || y < 0 || x >= mapw || y >= maph || !map->isWalkable(x, y)) continue;
+        // cost of the step from the neighbour to this cell, as the creatures walk toward the goal
+        float cost = 1.0f;
+        if (cbk) {
+          cost = cbk->getWalkCost(x, y, fx + originx, fy + originy, userData);
+          if (cost <= 0.0f) continue;
+        }
+        float newDist = dist + (dx != 0 && dy != 0 ? cost * DIAGONAL_COST : cost);
+        if (newDist > maxDistance) continue;
+        int index = nfx + nfy * width;
+        if (newDist < distances[index]) {
+          distances[index] = newDist;
+          open.push(Node(newDist, index));
+        }
+      }
+    }
+  }
+}
+}  // namespace map
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <float.h>
+
+#include <libtcod.hpp>
+#include <vector>
+
+namespace map {
+// walking distance to a goal cell from every cell around it, so that any number of creatures heading to the same
+// goal can walk down the gradient instead of computing a path each. dijkstra on the walkable cells of a map,
+// bounded to radius cells around the goal
+class FlowField {
+ public:
+  static constexpr float UNREACHABLE = FLT_MAX;
+  static constexpr float DIAGONAL_COST = 1.41f;  // same as TCODPath
+
+  void compute(const TCODMap* map, int goalx, int goaly, int radius);
+  // same, bounded to the cells minx,miny - maxx,maxy (inclusive) and to maxDistance.
+  // if cbk is not NULL, it gives the step costs between walkable cells (0 = blocked)
+  void compute(const TCODMap* map, int goalx, int goaly, int minx, int miny, int maxx, int maxy, float maxDistance,
+               const ITCODPathCallback* cbk = nullptr, void* userData = nullptr);
+  bool isValid() const { return !distances.empty(); }
+  int getGoalX() const { return goalx; }
+  int getGoalY() const { return goaly; }
+  // walking distance from x,y to the goal. UNREACHABLE out of the field or if the goal can't be reached in it
+  inline float getDistance(int x, int y) const {
+    int fx = x - originx;
+    int fy = y - originy;
+    if (fx < 0 || fy < 0 || fx >= width || fy >= height) return UNREACHABLE;
+    return distances[fx + fy * width];
+  }
+  inline bool isReachable(int x, int y) const { return getDistance(x, y) != UNREACHABLE; }
+  // neighbour of x,y the closest to the goal among those canEnter(nx, ny) accepts.
+  // false if none of them is closer to the goal than x,y
+  template <typename F>
+  bool getNextStep(int x, int y, int* nx, int* ny, F&& canEnter) const {
+    static constexpr int dirx[] = {-1, 0, 1, -1, 1, -1, 0, 1};
+    static constexpr int diry[] = {-1, -1, -1, 0, 0, 1, 1, 1};
+    float best = getDistance(x, y);
+    if (best == UNREACHABLE) return false;
+    bool found = false;
+    for (int i = 0; i < 8; i++) {
+      int cx = x + dirx[i];
+      int cy = y + diry[i];
+      float dist = getDistance(cx, cy);
+      if (dist < best && canEnter(cx, cy)) {
+        best = dist;
+        *nx = cx;
+        *ny = cy;
+        found = true;
+      }
+    }
+    return found;
+  }
+
+ protected:
+  int goalx = -1, goaly = -1;
+  int originx = 0, originy = 0;  // map cell of the first field cell
+  int width = 0, height = 0;
+  std::vector<float> distances;
+};
+}  // namespace map
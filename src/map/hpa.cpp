@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "map/hpa.hpp"
+
+#include <float.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "main.hpp"
+#include "map/dungeon.hpp"
+#include "map/flowfield.hpp"
+#include "util/profiler.hpp"
+
+namespace map {
+// octile distance. never more than the walking distance
+static float heuristic(int x, int y, int dx, int dy) {
+  int ax = abs(dx - x);
+  int ay = abs(dy - y);
+  return MAX(ax, ay) + (FlowField::DIAGONAL_COST - 1.0f) * MIN(ax, ay);
+}
+
+void ClusterGraph::setDirty(int x, int y) {
+  if (clusters.empty()) return;  // not built yet
+  Cluster& cluster = getCluster(x / clusterSize, y / clusterSize);
+  if (!cluster.dirty) {
+    cluster.dirty = true;
+    dirtyClusters.push_back(x / clusterSize + (y / clusterSize) * clustersWidth);
+  }
+}
+
+void ClusterGraph::getClusterRect(int x, int y, int* minx, int* miny, int* maxx, int* maxy) const {
+  *minx = (x / clusterSize) * clusterSize;
+  *miny = (y / clusterSize) * clusterSize;
+  *maxx = MIN(width - 1, *minx + clusterSize - 1);
+  *maxy = MIN(height - 1, *miny + clusterSize - 1);
+}
+
+void ClusterGraph::update(const TCODMap* map, int clusterSize) {
+  if (map != this->map || width != map->getWidth() || height != map->getHeight() ||
+      clusterSize != this->clusterSize) {
+    // new map. build everything
+    this->map = map;
+    this->clusterSize = clusterSize;
+    width = map->getWidth();
+    height = map->getHeight();
+    clustersWidth = (width + clusterSize - 1) / clusterSize;
+    clustersHeight = (height + clusterSize - 1) / clusterSize;
+    clusters.assign(clustersWidth * clustersHeight, Cluster());
+    dirtyClusters.clear();
+    for (int i = 0; i < clustersWidth * clustersHeight; i++) dirtyClusters.push_back(i);
+  }
+  if (dirtyClusters.empty()) return;
+  PROFILE_SCOPE("pathGraph");
+  // the transitions on the four borders of the dirty clusters
+  for (int id : dirtyClusters) {
+    int cx = id % clustersWidth;
+    int cy = id / clustersWidth;
+    buildTransitions(cx, cy, true);
+    buildTransitions(cx, cy, false);
+    if (cx > 0) buildTransitions(cx - 1, cy, true);
+    if (cy > 0) buildTransitions(cx, cy - 1, false);
+  }
+  // then the nodes of the dirty clusters and of their neighbours, whose transitions may have changed
+  std::vector<bool> rebuild(clusters.size(), false);
+  for (int id : dirtyClusters) {
+    int cx = id % clustersWidth;
+    int cy = id / clustersWidth;
+    rebuild[id] = true;
+    if (cx > 0) rebuild[id - 1] = true;
+    if (cx < clustersWidth - 1) rebuild[id + 1] = true;
+    if (cy > 0) rebuild[id - clustersWidth] = true;
+    if (cy < clustersHeight - 1) rebuild[id + clustersWidth] = true;
+    clusters[id].dirty = false;
+  }
+  dirtyClusters.clear();
+  for (int id = 0; id < (int)clusters.size(); id++) {
+    if (rebuild[id]) buildNodes(id % clustersWidth, id / clustersWidth);
+  }
+}
+
+void ClusterGraph::buildTransitions(int cx, int cy, bool east) {
+  Cluster& cluster = getCluster(cx, cy);
+  std::vector<Transition>& transitions = east ? cluster.east : cluster.south;
+  transitions.clear();
+  if (east ? cx == clustersWidth - 1 : cy == clustersHeight - 1) return;
+  int minx, miny, maxx, maxy;
+  getClusterRect(cx * clusterSize, cy * clusterSize, &minx, &miny, &maxx, &maxy);
+  // cell i of the border of this cluster and cell j of the neighbour border
+  auto addTransition = [&](int i, int j) {
+    if (east) {
+      transitions.push_back(Transition{maxx, miny + i, maxx + 1, miny + j});
+    } else {
+      transitions.push_back(Transition{minx + i, maxy, minx + j, maxy + 1});
+    }
+  };
+  auto isOpen = [&](int i, int j) {
+    return east ? map->isWalkable(maxx, miny + i) && map->isWalkable(maxx + 1, miny + j)
+                : map->isWalkable(minx + i, maxy) && map->isWalkable(minx + j, maxy + 1);
+  };
+  int len = east ? maxy - miny + 1 : maxx - minx + 1;
+  int start = -1;
+  for (int i = 0; i <= len; i++) {
+    bool open = i < len && isOpen(i, i);
+    if (open && start < 0) {
+      start = i;
+    } else if (!open && start >= 0) {
+      int end = i - 1;
+      if (end - start + 1 < MAX_ENTRANCE_WIDTH) {
+        addTransition((start + end) / 2, (start + end) / 2);
+      } else {
+        addTransition(start, start);
+        addTransition(end, end);
+      }
+      start = -1;
+    }
+  }
+  // openings that can only be crossed diagonally
+  for (int i = 0; i + 1 < len; i++) {
+    if (isOpen(i, i) || isOpen(i + 1, i + 1)) continue;
+    if (isOpen(i, i + 1)) addTransition(i, i + 1);
+    if (isOpen(i + 1, i)) addTransition(i + 1, i);
+  }
+}
+
+void ClusterGraph::buildNodes(int cx, int cy) {
+  Cluster& cluster = getCluster(cx, cy);
+  std::vector<Node>& nodes = cluster.nodes;
+  nodes.clear();
+  // one node per transition cell, with an edge to the cell on the other side of the border
+  auto addEntrance = [&nodes, this](int x, int y, int nx, int ny) {
+    size_t i = 0;
+    while (i < nodes.size() && (nodes[i].x != x || nodes[i].y != y)) i++;
+    if (i == nodes.size()) nodes.push_back(Node{x, y, {}});
+    nodes[i].edges.push_back(Edge{nx + ny * width, x != nx && y != ny ? FlowField::DIAGONAL_COST : 1.0f});
+  };
+  for (const Transition& t : cluster.east) addEntrance(t.x, t.y, t.nx, t.ny);
+  for (const Transition& t : cluster.south) addEntrance(t.x, t.y, t.nx, t.ny);
+  if (cx > 0) {
+    for (const Transition& t : getCluster(cx - 1, cy).east) addEntrance(t.nx, t.ny, t.x, t.y);
+  }
+  if (cy > 0) {
+    for (const Transition& t : getCluster(cx, cy - 1).south) addEntrance(t.nx, t.ny, t.x, t.y);
+  }
+  // walking distances between the nodes, inside the cluster
+  int minx, miny, maxx, maxy;
+  getClusterRect(cx * clusterSize, cy * clusterSize, &minx, &miny, &maxx, &maxy);
+  FlowField field;
+  for (size_t i = 0; i + 1 < nodes.size(); i++) {
+    field.compute(map, nodes[i].x, nodes[i].y, minx, miny, maxx, maxy, FLT_MAX);
+    for (size_t j = i + 1; j < nodes.size(); j++) {
+      float dist = field.getDistance(nodes[j].x, nodes[j].y);
+      if (dist == FlowField::UNREACHABLE) continue;
+      nodes[i].edges.push_back(Edge{nodes[j].x + nodes[j].y * width, dist});
+      nodes[j].edges.push_back(Edge{nodes[i].x + nodes[i].y * width, dist});
+    }
+  }
+}
+
+const ClusterGraph::Node* ClusterGraph::getNode(int x, int y) const {
+  const Cluster& cluster = clusters[x / clusterSize + (y / clusterSize) * clustersWidth];
+  for (const Node& node : cluster.nodes) {
+    if (node.x == x && node.y == y) return &node;
+  }
+  return nullptr;
+}
+
+bool ClusterGraph::findWaypoints(int ox, int oy, int dx, int dy, std::vector<int>* waypoints) const {
+  waypoints->clear();
+  if (clusters.empty() || !map->isWalkable(dx, dy)) return false;
+  int origin = ox + oy * width;
+  int goal = dx + dy * width;
+  int ominx, ominy, omaxx, omaxy;
+  getClusterRect(ox, oy, &ominx, &ominy, &omaxx, &omaxy);
+  int gminx, gminy, gmaxx, gmaxy;
+  getClusterRect(dx, dy, &gminx, &gminy, &gmaxx, &gmaxy);
+  // distances to the destination inside its cluster
+  FlowField goalField;
+  goalField.compute(map, dx, dy, gminx, gminy, gmaxx, gmaxy, FLT_MAX);
+  if (goalField.isReachable(ox, oy)) {
+    // same cluster. no need for the graph
+    waypoints->push_back(origin);
+    waypoints->push_back(goal);
+    return true;
+  }
+  // distances from the origin inside its cluster
+  FlowField originField;
+  originField.compute(map, ox, oy, ominx, ominy, omaxx, omaxy, FLT_MAX);
+  const std::vector<Node>& originNodes = clusters[ox / clusterSize + (oy / clusterSize) * clustersWidth].nodes;
+  // A* on the graph, with the origin and the destination linked to the nodes of their clusters
+  typedef std::pair<float, int> Open;
+  std::priority_queue<Open, std::vector<Open>, std::greater<Open>> open;
+  std::unordered_map<int, float> costs;
+  std::unordered_map<int, int> parents;
+  std::unordered_set<int> closed;
+  costs[origin] = 0.0f;
+  open.push(Open(heuristic(ox, oy, dx, dy), origin));
+  bool found = false;
+  while (!open.empty()) {
+    int cell = open.top().second;
+    open.pop();
+    if (!closed.insert(cell).second) continue;
+    if (cell == goal) {
+      found = true;
+      break;
+    }
+    float cost = costs[cell];
+    auto relax = [&](int to, float stepCost) {
+      float newCost = cost + stepCost;
+      auto it = costs.find(to);
+      if (it != costs.end() && it->second <= newCost) return;
+      costs[to] = newCost;
+      parents[to] = cell;
+      open.push(Open(newCost + heuristic(to % width, to / width, dx, dy), to));
+    };
+    int x = cell % width;
+    int y = cell / width;
+    if (cell == origin) {
+      for (const Node& node : originNodes) {
+        float dist = originField.getDistance(node.x, node.y);
+        if (dist != FlowField::UNREACHABLE) relax(node.x + node.y * width, dist);
+      }
+    }
+    if (const Node* node = getNode(x, y)) {
+      for (const Edge& edge : node->edges) relax(edge.cell, edge.cost);
+      float dist = goalField.getDistance(x, y);
+      if (dist != FlowField::UNREACHABLE) relax(goal, dist);
+    }
+  }
+  if (!found) return false;
+  for (int cell = goal; cell != origin; cell = parents[cell]) waypoints->push_back(cell);
+  waypoints->push_back(origin);
+  std::reverse(waypoints->begin(), waypoints->end());
+  return true;
+}
+
+bool HierarchicalPath::canWalk(int xFrom, int yFrom, int xTo, int yTo) const {
+  if (!gameEngine->dungeon->map->isWalkable(xTo, yTo)) return false;
+  return !cbk || cbk->getWalkCost(xFrom, yFrom, xTo, yTo, userData) > 0.0f;
+}
+
+bool HierarchicalPath::compute(int ox, int oy, int dx, int dy) {
+  return computeOnGraph(gameEngine->dungeon->getPathGraph(), ox, oy, dx, dy);
+}
+
+bool HierarchicalPath::computeOnGraph(const ClusterGraph& graph, int ox, int oy, int dx, int dy) {
+  curx = ox;
+  cury = oy;
+  destx = dx;
+  desty = dy;
+  steps.clear();
+  next = 0;
+  const Dungeon* dungeon = gameEngine->dungeon;
+  std::vector<int> waypoints;
+  if (!graph.findWaypoints(ox, oy, dx, dy, &waypoints)) return false;
+  // refine the path between each waypoint and the next, inside the cluster of the latter
+  int width = dungeon->map->getWidth();
+  FlowField field;
+  int x = ox, y = oy;
+  for (size_t i = 1; i < waypoints.size(); i++) {
+    int wx = waypoints[i] % width;
+    int wy = waypoints[i] / width;
+    int minx, miny, maxx, maxy;
+    graph.getClusterRect(wx, wy, &minx, &miny, &maxx, &maxy);
+    if (x < minx || x > maxx || y < miny || y > maxy) {
+      // step across a cluster border
+      if (!canWalk(x, y, wx, wy)) {
+        steps.clear();
+        return false;
+      }
+      x = wx;
+      y = wy;
+      steps.push_back(std::make_pair(x, y));
+      continue;
+    }
+    field.compute(dungeon->map, wx, wy, minx, miny, maxx, maxy, FLT_MAX, cbk, userData);
+    while (x != wx || y != wy) {
+      if (!field.getNextStep(x, y, &x, &y, [](int, int) { return true; })) {
+        // the step costs forbid this part of the path
+        steps.clear();
+        return false;
+      }
+      steps.push_back(std::make_pair(x, y));
+    }
+  }
+  return true;
+}
+
+bool HierarchicalPath::walk(int* x, int* y, bool recalculateWhenNeeded) {
+  if (isEmpty()) return false;
+  if (!canWalk(curx, cury, steps[next].first, steps[next].second)) {
+    if (!recalculateWhenNeeded || !compute(curx, cury, destx, desty) || isEmpty()) return false;
+  }
+  curx = steps[next].first;
+  cury = steps[next].second;
+  next++;
+  *x = curx;
+  *y = cury;
+  return true;
+}
+}  // namespace map
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <libtcod.hpp>
+#include <utility>
+#include <vector>
+
+#include "map/path.hpp"
+
+namespace map {
+// abstract graph of the hierarchical pathfinder (HPA*). the map is split in square clusters. the walkable openings
+// between two clusters get one transition (two for wide openings) and the transition cells of a cluster are linked
+// by their walking distance inside the cluster. a path is searched on this graph, then refined cluster by cluster
+class ClusterGraph {
+ public:
+  static constexpr int MAX_ENTRANCE_WIDTH = 6;  // wider openings get a transition at each end
+
+  // the walkability of x,y changed. its cluster is rebuilt on the next update
+  void setDirty(int x, int y);
+  // build the graph for this map, or repair the dirty clusters
+  void update(const TCODMap* map, int clusterSize);
+  // cells (x + y * map width) of a walkable path from ox,oy to dx,dy, origin and destination included.
+  // two successive cells are either in the same cluster or neighbours on each side of a cluster border
+  bool findWaypoints(int ox, int oy, int dx, int dy, std::vector<int>* waypoints) const;
+  int getClusterSize() const { return clusterSize; }
+  // cells of the cluster containing x,y (inclusive)
+  void getClusterRect(int x, int y, int* minx, int* miny, int* maxx, int* maxy) const;
+
+ protected:
+  struct Edge {
+    int cell;
+    float cost;
+  };
+  struct Node {
+    int x, y;
+    std::vector<Edge> edges;
+  };
+  // x,y in the cluster, nx,ny in its east or south neighbour
+  struct Transition {
+    int x, y, nx, ny;
+  };
+  struct Cluster {
+    std::vector<Transition> east, south;
+    std::vector<Node> nodes;
+    bool dirty = true;
+  };
+
+  const TCODMap* map = nullptr;
+  int width = 0, height = 0;  // map size
+  int clusterSize = 0;
+  int clustersWidth = 0, clustersHeight = 0;
+  std::vector<Cluster> clusters;
+  std::vector<int> dirtyClusters;
+
+  inline Cluster& getCluster(int cx, int cy) { return clusters[cx + cy * clustersWidth]; }
+  const Node* getNode(int x, int y) const;
+  void buildTransitions(int cx, int cy, bool east);
+  void buildNodes(int cx, int cy);
+};
+
+// long range path searched on the cluster graph of the current dungeon. the step costs of cbk are only used when
+// refining the path inside each cluster, the clusters themselves are chosen on walkability
+class HierarchicalPath : public Path {
+ public:
+  HierarchicalPath(const ITCODPathCallback* cbk, void* userData) : cbk(cbk), userData(userData) {}
+  bool compute(int ox, int oy, int dx, int dy) override;
+  bool computeOnGraph(const ClusterGraph& graph, int ox, int oy, int dx, int dy) override;
+  bool walk(int* x, int* y, bool recalculateWhenNeeded) override;
+  bool isEmpty() const override { return next >= (int)steps.size(); }
+  int size() const override { return (int)steps.size() - next; }
+  void get(int index, int* x, int* y) const override {
+    *x = steps[next + index].first;
+    *y = steps[next + index].second;
+  }
+  void getDestination(int* x, int* y) const override {
+    *x = destx;
+    *y = desty;
+  }
+
+ protected:
+  const ITCODPathCallback* cbk;
+  void* userData;
+  int curx = -1, cury = -1, destx = -1, desty = -1;
+  std::vector<std::pair<int, int>> steps;  // origin excluded
+  int next = 0;  // index in steps of the next step
+
+  bool canWalk(int xFrom, int yFrom, int xTo, int yTo) const;
+};
+}  // namespace map
@@ -26,45 +26,208 @@
 #include "map/light.hpp"
 
 #include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
 
 #include "main.hpp"
 #include "map/lightmap.hpp"
 
 namespace map {
-void Light::addToLightMap(map::LightMap& lightmap) { add(&lightmap, nullptr); }
-void Light::addToImage(TCODImage& img) { add(nullptr, &img); }
+// angle bucket of each offset from the light, so that the lit subcells don't need an atan2f
+static constexpr int ANGLE_TABLE_RANGE = 64;
+
+static int computeAngleBucket(int dx, int dy) {
+  float angle = atan2f(dy, dx);
+  int bucket = (int)((angle + M_PI) * Light::NB_ANGLES / (2 * M_PI));
+  return MIN(Light::NB_ANGLES - 1, bucket);
+}
+
+static inline int getAngleBucket(int dx, int dy) {
+  static constexpr int TABLE_WIDTH = 2 * ANGLE_TABLE_RANGE + 1;
+  static const std::vector<uint8_t> table = [] {
+    std::vector<uint8_t> table(TABLE_WIDTH * TABLE_WIDTH);
+    for (int y = -ANGLE_TABLE_RANGE; y <= ANGLE_TABLE_RANGE; y++) {
+      for (int x = -ANGLE_TABLE_RANGE; x <= ANGLE_TABLE_RANGE; x++) {
+        table[x + ANGLE_TABLE_RANGE + (y + ANGLE_TABLE_RANGE) * TABLE_WIDTH] = (uint8_t)computeAngleBucket(x, y);
+      }
+    }
+    return table;
+  }();
+  if (ABS(dx) > ANGLE_TABLE_RANGE || ABS(dy) > ANGLE_TABLE_RANGE) return computeAngleBucket(dx, dy);
+  return table[dx + ANGLE_TABLE_RANGE + (dy + ANGLE_TABLE_RANGE) * TABLE_WIDTH];
+}
+
+void Light::addToLightMap(map::LightMap& lightmap) {
+  prepare();
+  add(&lightmap, nullptr, 0, 0, lightmap.width, lightmap.height);
+}
 
-void Light::add(map::LightMap* l, TCODImage* img) {
+void Light::addToLightMap(map::LightMap& lightmap, int minx, int miny, int maxx, int maxy) {
+  add(&lightmap, nullptr, minx, miny, maxx, maxy);
+}
+
+void Light::addToImage(TCODImage& img) {
+  int iw, ih;
+  img.getSize(&iw, &ih);
+  prepare();
+  add(nullptr, &img, 0, 0, iw, ih);
+}
+
+void Light::prepare(bool lowRes) {
   if (this->range == 0.0f) return;
+  updateFovCache(lowRes);
+  updateFalloff();
+}
+
+bool Light::getLightMapPart(int width, int height, int* minx, int* miny, int* maxx, int* maxy) const {
+  if (this->range == 0.0f) return false;
   // get light range in dungeon coordinates
-  int minx = (int)(this->x - this->range);
-  int maxx = (int)(this->x + this->range);
-  int miny = (int)(this->y - this->range);
-  int maxy = (int)(this->y + this->range);
+  *minx = fovCache.minx;
+  *maxx = fovCache.minx + fovCache.width;
+  *miny = fovCache.miny;
+  *maxy = fovCache.miny + fovCache.height;
+  if (fovCache.lowRes) {
+    // the upsample bleeds one subcell around the lit cells
+    *minx = *minx * 2 - 1;
+    *maxx = *maxx * 2 + 1;
+    *miny = *miny * 2 - 1;
+    *maxy = *maxy * 2 + 1;
+  }
   int xOffset = gameEngine->xOffset * 2;
   int yOffset = gameEngine->yOffset * 2;
-  // clamp it to the dungeon
-  minx = MAX(0, minx);
-  miny = MAX(0, miny);
-  maxx = MIN(gameEngine->dungeon->width * 2 - 1, maxx);
-  maxy = MIN(gameEngine->dungeon->height * 2 - 1, maxy);
   // convert it to lightmap (console x2) coordinates
-  minx -= xOffset;
-  maxx -= xOffset;
-  miny -= yOffset;
-  maxy -= yOffset;
+  *minx -= xOffset;
+  *maxx -= xOffset;
+  *miny -= yOffset;
+  *maxy -= yOffset;
   // clamp it to the lightmap
+  *minx = MAX(0, *minx);
+  *miny = MAX(0, *miny);
+  *maxx = MIN(width - 1, *maxx);
+  *maxy = MIN(height - 1, *maxy);
+  return *maxx > *minx && *maxy > *miny;
+}
+
+void Light::updateFovCache(bool lowRes) {
+  map::Dungeon* dungeon = gameEngine->dungeon;
+  int lightx = (int)x;
+  int lighty = (int)y;
+  int irange = (int)range;
+  int minx, miny, maxx, maxy;
+  getDungeonPart(&minx, &miny, &maxx, &maxy);
+  // clamp it to the dungeon
   minx = MAX(0, minx);
   miny = MAX(0, miny);
+  maxx = MIN(dungeon->width * 2 - 1, maxx);
+  maxy = MIN(dungeon->height * 2 - 1, maxy);
+  // fov on the cells covering the subcells
+  int fovminx = lowRes ? minx / 2 : minx;
+  int fovminy = lowRes ? miny / 2 : miny;
+  int fovmaxx = lowRes ? MIN(dungeon->width, maxx / 2 + 1) : maxx;
+  int fovmaxy = lowRes ? MIN(dungeon->height, maxy / 2 + 1) : maxy;
+  if (fovCache.lowRes == lowRes && fovCache.dungeonSerial == dungeon->getSerial() && fovCache.lightx == lightx &&
+      fovCache.lighty == lighty && fovCache.range == irange && fovCache.minx == fovminx && fovCache.miny == fovminy &&
+      fovCache.width == fovmaxx - fovminx && fovCache.height == fovmaxy - fovminy &&
+      !dungeon->hasTransparencyChanged(minx, miny, maxx, maxy, fovCache.transparencyVersion)) {
+    fovCache.transparencyVersion = dungeon->getTransparencyVersion();
+    return;
+  }
+  fovCache.lowRes = lowRes;
+  fovCache.dungeonSerial = dungeon->getSerial();
+  fovCache.transparencyVersion = dungeon->getTransparencyVersion();
+  fovCache.lightx = lightx;
+  fovCache.lighty = lighty;
+  fovCache.range = irange;
+  fovCache.minx = fovminx;
+  fovCache.miny = fovminy;
+  fovCache.width = fovmaxx - fovminx;
+  fovCache.height = fovmaxy - fovminy;
+  fovCache.generation++;
+  if (fovCache.width <= 0 || fovCache.height <= 0) {
+    fovCache.inFov.clear();
+    return;
+  }
+  // create a small map for the light fov
+  TCODMap fovmap(fovCache.width, fovCache.height);
+  // copy dungeon info into it
+  TCODMap* dungeonMap = lowRes ? dungeon->map : dungeon->map2x;
+  for (int cx = 0; cx < fovCache.width; cx++) {
+    for (int cy = 0; cy < fovCache.height; cy++) {
+      bool canpass = dungeonMap->isTransparent(cx + fovminx, cy + fovminy);
+      fovmap.setProperties(cx, cy, canpass, canpass);
+    }
+  }
+  // calculate light fov
+  // the fov algo must support viewer out of the map !
+  if (lowRes) {
+    fovmap.computeFov((int)(this->x / 2 - fovminx), (int)(this->y / 2 - fovminy), (irange + 1) / 2, true, FOV_BASIC);
+  } else {
+    fovmap.computeFov((int)(this->x - minx), (int)(this->y - miny), irange, true, FOV_BASIC);
+  }
+  fovCache.inFov.resize(fovCache.width * fovCache.height);
+  for (int cy = 0; cy < fovCache.height; cy++) {
+    for (int cx = 0; cx < fovCache.width; cx++) {
+      fovCache.inFov[cx + cy * fovCache.width] = fovmap.isInFov(cx, cy);
+    }
+  }
+}
+
+void Light::updateFalloff() {
+  float squaredRange = range * range;
+  if (falloffRange != range || falloffRandomRad != randomRad || falloffNoiseOffset != noiseOffset) {
+    falloffRange = range;
+    falloffRandomRad = randomRad;
+    falloffNoiseOffset = noiseOffset;
+    invSquaredRange[0] = 1.0f / squaredRange;
+    if (randomRad) {
+      for (int i = 0; i < NB_ANGLES; i++) {
+        float angle = (i + 0.5f) * 2 * M_PI / NB_ANGLES - M_PI;
+        float f = angle + noiseOffset;
+        float squaredRangeRnd = squaredRange * (0.5f * (1.0f + noise1d.get(&f)));
+        // fix radius continuity near -PI
+        float rcoef = 0.0f;
+        if (angle < -7 * M_PI / 8) rcoef = (-7 * M_PI / 8 - angle) / (M_PI / 8);
+        if (rcoef > 1E-6f) {
+          float fpi = M_PI + noiseOffset;
+          float squaredRangePi = squaredRange * (0.5f * (1.0f + noise1d.get(&fpi)));
+          squaredRangeRnd = squaredRangeRnd + rcoef * (squaredRangePi - squaredRangeRnd);
+        }
+        invSquaredRange[i] = 1.0f / squaredRangeRnd;
+      }
+    }
+  }
+  // the intensity and color patterns change every frame
+  float intensity = getIntensity();
+  for (int i = 0; i < NB_RADS; i++) radColors[i] = getColor((float)i / (NB_RADS - 1)) * intensity;
+}
+
+map::HDRColor Light::getLightAt(float dx, float dy) const {
+  float crange = dx * dx + dy * dy;
+  float rad = crange * (randomRad ? invSquaredRange[getAngleBucket((int)dx, (int)dy)] : invSquaredRange[0]);
+  // also catches the nan of a null random range
+  rad = MIN(rad, 1.0f);
+  // out of range subcells get a null coef
+  float coef = 1.0f - rad;
+  return radColors[(int)(rad * (NB_RADS - 1))] * coef;
+}
+
+void Light::add(map::LightMap* l, TCODImage* img, int clipminx, int clipminy, int clipmaxx, int clipmaxy) {
+  int minx, miny, maxx, maxy;
   if (l) {
-    maxx = MIN(l->width - 1, maxx);
-    maxy = MIN(l->height - 1, maxy);
+    if (!getLightMapPart(l->width, l->height, &minx, &miny, &maxx, &maxy)) return;
   } else {
     int iw, ih;
     img->getSize(&iw, &ih);
-    maxx = MIN(iw - 1, maxx);
-    maxy = MIN(ih - 1, maxy);
+    if (!getLightMapPart(iw, ih, &minx, &miny, &maxx, &maxy)) return;
   }
+  // clamp it to the part being rendered
+  minx = MAX(clipminx, minx);
+  miny = MAX(clipminy, miny);
+  maxx = MIN(clipmaxx, maxx);
+  maxy = MIN(clipmaxy, maxy);
+  int xOffset = gameEngine->xOffset * 2;
+  int yOffset = gameEngine->yOffset * 2;
 
   int fovmap_width = maxx - minx;
   int fovmap_height = maxy - miny;
@@ -72,77 +235,119 @@ void Light::add(map::LightMap* l, TCODImage* img) {
   // watch out ! 3 different coordinates referentials here
   // dungeon (xOffset, yOffset, this->x, this->y)
   // lightmap (minx,maxx,miny,maxy)
-  // fovmap : subpart of lightmap to compute light fov
+  // fovmap : subpart of lightmap lit by the light
+  // fovCache : part of the dungeon hit by the light
 
   if (fovmap_width <= 0 || fovmap_height <= 0) return;
-  // create a small map for the light fov
-  TCODMap fovmap(fovmap_width, fovmap_height);
-  // copy dungeon info into it
-  for (int cx = 0; cx < fovmap_width; cx++) {
-    for (int cy = 0; cy < fovmap_height; cy++) {
-      int dungeon2x = cx + minx + xOffset;
-      int dungeon2y = cy + miny + yOffset;
-      bool canpass = gameEngine->dungeon->map2x->isTransparent(dungeon2x, dungeon2y);
-      fovmap.setProperties(cx, cy, canpass, canpass);
-    }
-  }
-  // calculate light fov
-  // the fov algo must support viewer out of the map !
-  fovmap.computeFov((int)(this->x - xOffset - minx), (int)(this->y - yOffset - miny), (int)(range), true, FOV_BASIC);
+  // offset of the fovmap in the cached light fov
+  int cachex = minx + xOffset - fovCache.minx;
+  int cachey = miny + yOffset - fovCache.miny;
 
-  float squaredRange = range * range;
   TCODMap* map2x = gameEngine->dungeon->map2x;
+  // light added to the current lightmap row, accumulated in one pass once the row is done
+  static thread_local std::vector<float> rowr, rowg, rowb;
+  if (l) {
+    rowr.resize(fovmap_width);
+    rowg.resize(fovmap_width);
+    rowb.resize(fovmap_width);
+  }
   // get fov data and add light to lightmap
-  for (int cx = 0; cx < fovmap_width; cx++) {
-    for (int cy = 0; cy < fovmap_height; cy++) {
-      if (fovmap.isInFov(cx, cy)) {
+  for (int cy = 0; cy < fovmap_height; cy++) {
+    if (l) {
+      std::fill(rowr.begin(), rowr.end(), 0.0f);
+      std::fill(rowg.begin(), rowg.end(), 0.0f);
+      std::fill(rowb.begin(), rowb.end(), 0.0f);
+    }
+    for (int cx = 0; cx < fovmap_width; cx++) {
+      if (fovCache.inFov[cx + cachex + (cy + cachey) * fovCache.width]) {
         int dungeon2x = cx + minx + xOffset;
         int dungeon2y = cy + miny + yOffset;
         if (map2x->isInFov(dungeon2x, dungeon2y)) {
-          int dx = (int)(dungeon2x - this->x);
-          int dy = (int)(dungeon2y - this->y);
-          float crange = dx * dx + dy * dy;
-          float coef;
-          float rad = 0.0f;
-          if (randomRad) {
-            float angle = atan2f(dy, dx);
-            float f = angle + noiseOffset;
-            float squaredRangeRnd = squaredRange * (0.5f * (1.0f + noise1d.get(&f)));
-            // fix radius continuity near -PI
-            float rcoef = 0.0f;
-            if (angle < -7 * M_PI / 8) rcoef = (-7 * M_PI / 8 - angle) / (M_PI / 8);
-            if (rcoef > 1E-6f) {
-              float fpi = M_PI + noiseOffset;
-              float squaredRangePi = squaredRange * (0.5f * (1.0f + noise1d.get(&fpi)));
-              squaredRangeRnd = squaredRangeRnd + rcoef * (squaredRangePi - squaredRangeRnd);
-            }
-            rad = crange / squaredRangeRnd;
-            rad = MIN(1.0f, rad);
-            coef = 1.0f - rad;
+          map::HDRColor col = getLightAt((int)(dungeon2x - this->x), (int)(dungeon2y - this->y));
+          if (l) {
+            rowr[cx] = col.r;
+            rowg[cx] = col.g;
+            rowb[cx] = col.b;
           } else {
-            rad = crange / squaredRange;
-            rad = MIN(1.0f, rad);
-            coef = 1.0f - rad;
-          }
-          if (coef > 0.0f) {
-            map::HDRColor col = getColor(rad);
-
-            float intensity = getIntensity();
-            coef *= intensity;
-            if (l) {
-              map::HDRColor prevCol = l->getHdrColor2x(cx + minx, cy + miny);
-              prevCol = prevCol + (col * coef);
-              l->setColor2x(cx + minx, cy + miny, prevCol);
-            } else {
-              map::HDRColor prevCol = img->getPixel(cx + minx, cy + miny);
-              prevCol = prevCol + (col * coef);
-              img->putPixel(cx + minx, cy + miny, prevCol);
-            }
+            map::HDRColor prevCol = img->getPixel(cx + minx, cy + miny);
+            prevCol = prevCol + col;
+            img->putPixel(cx + minx, cy + miny, prevCol);
           }
         }
       }
     }
+    if (l) l->accumulate(minx, cy + miny, fovmap_width, rowr.data(), rowg.data(), rowb.data());
+  }
+}
+
+void Light::addToLowResLightMap(map::LightMap& lightmap, int clipminx, int clipminy, int clipmaxx, int clipmaxy) {
+  if (this->range == 0.0f || !fovCache.lowRes || fovCache.inFov.empty()) return;
+  int xOffset = gameEngine->xOffset;
+  int yOffset = gameEngine->yOffset;
+  // console cells lit by the light, clamped to the part being rendered
+  int minx = MAX(clipminx, fovCache.minx - xOffset);
+  int miny = MAX(clipminy, fovCache.miny - yOffset);
+  int maxx = MIN(clipmaxx, fovCache.minx + fovCache.width - xOffset);
+  int maxy = MIN(clipmaxy, fovCache.miny + fovCache.height - yOffset);
+  if (maxx <= minx || maxy <= miny) return;
+  TCODMap* map = gameEngine->dungeon->map;
+  static thread_local std::vector<float> rowr, rowg, rowb;
+  rowr.resize(maxx - minx);
+  rowg.resize(maxx - minx);
+  rowb.resize(maxx - minx);
+  for (int cy = miny; cy < maxy; cy++) {
+    std::fill(rowr.begin(), rowr.end(), 0.0f);
+    std::fill(rowg.begin(), rowg.end(), 0.0f);
+    std::fill(rowb.begin(), rowb.end(), 0.0f);
+    int dungeony = cy + yOffset;
+    for (int cx = minx; cx < maxx; cx++) {
+      int dungeonx = cx + xOffset;
+      if (fovCache.inFov[dungeonx - fovCache.minx + (dungeony - fovCache.miny) * fovCache.width] &&
+          map->isInFov(dungeonx, dungeony)) {
+        // sampled at the cell center
+        map::HDRColor col = getLightAt(dungeonx * 2 + 0.5f - this->x, dungeony * 2 + 0.5f - this->y);
+        rowr[cx - minx] = col.r;
+        rowg[cx - minx] = col.g;
+        rowb[cx - minx] = col.b;
+      }
+    }
+    lightmap.accumulateLowRes(minx, cy, maxx - minx, rowr.data(), rowg.data(), rowb.data());
+  }
+}
+
+bool Light::hasChanged() const {
+  if (!rendered.valid || rendered.x != x || rendered.y != y || rendered.range != range ||
+      rendered.randomRad != randomRad || rendered.noiseOffset != noiseOffset ||
+      rendered.fovGeneration != fovCache.generation)
+    return true;
+  for (int i = 0; i < NB_RADS; i++) {
+    if (rendered.radColors[i] != radColors[i]) return true;
   }
+  return false;
+}
+
+void Light::markRendered(int minx, int miny, int maxx, int maxy) {
+  rendered.valid = true;
+  rendered.minx = minx;
+  rendered.miny = miny;
+  rendered.maxx = maxx;
+  rendered.maxy = maxy;
+  rendered.x = x;
+  rendered.y = y;
+  rendered.range = range;
+  rendered.randomRad = randomRad;
+  rendered.noiseOffset = noiseOffset;
+  rendered.fovGeneration = fovCache.generation;
+  for (int i = 0; i < NB_RADS; i++) rendered.radColors[i] = radColors[i];
+}
+
+bool Light::getRenderedPart(int* minx, int* miny, int* maxx, int* maxy) const {
+  if (!rendered.valid || rendered.maxx <= rendered.minx || rendered.maxy <= rendered.miny) return false;
+  *minx = rendered.minx;
+  *miny = rendered.miny;
+  *maxx = rendered.maxx;
+  *maxy = rendered.maxy;
+  return true;
 }
 
 // part of the dungeon that this light can hit (2x coords)
@@ -25,6 +25,7 @@
  */
 #pragma once
 #include <libtcod.hpp>
+#include <vector>
 
 #include "base/entity.hpp"
 #include "base/noisything.hpp"
@@ -33,11 +34,33 @@
 namespace map {
 class Light : public base::Entity, public base::NoisyThing {
  public:
+  // falloff table sizes
+  static constexpr int NB_ANGLES = 256;
+  static constexpr int NB_RADS = 64;
+
   Light() : randomRad(false), range(0.0f), color{tcod::ColorRGB{255, 255, 255}} {}
   Light(float range, TCODColor color = TCODColor::white, bool randomRad = false)
       : randomRad(randomRad), range(range), color(color) {}
+  virtual ~Light() = default;
   void addToLightMap(map::LightMap& map);
   void addToImage(TCODImage& img);
+  // update the light fov and falloff. the only part of the rendering that writes to the light.
+  // lowRes : compute the fov on the console cells instead of the subcells, see LightMap::lowRes
+  void prepare(bool lowRes = false);
+  // add the prepared light to a part of the lightmap (max excluded). can run on several threads at once
+  void addToLightMap(map::LightMap& map, int minx, int miny, int maxx, int maxy);
+  // same for a light prepared in low res, on the console cells minx <= x < maxx, miny <= y < maxy
+  void addToLowResLightMap(map::LightMap& map, int minx, int miny, int maxx, int maxy);
+  // part of a width x height lightmap lit by the prepared light (max excluded). false if none
+  bool getLightMapPart(int width, int height, int* minx, int* miny, int* maxx, int* maxy) const;
+  // incremental rendering. did the prepared light change since markRendered ?
+  bool hasChanged() const;
+  // remember the prepared light and the lightmap part it was rendered to
+  void markRendered(int minx, int miny, int maxx, int maxy);
+  // forget the last render. the light is no longer in the lightmap
+  void resetRendered() { rendered.valid = false; }
+  // lightmap part of the last render (max excluded). false if none
+  bool getRenderedPart(int* minx, int* miny, int* maxx, int* maxy) const;
   void getDungeonPart(int* minx, int* miny, int* maxx, int* maxy);
   virtual void update([[maybe_unused]] float elapsed) {}
 
@@ -46,10 +69,45 @@ class Light : public base::Entity, public base::NoisyThing {
   map::HDRColor color;
 
  protected:
-  void add(map::LightMap* l, TCODImage* i);
+  void add(map::LightMap* l, TCODImage* i, int clipminx, int clipminy, int clipmaxx, int clipmaxy);
   virtual float getIntensity() { return 1.0f; }
   virtual map::HDRColor getColor([[maybe_unused]] float rad) { return color; }
   float getFog(int x, int y);
+  // light reaching the subcell at dx,dy from the light
+  map::HDRColor getLightAt(float dx, float dy) const;
+  // recompute the light fov if the light moved, the walls around it changed or the resolution changed
+  void updateFovCache(bool lowRes);
+  // evaluate the light color, intensity and angular noise once for all the subcells it hits
+  void updateFalloff();
+
+  // light fov on the part of the dungeon it can hit (2x coords, 1x coords in low res)
+  struct FovCache {
+    bool lowRes = false;
+    int dungeonSerial = -1;
+    int transparencyVersion = 0;
+    int lightx = 0, lighty = 0, range = 0;
+    int minx = 0, miny = 0, width = 0, height = 0;
+    int generation = 0;  // incremented each time the fov is recomputed
+    std::vector<bool> inFov;
+  } fovCache;
+
+  // falloff tables. the angular noise only depends on range and noiseOffset
+  float falloffRange = -1.0f;
+  bool falloffRandomRad = false;
+  float falloffNoiseOffset = -1.0f;
+  float invSquaredRange[NB_ANGLES];  // 1/range^2 for each angle bucket. only the first one without randomRad
+  map::HDRColor radColors[NB_RADS];  // color * intensity for each distance bucket
+
+  // what the light looked like when it was last rendered
+  struct Rendered {
+    bool valid = false;
+    int minx = 0, miny = 0, maxx = 0, maxy = 0;
+    float x = 0.0f, y = 0.0f, range = 0.0f;
+    bool randomRad = false;
+    float noiseOffset = 0.0f;
+    int fovGeneration = 0;
+    map::HDRColor radColors[NB_RADS];
+  } rendered;
 };
 
 class ExtendedLight : public Light {
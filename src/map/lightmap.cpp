@@ -25,27 +25,317 @@
  */
 #include "map/lightmap.hpp"
 
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 #include "main.hpp"
 #include "map/dungeon.hpp"
+#include "util/profiler.hpp"
 
 namespace map {
+// float row kernels. SSE2 on any x86_64 build, AVX2 when compiled with -mavx2 (TREEBURNER_AVX2), scalar elsewhere
+#if defined(__AVX2__)
+static constexpr int SIMD_WIDTH = 8;
+typedef __m256 Vec;
+static inline Vec vset(float v) { return _mm256_set1_ps(v); }
+static inline Vec vload(const float* p) { return _mm256_loadu_ps(p); }
+static inline void vstore(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+static inline Vec vadd(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+static inline Vec vmul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+static inline Vec vclamp(Vec v, Vec lo, Vec hi) { return _mm256_min_ps(_mm256_max_ps(v, lo), hi); }
+static inline void vstoreInt(int32_t* p, Vec v) { _mm256_storeu_si256((__m256i*)p, _mm256_cvttps_epi32(v)); }
+#elif defined(__SSE2__) || defined(_M_X64)
+static constexpr int SIMD_WIDTH = 4;
+typedef __m128 Vec;
+static inline Vec vset(float v) { return _mm_set1_ps(v); }
+static inline Vec vload(const float* p) { return _mm_loadu_ps(p); }
+static inline void vstore(float* p, Vec v) { _mm_storeu_ps(p, v); }
+static inline Vec vadd(Vec a, Vec b) { return _mm_add_ps(a, b); }
+static inline Vec vmul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+static inline Vec vclamp(Vec v, Vec lo, Vec hi) { return _mm_min_ps(_mm_max_ps(v, lo), hi); }
+static inline void vstoreInt(int32_t* p, Vec v) { _mm_storeu_si128((__m128i*)p, _mm_cvttps_epi32(v)); }
+#else
+static constexpr int SIMD_WIDTH = 1;
+typedef float Vec;
+static inline Vec vset(float v) { return v; }
+static inline Vec vload(const float* p) { return *p; }
+static inline void vstore(float* p, Vec v) { *p = v; }
+static inline Vec vadd(Vec a, Vec b) { return a + b; }
+static inline Vec vmul(Vec a, Vec b) { return a * b; }
+static inline Vec vclamp(Vec v, Vec lo, Vec hi) { return MIN(MAX(v, lo), hi); }
+static inline void vstoreInt(int32_t* p, Vec v) { *p = (int32_t)v; }
+#endif
+static constexpr int ROW_ALIGN = 8;  // in floats
+
+static void fillRow(float* dst, int count, float value) {
+  Vec v = vset(value);
+  int i = 0;
+  for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) vstore(dst + i, v);
+  for (; i < count; i++) dst[i] = value;
+}
+
+static void addRow(float* dst, const float* src, int count) {
+  int i = 0;
+  for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) vstore(dst + i, vadd(vload(dst + i), vload(src + i)));
+  for (; i < count; i++) dst[i] += src[i];
+}
+
+// dst = coefs * value
+static void mulSetRow(float* dst, const float* coefs, float value, int count) {
+  Vec v = vset(value);
+  int i = 0;
+  for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) vstore(dst + i, vmul(vload(coefs + i), v));
+  for (; i < count; i++) dst[i] = coefs[i] * value;
+}
+
+// dst *= src * coef
+static void mulRow(float* dst, const float* src, float coef, int count) {
+  Vec v = vset(coef);
+  int i = 0;
+  for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) vstore(dst + i, vmul(vload(dst + i), vmul(vload(src + i), v)));
+  for (; i < count; i++) dst[i] *= src[i] * coef;
+}
+
+// dst = a * wa + b * wb + c * wc + d * wd
+static void blendRow(float* dst, const float* a, const float* b, const float* c, const float* d, float wa, float wb,
+                     float wc, float wd, int count) {
+  Vec va = vset(wa);
+  Vec vb = vset(wb);
+  Vec vc = vset(wc);
+  Vec vd = vset(wd);
+  int i = 0;
+  for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+    Vec ab = vadd(vmul(vload(a + i), va), vmul(vload(b + i), vb));
+    Vec cd = vadd(vmul(vload(c + i), vc), vmul(vload(d + i), vd));
+    vstore(dst + i, vadd(ab, cd));
+  }
+  for (; i < count; i++) dst[i] = a[i] * wa + b[i] * wb + c[i] * wc + d[i] * wd;
+}
+
+// dst *= MIN(1, ((dx + i)^2 + dy2) * invRange2)
+static void distanceFogRow(float* dst, float dx, float dy2, float invRange2, int count) {
+  static const float ramp[8] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+  Vec vramp = vload(ramp);
+  Vec vdy2 = vset(dy2);
+  Vec vinv = vset(invRange2);
+  Vec lo = vset(0.0f);
+  Vec hi = vset(1.0f);
+  int i = 0;
+  for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+    Vec vdx = vadd(vset(dx + i), vramp);
+    Vec coef = vclamp(vmul(vadd(vmul(vdx, vdx), vdy2), vinv), lo, hi);
+    vstore(dst + i, vmul(vload(dst + i), coef));
+  }
+  for (; i < count; i++) {
+    float x = dx + i;
+    dst[i] *= MIN(1.0f, (x * x + dy2) * invRange2);
+  }
+}
+
+// same rounding as HDRColor to TCODColor : truncate and clamp to 0-255
+static void toByteRow(const float* src, int count, int32_t* dst) {
+  Vec lo = vset(0.0f);
+  Vec hi = vset(255.0f);
+  int i = 0;
+  for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) vstoreInt(dst + i, vclamp(vload(src + i), lo, hi));
+  for (; i < count; i++) dst[i] = CLAMP(0, 255, (int)src[i]);
+}
+
 HDRColor operator*(float value, const HDRColor& c) { return c * value; }
 
+HDRImage::HDRImage(int width, int height) : width(width), height(height) {
+  pitch = (width + ROW_ALIGN - 1) / ROW_ALIGN * ROW_ALIGN;
+  int size = pitch * height;
+  buffer.resize(3 * size + ROW_ALIGN);
+  float* base = buffer.data();
+  while ((uintptr_t)base % (ROW_ALIGN * sizeof(float)) != 0) base++;
+  r = base;
+  g = r + size;
+  b = g + size;
+}
+
+void HDRImage::clear(const HDRColor& col) {
+  fillRow(r, pitch * height, col.r);
+  fillRow(g, pitch * height, col.g);
+  fillRow(b, pitch * height, col.b);
+}
+
+void HDRImage::toImage(TCODImage& img) const {
+  PROFILE_SCOPE("tonemap");
+  std::vector<int32_t> ir(width), ig(width), ib(width);
+  for (int y = 0; y < height; y++) {
+    int offset = y * pitch;
+    toByteRow(r + offset, width, ir.data());
+    toByteRow(g + offset, width, ig.data());
+    toByteRow(b + offset, width, ib.data());
+    for (int x = 0; x < width; x++) img.putPixel(x, y, TCODColor(ir[x], ig[x], ib[x]));
+  }
+}
+
 LightMap::LightMap(int width, int height) : width(width), height(height) {
-  data = new HDRColor[width * height / 4];
-  data2x = new HDRColor[width * height];
+  pitch2x = (width + ROW_ALIGN - 1) / ROW_ALIGN * ROW_ALIGN;
+  pitch = (width / 2 + ROW_ALIGN - 1) / ROW_ALIGN * ROW_ALIGN;
+  int size2x = pitch2x * height;
+  int size = pitch * (height / 2);
+  // one allocation for the 6 planes, with room to align the first one
+  buffer.resize(3 * size2x + 3 * size + ROW_ALIGN);
+  float* base = buffer.data();
+  while ((uintptr_t)base % (ROW_ALIGN * sizeof(float)) != 0) base++;
+  r2x = base;
+  g2x = r2x + size2x;
+  b2x = g2x + size2x;
+  r = b2x + size2x;
+  g = r + size;
+  b = g + size;
+  static bool lowResLights = config.getBoolProperty("config.display.lowResLights");
+  lowRes = lowResLights;
+  lowResBuffer.resize(3 * size + ROW_ALIGN);
+  base = lowResBuffer.data();
+  while ((uintptr_t)base % (ROW_ALIGN * sizeof(float)) != 0) base++;
+  lowr = base;
+  lowg = lowr + size;
+  lowb = lowg + size;
   // initialise fog
   fogNoise = new TCODNoise(3);
   fogZ = 0.0f;
   fogRange = 0.0f;
+  resetTouched();
 }
 
 void LightMap::clear(const TCODColor& col) {
-  for (int x = 0; x < width; x++) {
-    for (int y = 0; y < height; y++) {
-      setColor2x(x, y, col);
+  fillRow(r2x, pitch2x * height, col.r);
+  fillRow(g2x, pitch2x * height, col.g);
+  fillRow(b2x, pitch2x * height, col.b);
+  fillRow(r, pitch * (height / 2), col.r);
+  fillRow(g, pitch * (height / 2), col.g);
+  fillRow(b, pitch * (height / 2), col.b);
+  dirty = false;
+  hasLights = false;
+}
+
+void LightMap::clear(const TCODColor& col, int minx, int miny, int maxx, int maxy) {
+  for (int y = miny; y < maxy; y++) {
+    int offset = minx + y * pitch2x;
+    fillRow(r2x + offset, maxx - minx, col.r);
+    fillRow(g2x + offset, maxx - minx, col.g);
+    fillRow(b2x + offset, maxx - minx, col.b);
+  }
+  dirty = true;
+}
+
+void LightMap::setColors2x(int x, int y, int count, const float* coefs, const HDRColor& col) {
+  int offset = x + y * pitch2x;
+  mulSetRow(r2x + offset, coefs, col.r, count);
+  mulSetRow(g2x + offset, coefs, col.g, count);
+  mulSetRow(b2x + offset, coefs, col.b, count);
+  dirty = true;
+  touchedMinx = MIN(touchedMinx, x);
+  touchedMaxx = MAX(touchedMaxx, x + count);
+  touchedMiny = MIN(touchedMiny, y);
+  touchedMaxy = MAX(touchedMaxy, y + 1);
+}
+
+void LightMap::accumulate(int x, int y, int count, const float* red, const float* green, const float* blue) {
+  int offset = x + y * pitch2x;
+  addRow(r2x + offset, red, count);
+  addRow(g2x + offset, green, count);
+  addRow(b2x + offset, blue, count);
+  dirty = true;
+}
+
+void LightMap::clearLowRes(int minx, int miny, int maxx, int maxy) {
+  for (int y = miny; y < maxy; y++) {
+    int offset = minx + y * pitch;
+    fillRow(lowr + offset, maxx - minx, 0.0f);
+    fillRow(lowg + offset, maxx - minx, 0.0f);
+    fillRow(lowb + offset, maxx - minx, 0.0f);
+  }
+}
+
+void LightMap::accumulateLowRes(int x, int y, int count, const float* red, const float* green, const float* blue) {
+  int offset = x + y * pitch;
+  addRow(lowr + offset, red, count);
+  addRow(lowg + offset, green, count);
+  addRow(lowb + offset, blue, count);
+}
+
+void LightMap::upsampleLowRes(int minx, int miny, int maxx, int maxy) {
+  PROFILE_SCOPE("upsample");
+  // bilinear weights of the cell containing the subcell, the horizontal and vertical neighbours and the diagonal one
+  static const float weights[4] = {9.0f / 16, 3.0f / 16, 3.0f / 16, 1.0f / 16};
+  map::Dungeon* dungeon = gameEngine->dungeon;
+  int xOffset = gameEngine->xOffset;
+  int yOffset = gameEngine->yOffset;
+  for (int y = miny; y < maxy; y++) {
+    int dungeony = y + yOffset * 2;
+    if (dungeony < 0 || dungeony >= dungeon->height * 2) continue;
+    int cy = y / 2;
+    // the other closest cell row
+    int ny = (y & 1) ? cy + 1 : cy - 1;
+    for (int x = minx; x < maxx; x++) {
+      int dungeonx = x + xOffset * 2;
+      if (dungeonx < 0 || dungeonx >= dungeon->width * 2 || !dungeon->map2x->isInFov(dungeonx, dungeony)) continue;
+      bool transparent = dungeon->map2x->isTransparent(dungeonx, dungeony);
+      int cx = x / 2;
+      int nx = (x & 1) ? cx + 1 : cx - 1;
+      int samplex[4] = {cx, nx, cx, nx};
+      int sampley[4] = {cy, cy, ny, ny};
+      float sumw = 0.0f, sumr = 0.0f, sumg = 0.0f, sumb = 0.0f;
+      for (int i = 0; i < 4; i++) {
+        int sx = samplex[i];
+        int sy = sampley[i];
+        if (sx < 0 || sy < 0 || sx >= width / 2 || sy >= height / 2) continue;
+        int cellx = sx + xOffset;
+        int celly = sy + yOffset;
+        if (cellx < 0 || celly < 0 || cellx >= dungeon->width || celly >= dungeon->height) continue;
+        if (dungeon->map->isTransparent(cellx, celly) != transparent || !dungeon->map->isInFov(cellx, celly)) continue;
+        int offset = sx + sy * pitch;
+        sumw += weights[i];
+        sumr += weights[i] * lowr[offset];
+        sumg += weights[i] * lowg[offset];
+        sumb += weights[i] * lowb[offset];
+      }
+      int offset = x + y * pitch2x;
+      if (sumw == 0.0f) {
+        // the smoothed walls of the subcells don't match the cells. use the containing cell
+        int celloffset = cx + cy * pitch;
+        r2x[offset] += lowr[celloffset];
+        g2x[offset] += lowg[celloffset];
+        b2x[offset] += lowb[celloffset];
+      } else {
+        float inv = 1.0f / sumw;
+        r2x[offset] += sumr * inv;
+        g2x[offset] += sumg * inv;
+        b2x[offset] += sumb * inv;
+      }
     }
   }
+  dirty = true;
+}
+
+// the console resolution light is the top left subcell of each cell
+void LightMap::downsample() {
+  for (int y = 0; y < height / 2; y++) {
+    const float* srcr = r2x + y * 2 * pitch2x;
+    const float* srcg = g2x + y * 2 * pitch2x;
+    const float* srcb = b2x + y * 2 * pitch2x;
+    float* dstr = r + y * pitch;
+    float* dstg = g + y * pitch;
+    float* dstb = b + y * pitch;
+    for (int x = 0; x < width / 2; x++) {
+      dstr[x] = srcr[x * 2];
+      dstg[x] = srcg[x * 2];
+      dstb[x] = srcb[x * 2];
+    }
+  }
+  dirty = false;
 }
 
 void LightMap::update(float elapsed) {
@@ -54,17 +344,88 @@ void LightMap::update(float elapsed) {
   fogZ += elapsed * fogSpeed;
 }
 
-float LightMap::getFog(int x, int y) {
+float LightMap::getFog(int x, int y) { return evalFog(x, y, fogZ); }
+
+float LightMap::evalFog(int x, int y, float z) {
   static float fogMaxLevel = config.getFloatProperty("config.fog.maxLevel");
   static float fogScale = config.getFloatProperty("config.fog.scale");
   static float fogOctaves = config.getFloatProperty("config.fog.octaves");
   static float coefx = fogScale / CON_W;
   static float coefy = fogScale / CON_H;
 
-  float f[3] = {x * coefx, y * coefy, fogZ};
+  float f[3] = {x * coefx, y * coefy, z};
   return fogMaxLevel * 0.5f * (fogNoise->getFbm(f, fogOctaves) + 1.0f);
 }
 
+void LightMap::computeFogRow(std::vector<float>& key, int row, float z) {
+  float* dst = &key[row * pitch2x];
+  int dungeony = fogField.originy + row * FOG_STEP;
+  float prev = evalFog(fogField.originx, dungeony, z);
+  for (int x = 0; x < width; x += FOG_STEP) {
+    float next = evalFog(fogField.originx + x + FOG_STEP, dungeony, z);
+    for (int i = 0; i < FOG_STEP && x + i < width; i++) dst[x + i] = prev + (next - prev) * i / FOG_STEP;
+    prev = next;
+  }
+}
+
+void LightMap::updateFogField() {
+  PROFILE_SCOPE("fog");
+  int originx = gameEngine->xOffset * 2;
+  int originy = gameEngine->yOffset * 2;
+  if (!fogField.valid || fogField.originx != originx || fogField.originy != originy ||
+      fogZ >= fogField.z1 + FOG_Z_STEP || fogZ < fogField.z0) {
+    // new view, or fogZ jumped. compute both keyframes now
+    fogField.valid = true;
+    fogField.originx = originx;
+    fogField.originy = originy;
+    fogField.height = height / FOG_STEP + 2;
+    fogField.key0.resize(fogField.height * pitch2x);
+    fogField.key1.resize(fogField.height * pitch2x);
+    fogField.next.resize(fogField.height * pitch2x);
+    fogField.z0 = fogZ;
+    fogField.z1 = fogZ + FOG_Z_STEP;
+    for (int row = 0; row < fogField.height; row++) {
+      computeFogRow(fogField.key0, row, fogField.z0);
+      computeFogRow(fogField.key1, row, fogField.z1);
+    }
+    fogField.nextRow = 0;
+  } else if (fogZ >= fogField.z1) {
+    // reached key1. finish the next keyframe if needed and start the one after
+    while (fogField.nextRow < fogField.height) {
+      computeFogRow(fogField.next, fogField.nextRow++, fogField.z1 + FOG_Z_STEP);
+    }
+    fogField.key0.swap(fogField.key1);
+    fogField.key1.swap(fogField.next);
+    fogField.z0 = fogField.z1;
+    fogField.z1 = fogField.z0 + FOG_Z_STEP;
+    fogField.nextRow = 0;
+  }
+  // spread the next keyframe over the frames until fogZ reaches z1
+  int rows = (int)ceilf(fogField.height * (fogZ - fogField.z0) / FOG_Z_STEP) + 1;
+  rows = MIN(rows, fogField.height);
+  while (fogField.nextRow < rows) computeFogRow(fogField.next, fogField.nextRow++, fogField.z1 + FOG_Z_STEP);
+}
+
+void LightMap::getPlayerFogRow(int x, int y, int count, float* fog) {
+  if (fogRange == 0.0f) {
+    std::fill(fog, fog + count, 0.0f);
+    return;
+  }
+  if (!fogField.valid) updateFogField();
+  int row = y / FOG_STEP;
+  float fy = (float)(y % FOG_STEP) / FOG_STEP;
+  float t = (fogZ - fogField.z0) / FOG_Z_STEP;
+  t = CLAMP(0.0f, 1.0f, t);
+  const float* key0 = &fogField.key0[row * pitch2x + x];
+  const float* key1 = &fogField.key1[row * pitch2x + x];
+  blendRow(fog, key0, key0 + pitch2x, key1, key1 + pitch2x, (1.0f - t) * (1.0f - fy), (1.0f - t) * fy,
+           t * (1.0f - fy), t * fy, count);
+  // increase fog with distance from player
+  float playerdx = x + fogField.originx - gameEngine->player.x * 2;
+  float playerdy = y + fogField.originy - gameEngine->player.y * 2;
+  distanceFogRow(fog, playerdx, playerdy * playerdy, 1.0f / (fogRange * fogRange), count);
+}
+
 float LightMap::getPlayerFog(int x, int y) {
   if (fogRange == 0.0f) return 0.0f;
   float maxDistDiv = 1.0f / (fogRange * fogRange);
@@ -79,7 +440,8 @@ float LightMap::getPlayerFog(int x, int y) {
 }
 
 // apply a light map to an image.
-void LightMap::applyToImage(TCODImage& image, int minx2x, int miny2x, int maxx2x, int maxy2x, bool playerFog) {
+void LightMap::applyToImage(HDRImage& image, int minx2x, int miny2x, int maxx2x, int maxy2x, bool playerFog) {
+  PROFILE_SCOPE("lightmap");
   static TCODColor fogColor = config.getColorProperty("config.fog.col");
   static TCODColor memoryWallColor = config.getColorProperty("config.display.memoryWallColor");
   static int memoryWallIntensity = (int)(memoryWallColor.r) + memoryWallColor.g + memoryWallColor.b;
@@ -88,19 +450,25 @@ void LightMap::applyToImage(TCODImage& image, int minx2x, int miny2x, int maxx2x
   map::Dungeon* dungeon = gameEngine->dungeon;
   if (maxx2x == 0) maxx2x = width - 1;
   if (maxy2x == 0) maxy2x = height - 1;
-  for (int x = minx2x; x <= maxx2x; x++) {
-    for (int y = miny2x; y < maxy2x; y++) {
+  if (maxx2x < minx2x) return;
+  std::vector<float> fog(maxx2x - minx2x + 1);
+  if (playerFog) updateFogField();
+  for (int y = miny2x; y < maxy2x; y++) {
+    if (playerFog) getPlayerFogRow(minx2x, y, maxx2x - minx2x + 1, fog.data());
+    for (int x = minx2x; x <= maxx2x; x++) {
       int dungeonx = x + gameEngine->xOffset * 2;
       int dungeony = y + gameEngine->yOffset * 2;
       if (!IN_RECTANGLE(dungeonx, dungeony, dungeon->width * 2, dungeon->height * 2)) {
         image.putPixel(x, y, TCODColor::black);  // out of the map
       } else {
         // visible cell. shade it
-        TCODColor col = dungeon->getGroundColor(dungeonx, dungeony);  // wall?wallColor:groundColor;
-        TCODColor lmcol = playerFog ? TCODColor::lerp(data2x[x + y * width], fogColor, getPlayerFog(dungeonx, dungeony))
-                                    : (TCODColor)data2x[x + y * width];
+        HDRColor col = dungeon->getGroundColor(dungeonx, dungeony);  // wall?wallColor:groundColor;
+        HDRColor lmcol = getHdrColor2x(x, y);
+        // the light tints the ground as a clamped color. only the accumulated frame goes beyond 255
+        lmcol = HDRColor(MIN(lmcol.r, 255.0f), MIN(lmcol.g, 255.0f), MIN(lmcol.b, 255.0f));
+        if (playerFog) lmcol = HDRColor::lerp(lmcol, fogColor, fog[x - minx2x]);
 
-        int lightIntensity = (int)(lmcol.r) + lmcol.g + lmcol.b;
+        int lightIntensity = (int)(lmcol.r + lmcol.g + lmcol.b);
         float coef = 1.0f;
 
         if (!dungeon->map2x->isInFov(dungeonx, dungeony) || lightIntensity < memoryWallIntensity) {
@@ -134,23 +502,24 @@ void LightMap::applyToImage(TCODImage& image, int minx2x, int miny2x, int maxx2x
   }
 }
 
-void LightMap::applyToImageOutdoor(TCODImage& image) {
+void LightMap::applyToImageOutdoor(HDRImage& image) {
+  PROFILE_SCOPE("lightmap");
   map::Dungeon* dungeon = gameEngine->dungeon;
-  int maxx2x = width - 1;
-  int maxy2x = height - 1;
-  for (int x = 0; x <= maxx2x; x++) {
-    for (int y = 0; y < maxy2x; y++) {
+  int maxx2x = MIN(width, image.width) - 1;
+  int maxy2x = MIN(height, image.height) - 1;
+  for (int y = 0; y < maxy2x; y++) {
+    // shade the whole row, then fix the cells out of the map
+    mulRow(image.r + y * image.pitch, r2x + y * pitch2x, 1.0f / 255.0f, maxx2x + 1);
+    mulRow(image.g + y * image.pitch, g2x + y * pitch2x, 1.0f / 255.0f, maxx2x + 1);
+    mulRow(image.b + y * image.pitch, b2x + y * pitch2x, 1.0f / 255.0f, maxx2x + 1);
+    for (int x = 0; x <= maxx2x; x++) {
       int dungeonx = x + gameEngine->xOffset * 2;
       int dungeony = y + gameEngine->yOffset * 2;
       if (!IN_RECTANGLE(dungeonx, dungeony, dungeon->width * 2, dungeon->height * 2)) {
         image.putPixel(x, y, TCODColor::black);  // out of the map
       } else {
-        // visible cell. shade it
-        HDRColor col = image.getPixel(x, y);
-        HDRColor lmcol = data2x[x + y * width];
-        lmcol = lmcol * col;
+        HDRColor lmcol = image.getPixel(x, y);
         int lightIntensity = (int)(lmcol.r + lmcol.g + lmcol.b);
-        image.putPixel(x, y, lmcol);
         if (lightIntensity > 30 && dungeon->map2x->isInFov(dungeonx, dungeony)) {
           dungeon->setMemory(dungeonx / 2, dungeony / 2);
         }
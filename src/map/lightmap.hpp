@@ -24,7 +24,9 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <atomic>
 #include <libtcod.hpp>
+#include <vector>
 
 namespace map {
 // color that can go beyond 0-255 range
@@ -50,38 +52,162 @@ struct HDRColor {
 };
 HDRColor operator*(float value, const HDRColor& c);
 
+// float image of the console subcells. the ground, lights, fire and ripples accumulate in it without clamping,
+// then toImage quantizes the whole frame in one pass
+class HDRImage {
+ public:
+  HDRImage(int width, int height);
+  HDRImage(const HDRImage&) = delete;
+  HDRImage& operator=(const HDRImage&) = delete;
+  void clear(const HDRColor& col);
+  void getSize(int* w, int* h) const {
+    *w = width;
+    *h = height;
+  }
+  // out of the image pixels read black and ignore writes, like TCODImage
+  inline HDRColor getPixel(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height) return HDRColor();
+    int offset = x + y * pitch;
+    return HDRColor(r[offset], g[offset], b[offset]);
+  }
+  inline void putPixel(int x, int y, const HDRColor& col) {
+    if (x < 0 || y < 0 || x >= width || y >= height) return;
+    int offset = x + y * pitch;
+    r[offset] = col.r;
+    g[offset] = col.g;
+    b[offset] = col.b;
+  }
+  // tone mapping. clamp each channel to 0-255 and copy the frame to img
+  void toImage(TCODImage& img) const;
+
+  int width, height;
+
+ protected:
+  friend class LightMap;
+  std::vector<float> buffer;
+  int pitch;
+  float *r, *g, *b;
+};
+
+// light reaching each subcell of the console, stored as planar float buffers so that
+// the per frame kernels (clear, accumulate, upsampling) run on SIMD registers
 class LightMap {
  public:
   LightMap(int width, int height);
+  LightMap(const LightMap&) = delete;
+  LightMap& operator=(const LightMap&) = delete;
   void clear(const TCODColor& col);
+  // clear the subcells minx <= x < maxx, miny <= y < maxy
+  void clear(const TCODColor& col, int minx, int miny, int maxx, int maxy);
+  // set the count subcells starting at x,y to col * coefs[i]
+  void setColors2x(int x, int y, int count, const float* coefs, const HDRColor& col);
+  // add (red[i], green[i], blue[i]) to the count subcells starting at x,y
+  void accumulate(int x, int y, int count, const float* red, const float* green, const float* blue);
+  // low res mode : the lights accumulate in a console resolution buffer, upsampled to the subcells once done.
+  // clear the cells minx <= x < maxx, miny <= y < maxy of the buffer
+  void clearLowRes(int minx, int miny, int maxx, int maxy);
+  // add (red[i], green[i], blue[i]) to the count cells starting at x,y of the buffer
+  void accumulateLowRes(int x, int y, int count, const float* red, const float* green, const float* blue);
+  // add the buffer to the subcells minx <= x < maxx, miny <= y < maxy. each subcell blends its 4 closest cells,
+  // ignoring the ones on the other side of a wall so that the light doesn't leak through thin walls
+  void upsampleLowRes(int minx, int miny, int maxx, int maxy);
+  // shade the ground with the light and the fog
   void applyToImage(
-      TCODImage& img, int minx2x = 0, int miny2x = 0, int maxx2x = 0, int maxy2x = 0, bool playerFog = true);
-  void applyToImageOutdoor(TCODImage& img);
-  inline TCODColor getColor2x(int x, int y) { return data2x[x + y * width]; }
-  inline TCODColor getColor(int x, int y) { return data[x + y * width / 2]; }
-  inline HDRColor& getHdrColor2x(int x, int y) { return data2x[x + y * width]; }
-  inline HDRColor& getHdrColor(int x, int y) { return data[x + y * width / 2]; }
-  inline void setColor2x(int x, int y, const TCODColor& col) {
-    data2x[x + y * width] = col;
-    if ((x & 1) == 0 && (y & 1) == 0) data[x / 2 + y * width / 4] = col;
+      HDRImage& img, int minx2x = 0, int miny2x = 0, int maxx2x = 0, int maxy2x = 0, bool playerFog = true);
+  // multiply the image by the light
+  void applyToImageOutdoor(HDRImage& img);
+  inline TCODColor getColor2x(int x, int y) { return getHdrColor2x(x, y); }
+  inline TCODColor getColor(int x, int y) { return getHdrColor(x, y); }
+  inline HDRColor getHdrColor2x(int x, int y) const {
+    int offset = x + y * pitch2x;
+    return HDRColor(r2x[offset], g2x[offset], b2x[offset]);
+  }
+  // console resolution. derived from the 2x data on the first read after a change
+  inline HDRColor getHdrColor(int x, int y) {
+    if (dirty) downsample();
+    int offset = x + y * pitch;
+    return HDRColor(r[offset], g[offset], b[offset]);
   }
   inline void setColor2x(int x, int y, const HDRColor& col) {
-    data2x[x + y * width] = col;
-    if ((x & 1) == 0 && (y & 1) == 0) data[x / 2 + y * width / 4] = col;
+    int offset = x + y * pitch2x;
+    r2x[offset] = col.r;
+    g2x[offset] = col.g;
+    b2x[offset] = col.b;
+    dirty = true;
+    if (x < touchedMinx) touchedMinx = x;
+    if (x >= touchedMaxx) touchedMaxx = x + 1;
+    if (y < touchedMiny) touchedMiny = y;
+    if (y >= touchedMaxy) touchedMaxy = y + 1;
   }
+  inline void setColor2x(int x, int y, const TCODColor& col) { setColor2x(x, y, HDRColor(col)); }
 
   float getFog(int x, int y);
   float getPlayerFog(int x, int y);
+  // bring the coarse fog field up to date with the view and fogZ. done by applyToImage
+  void updateFogField();
+  // getPlayerFog of count subcells starting at lightmap x,y, interpolated from the fog field
+  void getPlayerFogRow(int x, int y, int count, float* fog);
   void update(float elapsed);
 
   int width, height;
   float fogRange;
+  // compute the lights on the console cells instead of the subcells. 4x less work, blurrier light edges.
+  // from config.display.lowResLights
+  bool lowRes;
+
+  // incremental rendering of the lights, see Dungeon::renderLightsToLightMap
+  struct LightsKey {
+    int dungeonSerial = -1;
+    int xOffset = 0, yOffset = 0;
+    int fovVersion = 0;  // the lights only reach the cells in the player fov
+    TCODColor ambient;
+    bool operator==(const LightsKey& k) const {
+      return dungeonSerial == k.dungeonSerial && xOffset == k.xOffset && yOffset == k.yOffset &&
+             fovVersion == k.fovVersion && ambient == k.ambient;
+    }
+  };
+  // the map holds the ambient light and the lights rendered with lightsKey, except in the touched part
+  bool hasLights = false;
+  LightsKey lightsKey;
+  // part written by setColor2x since the last resetTouched (max excluded)
+  int touchedMinx, touchedMiny, touchedMaxx, touchedMaxy;
+  void resetTouched() {
+    touchedMinx = width;
+    touchedMiny = height;
+    touchedMaxx = touchedMaxy = 0;
+  }
 
  protected:
-  HDRColor* data2x = nullptr;
-  HDRColor* data = nullptr;
+  // rows are padded to a multiple of 8 floats and start on a 32 bytes boundary
+  std::vector<float> buffer;
+  int pitch2x, pitch;
+  float *r2x, *g2x, *b2x;
+  float *r, *g, *b;
+  std::atomic<bool> dirty{true};  // the console resolution data is out of date. tiles write it concurrently
+  // low res lights, pitch floats per row
+  std::vector<float> lowResBuffer;
+  float *lowr, *lowg, *lowb;
+
+  void downsample();
 
   float fogZ;
   TCODNoise* fogNoise = nullptr;
+
+  // fog sampled every FOG_STEP subcells at fogZ keyframes, interpolated in space and time between key0 and key1.
+  // the keyframe after key1 is computed a few rows per frame while fogZ moves from z0 to z1
+  static constexpr int FOG_STEP = 2;
+  static constexpr float FOG_Z_STEP = 0.05f;
+  struct FogField {
+    bool valid = false;
+    int originx = 0, originy = 0;  // dungeon subcell of the first sample
+    int height = 0;  // number of sample rows
+    float z0 = 0.0f, z1 = 0.0f;
+    int nextRow = 0;  // rows of next already computed
+    // sample rows upsampled horizontally to pitch2x floats
+    std::vector<float> key0, key1, next;
+  } fogField;
+
+  float evalFog(int x, int y, float z);
+  void computeFogRow(std::vector<float>& key, int row, float z);
 };
 }  // namespace map
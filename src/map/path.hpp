@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <libtcod.hpp>
+
+namespace map {
+class ClusterGraph;
+
+// a path that a creature walks, one cell per step. same interface as TCODPath
+class Path {
+ public:
+  virtual ~Path() = default;
+  virtual bool compute(int ox, int oy, int dx, int dy) = 0;
+  // compute on the path service workers. graph is the up to date hierarchical graph of the dungeon
+  virtual bool computeOnGraph([[maybe_unused]] const ClusterGraph& graph, int ox, int oy, int dx, int dy) {
+    return compute(ox, oy, dx, dy);
+  }
+  // pop the next step. if it is blocked and recalculateWhenNeeded, compute a new path to the destination
+  virtual bool walk(int* x, int* y, bool recalculateWhenNeeded) = 0;
+  virtual bool isEmpty() const = 0;
+  virtual int size() const = 0;
+  virtual void get(int index, int* x, int* y) const = 0;
+  virtual void getDestination(int* x, int* y) const = 0;
+};
+
+// plain A* on the whole map
+class AStarPath : public Path {
+ public:
+  AStarPath(int w, int h, const ITCODPathCallback* cbk, void* userData) : path(w, h, cbk, userData) {}
+  bool compute(int ox, int oy, int dx, int dy) override { return path.compute(ox, oy, dx, dy); }
+  bool walk(int* x, int* y, bool recalculateWhenNeeded) override { return path.walk(x, y, recalculateWhenNeeded); }
+  bool isEmpty() const override { return path.isEmpty(); }
+  int size() const override { return path.size(); }
+  void get(int index, int* x, int* y) const override { path.get(index, x, y); }
+  void getDestination(int* x, int* y) const override { path.getDestination(x, y); }
+
+ protected:
+  TCODPath path;
+};
+}  // namespace map
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "map/pathservice.hpp"
+
+#include <algorithm>
+
+#include "main.hpp"
+#include "util/parallel.hpp"
+#include "util/profiler.hpp"
+
+namespace map {
+void PathService::request(mob::Creature* cr, int destx, int desty) {
+  float priority = cr->distance(gameEngine->player);
+  if (!cr->isOnScreen()) priority += OFFSCREEN_DISTANCE;
+  auto it = index.find(cr);
+  if (it != index.end()) {
+    Request& req = requests[it->second];
+    req.destx = destx;
+    req.desty = desty;
+    req.priority = priority;
+    return;
+  }
+  index[cr] = (int)requests.size();
+  requests.push_back(Request{cr, destx, desty, priority, std::chrono::steady_clock::now(), false});
+}
+
+void PathService::cancel(const mob::Creature* cr) {
+  auto it = index.find(cr);
+  if (it == index.end()) return;
+  // the order doesn't matter, update sorts the requests
+  int pos = it->second;
+  index.erase(it);
+  if (pos != (int)requests.size() - 1) {
+    requests[pos] = requests.back();
+    index[requests[pos].creature] = pos;
+  }
+  requests.pop_back();
+}
+
+void PathService::reindex() {
+  index.clear();
+  for (int i = 0; i < (int)requests.size(); i++) index[requests[i].creature] = i;
+}
+
+void PathService::update(const ClusterGraph& graph, int64_t budget, bool threaded) {
+  if (requests.empty()) return;
+  PROFILE_SCOPE("paths");
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point now = Clock::now();
+  auto urgency = [now](const Request& req) {
+    return req.priority - AGING * std::chrono::duration<float>(now - req.time).count();
+  };
+  std::sort(requests.begin(), requests.end(),
+            [&urgency](const Request& a, const Request& b) { return urgency(a) < urgency(b); });
+  Clock::time_point deadline = now + std::chrono::microseconds(budget);
+  // the creatures and the map are not modified while the paths are computed so they can be read by any thread
+  auto compute = [this, &graph, deadline](int i) {
+    if (i > 0 && Clock::now() >= deadline) return;
+    Request& req = requests[i];
+    mob::Creature* cr = req.creature;
+    cr->pendingPath->computeOnGraph(graph, (int)cr->x, (int)cr->y, req.destx, req.desty);
+    req.done = true;
+  };
+  if (threaded) {
+    util::parallelFor((int)requests.size(), compute);
+  } else {
+    for (int i = 0; i < (int)requests.size() && (i == 0 || Clock::now() < deadline); i++) compute(i);
+  }
+  // give the computed paths to their creatures
+  Clock::time_point end = Clock::now();
+  int64_t latency = 0;
+  for (Request& req : requests) {
+    if (!req.done) continue;
+    std::swap(req.creature->path, req.creature->pendingPath);
+    latency = std::max(latency, (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(end - req.time).count());
+  }
+  requests.erase(std::remove_if(requests.begin(), requests.end(), [](const Request& req) { return req.done; }),
+                 requests.end());
+  reindex();
+  PROFILE_COUNTER("path latency us", latency);
+}
+}  // namespace map
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace mob {
+class Creature;
+}
+
+namespace map {
+class ClusterGraph;
+
+// computes the paths requested by the creatures within a time budget per frame. the path is computed in the
+// creature pendingPath, then swapped with its path. meanwhile, the creature keeps walking its old path
+class PathService {
+ public:
+  // the oldest requests become as urgent as requests this many cells closer per second of waiting
+  static constexpr float AGING = 10.0f;
+  // off screen creatures are served as if they were this many cells farther
+  static constexpr float OFFSCREEN_DISTANCE = 100.0f;
+
+  // compute cr->pendingPath from the creature position to destx,desty.
+  // replaces the pending request of this creature, if any
+  void request(mob::Creature* cr, int destx, int desty);
+  bool isPending(const mob::Creature* cr) const { return index.count(cr) > 0; }
+  void cancel(const mob::Creature* cr);
+  // compute the most urgent requests during budget microseconds, at least one. on the worker threads if threaded.
+  // graph must be up to date : the workers only read it
+  void update(const ClusterGraph& graph, int64_t budget, bool threaded);
+  int getQueueLength() const { return (int)requests.size(); }
+
+ protected:
+  struct Request {
+    mob::Creature* creature;
+    int destx, desty;
+    float priority;  // lower first. distance to the player
+    std::chrono::steady_clock::time_point time;  // of the first request
+    bool done;
+  };
+  std::vector<Request> requests;
+  std::unordered_map<const mob::Creature*, int> index;  // position in requests of each creature request
+
+  void reindex();
+};
+}  // namespace map
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace map {
+// uniform grid of BUCKET_SIZE x BUCKET_SIZE cells buckets listing the entities standing in them, so that the
+// neighbourhood queries only visit the entities around a position. T is a base::Entity.
+// the owner keeps it up to date each time an entity enters, leaves or changes cell
+template <typename T>
+class SpatialIndex {
+ public:
+  static constexpr int BUCKET_SIZE = 8;
+
+  // size of the map in cells. drops the indexed entities
+  void resize(int width, int height) {
+    this->width = width;
+    this->height = height;
+    bucketsWidth = (width + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    bucketsHeight = (height + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    buckets.assign(bucketsWidth * bucketsHeight, std::vector<T*>());
+  }
+  void add(T* t, int x, int y) {
+    std::vector<T*>* bucket = getBucket(x, y);
+    if (bucket) bucket->push_back(t);
+  }
+  // x,y : cell where the entity was added or last moved to
+  void remove(T* t, int x, int y) {
+    if (removeFrom(getBucket(x, y), t)) return;
+    // the entity changed cell behind our back. look for it everywhere
+    for (std::vector<T*>& bucket : buckets) {
+      if (removeFrom(&bucket, t)) return;
+    }
+  }
+  void move(T* t, int xFrom, int yFrom, int xTo, int yTo) {
+    std::vector<T*>* to = getBucket(xTo, yTo);
+    if (to && to == getBucket(xFrom, yFrom)) return;
+    remove(t, xFrom, yFrom);
+    if (to) to->push_back(t);
+  }
+  // remove the entities standing on the cell x,y
+  void removeCell(int x, int y) {
+    std::vector<T*>* bucket = getBucket(x, y);
+    if (!bucket) return;
+    bucket->erase(std::remove_if(bucket->begin(), bucket->end(),
+                                 [x, y](const T* t) { return (int)t->x == x && (int)t->y == y; }),
+                  bucket->end());
+  }
+
+  // call f(t) for the entities whose cell is in minx <= x <= maxx, miny <= y <= maxy.
+  // f must not add, remove nor move entities
+  template <typename F>
+  void forEachInRectangle(int minx, int miny, int maxx, int maxy, F&& f) const {
+    minx = std::max(0, minx);
+    miny = std::max(0, miny);
+    maxx = std::min(width - 1, maxx);
+    maxy = std::min(height - 1, maxy);
+    if (maxx < minx || maxy < miny) return;
+    for (int by = miny / BUCKET_SIZE; by <= maxy / BUCKET_SIZE; by++) {
+      for (int bx = minx / BUCKET_SIZE; bx <= maxx / BUCKET_SIZE; bx++) {
+        for (T* t : buckets[bx + by * bucketsWidth]) {
+          int cx = (int)t->x;
+          int cy = (int)t->y;
+          if (cx >= minx && cx <= maxx && cy >= miny && cy <= maxy) f(t);
+        }
+      }
+    }
+  }
+  // call f(t) for the entities whose cell is at most radius cells away from the cell x,y
+  template <typename F>
+  void forEachInRadius(int x, int y, float radius, F&& f) const {
+    if (radius < 0.0f) return;
+    int range = (int)ceilf(radius);
+    float squaredRadius = radius * radius;
+    forEachInRectangle(x - range, y - range, x + range, y + range, [&](T* t) {
+      int dx = (int)t->x - x;
+      int dy = (int)t->y - y;
+      if (dx * dx + dy * dy <= squaredRadius) f(t);
+    });
+  }
+
+ protected:
+  int width = 0, height = 0;
+  int bucketsWidth = 0, bucketsHeight = 0;
+  std::vector<std::vector<T*>> buckets;
+
+  std::vector<T*>* getBucket(int x, int y) {
+    if (x < 0 || y < 0 || x >= width || y >= height) return nullptr;
+    return &buckets[x / BUCKET_SIZE + y / BUCKET_SIZE * bucketsWidth];
+  }
+  static bool removeFrom(std::vector<T*>* bucket, T* t) {
+    if (!bucket) return false;
+    auto it = std::find(bucket->begin(), bucket->end(), t);
+    if (it == bucket->end()) return false;
+    // order doesn't matter
+    *it = bucket->back();
+    bucket->pop_back();
+    return true;
+  }
+};
+}  // namespace map
@@ -54,17 +54,18 @@ bool FollowBehavior::update(Creature* crea, float elapsed) {
   int pdist = (int)crea->distance(*leader_);
   map::Dungeon* dungeon = gameEngine->dungeon;
   standDelay += elapsed;
-  if ((pdist > FOLLOW_DIST || standDelay > 10.0f) && (!crea->path || crea->path->isEmpty())) {
+  if ((pdist > FOLLOW_DIST || standDelay > 10.0f) && (!crea->path || crea->path->isEmpty()) &&
+      !dungeon->isPathPending(crea)) {
     // go near the leader
     int destx = (int)(leader_->x + TCODRandom::getInstance()->getInt(-FOLLOW_DIST, FOLLOW_DIST));
     int desty = (int)(leader_->y + TCODRandom::getInstance()->getInt(-FOLLOW_DIST, FOLLOW_DIST));
     destx = CLAMP(0, dungeon->width - 1, destx);
     desty = CLAMP(0, dungeon->height - 1, desty);
     dungeon->getClosestWalkable(&destx, &desty, true, true, false);
-    if (!crea->path) {
-      crea->path = new TCODPath(dungeon->width, dungeon->height, walkPattern, NULL);
+    if (!crea->pendingPath) {
+      crea->pendingPath = new map::HierarchicalPath(walkPattern, NULL);
     }
-    crea->path->compute((int)crea->x, (int)crea->y, destx, desty);
+    dungeon->requestPath(crea, destx, desty);
     crea->pathTimer = 0.0f;
   } else {
     if (crea->walk(elapsed)) {
@@ -93,29 +94,30 @@ void HerdBehavior::updateScarePoints(float elapsed) {
 }
 
 bool HerdBehavior::update(Creature* crea1, float elapsed) {
-  TCODList<Creature*>* herd = &Creature::creatureByType[crea1->type];
+  map::Dungeon* dungeon = gameEngine->dungeon;
   //	printf ("=> %d\n",crea1);
-  for (Creature** f2 = herd->begin(); f2 != herd->end(); f2++) {
-    Creature* crea2 = *f2;
-    if (crea1 != crea2) {
-      float dx = crea2->x - crea1->x;
-      if (fabs(dx) >= FAR_RANGE) continue;
-      float dy = crea2->y - crea1->y;
-      if (fabs(dy) >= FAR_RANGE) continue;  // too far to interact
-      float invDist = crea1->fastInvDistance(*crea2);
-      //	printf ("==> %d\n",crea2);
-      if (invDist > 1E4f) {
-      } else if (invDist > 1.0f / CLOSE_RANGE) {
-        // get away from other creature
-        crea1->dx -= elapsed * 5.0f * dx * invDist;
-        crea1->dy -= elapsed * 5.0f * dy * invDist;
-      } else if (invDist > 1.0f / FAR_RANGE) {
-        // get closer to other creature
-        crea1->dx += elapsed * 1.2f * dx * invDist;
-        crea1->dy += elapsed * 1.2f * dy * invDist;
-      }
-    }
-  }
+  int range = (int)FAR_RANGE;
+  dungeon->forEachCreatureInRectangle(
+      (int)crea1->x - range, (int)crea1->y - range, (int)crea1->x + range, (int)crea1->y + range,
+      [crea1, elapsed](Creature* crea2) {
+        if (crea1 == crea2 || crea2->type != crea1->type) return;
+        float dx = crea2->x - crea1->x;
+        if (fabs(dx) >= FAR_RANGE) return;
+        float dy = crea2->y - crea1->y;
+        if (fabs(dy) >= FAR_RANGE) return;  // too far to interact
+        float invDist = crea1->fastInvDistance(*crea2);
+        //	printf ("==> %d\n",crea2);
+        if (invDist > 1E4f) {
+        } else if (invDist > 1.0f / CLOSE_RANGE) {
+          // get away from other creature
+          crea1->dx -= elapsed * 5.0f * dx * invDist;
+          crea1->dy -= elapsed * 5.0f * dy * invDist;
+        } else if (invDist > 1.0f / FAR_RANGE) {
+          // get closer to other creature
+          crea1->dx += elapsed * 1.2f * dx * invDist;
+          crea1->dy += elapsed * 1.2f * dy * invDist;
+        }
+      });
 
   crea1->dx = CLAMP(-crea1->speed, crea1->speed, crea1->dx);
   crea1->dy = CLAMP(-crea1->speed, crea1->speed, crea1->dy);
@@ -135,7 +137,6 @@ bool HerdBehavior::update(Creature* crea1, float elapsed) {
 
   float newx = crea1->x + crea1->dx;
   float newy = crea1->y + crea1->dy;
-  map::Dungeon* dungeon = gameEngine->dungeon;
   newx = CLAMP(0.0, dungeon->width - 1, newx);
   newy = CLAMP(0.0, dungeon->height - 1, newy);
   crea1->walkTimer += elapsed;
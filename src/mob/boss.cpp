@@ -28,7 +28,6 @@
 #include "base/aidirector.hpp"
 #include "base/gameengine.hpp"
 #include "main.hpp"
-#include "screen/game.hpp"
 
 namespace mob {
 VillageHead::VillageHead() {
@@ -76,7 +75,7 @@ void Boss::setSeen() {
   static float bossSpeed = config.getFloatProperty("config.creatures.boss.speed");
 
   seen = true;
-  ((screen::Game*)(gameEngine))->bossSeen = true;
+  gameEngine->bossSeen = true;
   base::AiDirector::instance->bossSeen();
   speed = bossSpeed;
 }
@@ -125,7 +124,7 @@ bool Boss::update(float elapsed) {
       base::AiDirector::instance->spawnMinion(true, (int)x, (int)y);
     }
   }
-  if (pathTimer > pathDelay) {
+  if (pathTimer > pathDelay && !gameEngine->dungeon->isPathPending(this)) {
     if (!path || path->isEmpty()) {
       // stay away from player
       // while staying in lair
@@ -140,10 +139,10 @@ bool Boss::update(float elapsed) {
       destx = CLAMP(0, gameEngine->dungeon->width - 1, destx);
       desty = CLAMP(0, gameEngine->dungeon->height - 1, desty);
       gameEngine->dungeon->getClosestWalkable(&destx, &desty, true, true);
-      if (!path) {
-        path = new TCODPath(gameEngine->dungeon->width, gameEngine->dungeon->height, this, gameEngine);
+      if (!pendingPath) {
+        pendingPath = new map::AStarPath(gameEngine->dungeon->width, gameEngine->dungeon->height, this, gameEngine);
       }
-      path->compute((int)x, (int)y, destx, desty);
+      gameEngine->dungeon->requestPath(this, destx, desty);
       pathTimer = 0.0f;
     } else
       walk(elapsed);
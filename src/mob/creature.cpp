@@ -30,12 +30,14 @@
 #include "base/aidirector.hpp"
 #include "constants.hpp"
 #include "main.hpp"
+#include "map/flowfield.hpp"
 #include "mob/boss.hpp"
 #include "mob/fish.hpp"
 #include "mob/friend.hpp"
 #include "mob/minion.hpp"
 
 namespace mob {
+std::mutex Creature::creatureByTypeMutex;
 TCODList<Creature*> Creature::creatureByType[NB_CREATURE_TYPES];
 
 TCODList<ConditionType*> ConditionType::list;
@@ -178,6 +180,7 @@ void Condition::applyTo(Creature* cr) {
 
 Creature::Creature()
     : path(NULL),
+      pendingPath(NULL),
       ignoreCreatures(true),
       burn(false),
       flags(0),
@@ -198,6 +201,7 @@ Creature::Creature()
 
 Creature::~Creature() {
   if (path) delete path;
+  if (pendingPath) delete pendingPath;
 }
 
 void Creature::addCondition(Condition* cond) {
@@ -277,11 +281,27 @@ Creature* Creature::getCreature(CreatureTypeId id) {
   }
   if (ret) {
     ret->type = id;
+    std::lock_guard<std::mutex> lock(creatureByTypeMutex);
     creatureByType[id].push(ret);
   }
   return ret;
 }
 
+Creature* Creature::getFirstOfType(CreatureTypeId id) {
+  std::lock_guard<std::mutex> lock(creatureByTypeMutex);
+  return creatureByType[id].isEmpty() ? NULL : creatureByType[id].get(0);
+}
+
+int Creature::getNbOfType(CreatureTypeId id) {
+  std::lock_guard<std::mutex> lock(creatureByTypeMutex);
+  return creatureByType[id].size();
+}
+
+void Creature::removeFromType(Creature* cr) {
+  std::lock_guard<std::mutex> lock(creatureByTypeMutex);
+  creatureByType[cr->type].removeFast(cr);
+}
+
 bool Creature::isInRange(int px, int py) {
   int dx = (int)(px - x);
   int dy = (int)(py - y);
@@ -313,80 +333,6 @@ void Creature::talk(const char* text) {
   }
 }
 
-void Creature::renderTalk() {
-  int conx = (int)(x - gameEngine->xOffset);
-  int cony = (int)(y - gameEngine->yOffset);
-  if (!IN_RECTANGLE(conx, cony, CON_W, CON_H)) return;  // creature out of console
-  talkText.x = conx;
-  talkText.y = cony - talkText.h;
-  if (talkText.y < 0) talkText.y = cony + 1;
-  gameEngine->packer.addRect(&talkText);
-  TCODConsole::root->setDefaultBackground(TCODColor::lighterYellow);
-  TCODConsole::root->setDefaultForeground(TCODColor::darkGrey);
-  TCODConsole::root->printEx((int)talkText.x, (int)talkText.y, TCOD_BKGND_SET, TCOD_CENTER, talkText.text);
-}
-
-void Creature::render(map::LightMap& lightMap) {
-  static int penumbraLevel = config.getIntProperty("config.gameplay.penumbraLevel");
-  static int darknessLevel = config.getIntProperty("config.gameplay.darknessLevel");
-  static float fireSpeed = config.getFloatProperty("config.display.fireSpeed");
-  static TCODColor corpseColor = config.getColorProperty("config.display.corpseColor");
-  static TCODColor lowFire(255, 0, 0);
-  static TCODColor midFire(255, 204, 0);
-  static TCODColor highFire(255, 255, 200);
-  static TCODColor fire[64];
-  static bool fireInit = false;
-  if (!fireInit) {
-    for (int i = 0; i < 32; i++) {
-      fire[i] = TCODColor::lerp(lowFire, midFire, i / 32.0f);
-    }
-    for (int i = 32; i < 64; i++) {
-      fire[i] = TCODColor::lerp(midFire, highFire, (i - 32) / 32.0f);
-    }
-    fireInit = true;
-  }
-
-  // position on console
-  int conx = (int)(x - gameEngine->xOffset);
-  int cony = (int)(y - gameEngine->yOffset);
-  if (!IN_RECTANGLE(conx, cony, CON_W, CON_H)) return;  // out of console
-
-  float playerDist = distance(gameEngine->player);
-  float apparentHeight = height / playerDist;
-  if (apparentHeight < MIN_VISIBLE_HEIGHT) return;  // too small to see at that distance
-
-  TCODColor c;
-  int displayChar = ch;
-  TCODColor lightColor = lightMap.getColor(conx, cony) * 1.5f;
-  map::Dungeon* dungeon = gameEngine->dungeon;
-  float shadow = dungeon->getShadow(x * 2, y * 2);
-  float clouds = dungeon->getCloudCoef(x * 2, y * 2);
-  shadow = MIN(shadow, clouds);
-  lightColor = lightColor * shadow;
-  if (life <= 0) {
-    ch = '%';
-    c = corpseColor * lightColor;
-  } else if (burn) {
-    float fireX = TCODSystem::getElapsedSeconds() * fireSpeed + noiseOffset;
-    int fireIdx = (int)((0.5f + 0.5f * noise1d.get(&fireX)) * 64.0f);
-    c = fire[fireIdx];
-    int r = (int)(c.r * 1.5f * lightColor.r / 255);
-    int g = (int)(c.g * 1.5f * lightColor.g / 255);
-    int b = (int)(c.b * 1.5f * lightColor.b / 255);
-    c.r = CLAMP(0, 255, r);
-    c.g = CLAMP(0, 255, g);
-    c.b = CLAMP(0, 255, b);
-  } else {
-    c = color_ * lightColor;
-  }
-  int intensity = c.r + c.g + c.b;
-  if (intensity < darknessLevel) return;  // creature not seen
-  if (intensity < penumbraLevel) displayChar = '?';
-  if (apparentHeight < VISIBLE_HEIGHT) displayChar = '?';  // too small to distinguish
-  TCODConsole::root->setChar(conx, cony, displayChar);
-  TCODConsole::root->setCharForeground(conx, cony, c);
-}
-
 void Creature::stun(float delay) { walkTimer = MIN(-delay, walkTimer); }
 
 bool Creature::walk(float elapsed) {
@@ -416,6 +362,29 @@ bool Creature::walk(float elapsed) {
   return false;
 }
 
+bool Creature::walkFlowField(float elapsed, const map::FlowField& field) {
+  walkTimer += elapsed;
+  map::TerrainId terrainId = gameEngine->dungeon->getTerrainType((int)x, (int)y);
+  float walkTime = map::terrainTypes[terrainId].walkCost / speed;
+  if (walkTimer >= 0) {
+    walkTimer = -walkTime;
+    base::GameEngine* game = gameEngine;
+    int oldx = (int)x, oldy = (int)y;
+    int newx, newy;
+    if (field.getNextStep(oldx, oldy, &newx, &newy, [game](int cx, int cy) {
+          return (game->player.x != cx || game->player.y != cy) && !game->dungeon->hasCreature(cx, cy);
+        })) {
+      setPos(newx, newy);
+      game->dungeon->moveCreature(this, oldx, oldy, newx, newy);
+      if (game->dungeon->hasRipples(newx, newy)) {
+        gameEngine->startRipple(newx, newy);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
 void Creature::randomWalk(float elapsed) {
   walkTimer += elapsed;
   if (walkTimer >= 0) {
@@ -494,6 +463,7 @@ bool Creature::update(float elapsed) {
       config.getIntProperty("config.aidirector.distReplace") * config.getIntProperty("config.aidirector.distReplace");
 
   if (life <= 0) {
+    std::lock_guard<std::mutex> lock(creatureByTypeMutex);
     creatureByType[type].removeFast(this);
     return false;
   }
@@ -26,16 +26,23 @@
 #pragma once
 #include <libtcod.hpp>
 
+#include <mutex>
+
 #include "base/entity.hpp"
 #include "base/noisything.hpp"
 #include "base/savegame.hpp"
 #include "item.hpp"
+#include "map/path.hpp"
 #include "mob/behavior.hpp"
 
 namespace screen {
 class Game;
 }
 
+namespace map {
+class FlowField;
+}
+
 namespace mob {
 class Creature;
 }
@@ -123,7 +130,8 @@ class Creature : public base::DynamicEntity,
   float life, maxLife;
   float speed;
   float height;  // in meters
-  TCODPath* path;
+  map::Path* path;
+  map::Path* pendingPath;  // computed by the dungeon path service, then swapped with path
   bool ignoreCreatures;  // walk mode
   bool burn;
   int flags;
@@ -151,7 +159,11 @@ class Creature : public base::DynamicEntity,
 
   // factory
   static Creature* getCreature(CreatureTypeId id);
-  static TCODList<Creature*> creatureByType[NB_CREATURE_TYPES];
+  // one living creature of this type, the same until it dies. NULL if none
+  static Creature* getFirstOfType(CreatureTypeId id);
+  static int getNbOfType(CreatureTypeId id);
+  // for a creature deleted without dying. the dead ones are removed by update
+  static void removeFromType(Creature* cr);
 
   virtual bool update(float elapsed);
   virtual void render(map::LightMap& lightMap);
@@ -195,6 +207,9 @@ class Creature : public base::DynamicEntity,
   friend class FollowBehavior;
   friend class HerdBehavior;
   friend class ForestScreen;
+  // the level generation creates creatures on the worker threads
+  static std::mutex creatureByTypeMutex;
+  static TCODList<Creature*> creatureByType[NB_CREATURE_TYPES];
   std::vector<item::Item*> inventory;
   float walkTimer, pathTimer;
   float curDmg;
@@ -203,6 +218,8 @@ class Creature : public base::DynamicEntity,
     float delay;
   } talkText;
   bool walk(float elapsed);
+  // same as walk but goes down the field gradient instead of following path
+  bool walkFlowField(float elapsed, const map::FlowField& field);
   void randomWalk(float elapsed);
 };
 }  // namespace mob
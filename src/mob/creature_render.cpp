@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "mob/creature.hpp"
+
+#include "constants.hpp"
+#include "main.hpp"
+#include "mob/player.hpp"
+#include "spell/fireball.hpp"
+#include "util/subcell.hpp"
+
+// console drawing of the creatures. the simulation side lives in creature.cpp and player.cpp
+namespace mob {
+void Creature::renderTalk() {
+  int conx = (int)(x - gameEngine->xOffset);
+  int cony = (int)(y - gameEngine->yOffset);
+  if (!IN_RECTANGLE(conx, cony, CON_W, CON_H)) return;  // creature out of console
+  talkText.x = conx;
+  talkText.y = cony - talkText.h;
+  if (talkText.y < 0) talkText.y = cony + 1;
+  gameEngine->packer.addRect(&talkText);
+  TCODConsole::root->setDefaultBackground(TCODColor::lighterYellow);
+  TCODConsole::root->setDefaultForeground(TCODColor::darkGrey);
+  TCODConsole::root->printEx((int)talkText.x, (int)talkText.y, TCOD_BKGND_SET, TCOD_CENTER, talkText.text);
+}
+
+void Creature::render(map::LightMap& lightMap) {
+  static int penumbraLevel = config.getIntProperty("config.gameplay.penumbraLevel");
+  static int darknessLevel = config.getIntProperty("config.gameplay.darknessLevel");
+  static float fireSpeed = config.getFloatProperty("config.display.fireSpeed");
+  static TCODColor corpseColor = config.getColorProperty("config.display.corpseColor");
+  static TCODColor lowFire(255, 0, 0);
+  static TCODColor midFire(255, 204, 0);
+  static TCODColor highFire(255, 255, 200);
+  static TCODColor fire[64];
+  static bool fireInit = false;
+  if (!fireInit) {
+    for (int i = 0; i < 32; i++) {
+      fire[i] = TCODColor::lerp(lowFire, midFire, i / 32.0f);
+    }
+    for (int i = 32; i < 64; i++) {
+      fire[i] = TCODColor::lerp(midFire, highFire, (i - 32) / 32.0f);
+    }
+    fireInit = true;
+  }
+
+  // position on console
+  int conx = (int)(x - gameEngine->xOffset);
+  int cony = (int)(y - gameEngine->yOffset);
+  if (!IN_RECTANGLE(conx, cony, CON_W, CON_H)) return;  // out of console
+
+  float playerDist = distance(gameEngine->player);
+  float apparentHeight = height / playerDist;
+  if (apparentHeight < MIN_VISIBLE_HEIGHT) return;  // too small to see at that distance
+
+  TCODColor c;
+  int displayChar = ch;
+  // stays in hdr until the final color
+  map::HDRColor lightColor = lightMap.getHdrColor(conx, cony) * 1.5f;
+  map::Dungeon* dungeon = gameEngine->dungeon;
+  float shadow = dungeon->getShadow(x * 2, y * 2);
+  float clouds = dungeon->getCloudCoef(x * 2, y * 2);
+  shadow = MIN(shadow, clouds);
+  lightColor = lightColor * shadow;
+  if (life <= 0) {
+    ch = '%';
+    c = map::HDRColor(corpseColor) * lightColor;
+  } else if (burn) {
+    float fireX = TCODSystem::getElapsedSeconds() * fireSpeed + noiseOffset;
+    int fireIdx = (int)((0.5f + 0.5f * noise1d.get(&fireX)) * 64.0f);
+    c = map::HDRColor(fire[fireIdx]) * lightColor * 1.5f;
+  } else {
+    c = map::HDRColor(color_) * lightColor;
+  }
+  int intensity = c.r + c.g + c.b;
+  if (intensity < darknessLevel) return;  // creature not seen
+  if (intensity < penumbraLevel) displayChar = '?';
+  if (apparentHeight < VISIBLE_HEIGHT) displayChar = '?';  // too small to distinguish
+  TCODConsole::root->setChar(conx, cony, displayChar);
+  TCODConsole::root->setCharForeground(conx, cony, c);
+}
+
+void Player::render(map::LightMap& lightMap) {
+  static float longButtonDelay = config.getFloatProperty("config.creatures.player.longButtonDelay");
+  static float longSpellDelay = config.getFloatProperty("config.creatures.player.longSpellDelay");
+  static float sprintLength = config.getFloatProperty("config.creatures.player.sprintLength");
+  static bool blink = false;
+
+  Creature::render(lightMap);
+  if ((spell::FireBall::incandescence && lbuttonDelay > longButtonDelay) ||
+      (spell::FireBall::sparkle && rbuttonDelay > longButtonDelay)) {
+    // spell charging progress bar
+    int barLength = 0;
+    float delay = MAX(rbuttonDelay, lbuttonDelay);
+    if (delay >= longSpellDelay) {
+      barLength = 3;
+    } else
+      barLength = 1 + (int)((delay - longButtonDelay) * 1.99 / (longSpellDelay - longButtonDelay));
+    blink = !blink;
+    if (barLength == 3 && blink) barLength = 0;
+    int bary = CON_H / 2 - 1;
+    if (gameEngine->mousey <= CON_H / 2) bary = CON_H / 2 + 1;
+    for (int i = CON_W / 2 - 1; i < CON_W / 2 + barLength - 1; i++) {
+      TCODConsole::root->setChar(i, bary, TCOD_CHAR_PROGRESSBAR);
+      TCODConsole::root->setCharForeground(i, bary, TCODColor::lightRed);
+    }
+  }
+
+  // sprint bar
+  if (isSprinting && !hasCondition(CRIPPLED)) {
+    if (sprintDelay < sprintLength) {
+      float sprintCoef = sprintDelay / sprintLength;
+      static TCODImage sprintBar(10, 2);
+      for (int x = 0; x < 10; x++) {
+        float coef = (x * 0.1f - sprintCoef) * 5;
+        coef = CLAMP(0.0f, 1.0f, coef);
+        TCODColor col = TCODColor::lerp(TCODColor::blue, TCODColor::white, coef);
+        sprintBar.putPixel(x, 0, col);
+        sprintBar.putPixel(x, 1, col);
+      }
+      util::transpBlit2x(&sprintBar, 0, 0, 10, 2, TCODConsole::root, CON_W / 2 - 2, CON_H / 2 + 2, 0.4f);
+    }
+  }
+
+  // stealth bar
+  if (crouch || stealth < 1.0f) {
+    static TCODImage stealthBar(2, 10);
+    for (int y = 0; y < 10; y++) {
+      float coef = (y * 0.1f - stealth) * 5;
+      coef = CLAMP(0.0f, 1.0f, coef);
+      TCODColor col = TCODColor::lerp(TCODColor::white, TCODColor::darkViolet, coef);
+      stealthBar.putPixel(0, y, col);
+      stealthBar.putPixel(1, y, col);
+      util::transpBlit2x(&stealthBar, 0, 0, 2, 10, TCODConsole::root, CON_W / 2 - 3, CON_H / 2 - 3, 0.4f);
+    }
+  }
+}
+}  // namespace mob
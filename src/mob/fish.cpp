@@ -65,10 +65,8 @@ void Fish::render(map::LightMap& lightMap) {
 
   int conx2 = getSubX() - gameEngine->xOffset * 2;
   int cony2 = getSubY() - gameEngine->yOffset * 2;
-  TCODColor rcol = color_;
-  TCODColor bgcol = gameEngine->ground.getPixel(conx2, cony2);
-  rcol = TCODColor::lerp(bgcol, rcol, coef);
-  gameEngine->ground.putPixel(conx2, cony2, rcol);
+  map::HDRColor bgcol = gameEngine->frame.getPixel(conx2, cony2);
+  gameEngine->frame.putPixel(conx2, cony2, map::HDRColor::lerp(bgcol, color_, coef));
 }
 
 void Fish::initItem() {
@@ -83,7 +83,7 @@ bool Villager::update(float elapsed) {
     talkDelay = 0.0f;
     talk(talkGenerator.generate("villager", "${SPOTTED}"));
   }
-  if (Creature::creatureByType[CREATURE_VILLAGER].get(0) == this) {
+  if (Creature::getFirstOfType(CREATURE_VILLAGER) == this) {
     talkDelay += elapsed;
   }
   return true;
@@ -127,20 +127,25 @@ bool Minion::update(float elapsed) {
   if (burn || !seen) {
     randomWalk(elapsed);
   } else {
-    // track player
-    if (!path) {
-      path = new TCODPath(game->dungeon->width, game->dungeon->height, this, game);
-    }
-    if (pathTimer > pathDelay) {
-      int dx, dy;
-      path->getDestination(&dx, &dy);
-      if (dx != game->player.x || dy != game->player.y) {
-        // path is no longer valid (the player moved)
-        path->compute((int)x, (int)y, (int)game->player.x, (int)game->player.y);
-        pathTimer = 0.0f;
+    // track player. the shared flow field when it reaches us, else our own path
+    const map::FlowField& field = game->dungeon->getPlayerFlowField();
+    if (field.isReachable((int)x, (int)y)) {
+      walkFlowField(elapsed, field);
+    } else {
+      if (!pendingPath) {
+        pendingPath = new map::AStarPath(game->dungeon->width, game->dungeon->height, this, game);
+      }
+      if (pathTimer > pathDelay && !game->dungeon->isPathPending(this)) {
+        int dx = -1, dy = -1;
+        if (path) path->getDestination(&dx, &dy);
+        if (dx != game->player.x || dy != game->player.y) {
+          // path is no longer valid (the player moved). keep walking it until the new one is computed
+          game->dungeon->requestPath(this, (int)game->player.x, (int)game->player.y);
+          pathTimer = 0.0f;
+        }
       }
+      walk(elapsed);
     }
-    walk(elapsed);
   }
   float dx = ABS(game->player.x - x);
   float dy = ABS(game->player.y - y);
@@ -30,7 +30,6 @@
 
 #include "base/movement.hpp"
 #include "main.hpp"
-#include "util/subcell.hpp"
 
 namespace mob {
 // maximum sprint : 2 times faster
@@ -146,7 +145,7 @@ bool Player::setPath(int xDest, int yDest, bool limitPath) {
         return false;  // hit another wall. no path
     }
   }
-  if (!path) path = new TCODPath(dungeon->width, dungeon->height, this, NULL);
+  if (!path) path = new map::AStarPath(dungeon->width, dungeon->height, this, NULL);
   ignoreCreatures = false;
   bool ok = path->compute((int)x, (int)y, xDest, yDest);
   if (!ok) {
@@ -163,62 +162,6 @@ bool Player::setPath(int xDest, int yDest, bool limitPath) {
   return true;
 }
 
-void Player::render(map::LightMap& lightMap) {
-  static float longButtonDelay = config.getFloatProperty("config.creatures.player.longButtonDelay");
-  static float longSpellDelay = config.getFloatProperty("config.creatures.player.longSpellDelay");
-  static float sprintLength = config.getFloatProperty("config.creatures.player.sprintLength");
-  static bool blink = false;
-
-  Creature::render(lightMap);
-  if ((spell::FireBall::incandescence && lbuttonDelay > longButtonDelay) ||
-      (spell::FireBall::sparkle && rbuttonDelay > longButtonDelay)) {
-    // spell charging progress bar
-    int barLength = 0;
-    float delay = MAX(rbuttonDelay, lbuttonDelay);
-    if (delay >= longSpellDelay) {
-      barLength = 3;
-    } else
-      barLength = 1 + (int)((delay - longButtonDelay) * 1.99 / (longSpellDelay - longButtonDelay));
-    blink = !blink;
-    if (barLength == 3 && blink) barLength = 0;
-    int bary = CON_H / 2 - 1;
-    if (gameEngine->mousey <= CON_H / 2) bary = CON_H / 2 + 1;
-    for (int i = CON_W / 2 - 1; i < CON_W / 2 + barLength - 1; i++) {
-      TCODConsole::root->setChar(i, bary, TCOD_CHAR_PROGRESSBAR);
-      TCODConsole::root->setCharForeground(i, bary, TCODColor::lightRed);
-    }
-  }
-
-  // sprint bar
-  if (isSprinting && !hasCondition(CRIPPLED)) {
-    if (sprintDelay < sprintLength) {
-      float sprintCoef = sprintDelay / sprintLength;
-      static TCODImage sprintBar(10, 2);
-      for (int x = 0; x < 10; x++) {
-        float coef = (x * 0.1f - sprintCoef) * 5;
-        coef = CLAMP(0.0f, 1.0f, coef);
-        TCODColor col = TCODColor::lerp(TCODColor::blue, TCODColor::white, coef);
-        sprintBar.putPixel(x, 0, col);
-        sprintBar.putPixel(x, 1, col);
-      }
-      util::transpBlit2x(&sprintBar, 0, 0, 10, 2, TCODConsole::root, CON_W / 2 - 2, CON_H / 2 + 2, 0.4f);
-    }
-  }
-
-  // stealth bar
-  if (crouch || stealth < 1.0f) {
-    static TCODImage stealthBar(2, 10);
-    for (int y = 0; y < 10; y++) {
-      float coef = (y * 0.1f - stealth) * 5;
-      coef = CLAMP(0.0f, 1.0f, coef);
-      TCODColor col = TCODColor::lerp(TCODColor::white, TCODColor::darkViolet, coef);
-      stealthBar.putPixel(0, y, col);
-      stealthBar.putPixel(1, y, col);
-      util::transpBlit2x(&stealthBar, 0, 0, 2, 10, TCODConsole::root, CON_W / 2 - 3, CON_H / 2 - 3, 0.4f);
-    }
-  }
-}
-
 // handle movement keys
 // supported layouts:
 // hjklyubn (vi keys)
@@ -345,9 +288,9 @@ bool Player::update(float elapsed, TCOD_key_t key, TCOD_mouse_t* mouse) {
   walkTimer += elapsed;
 
   // special key status
-  bool ctrl = TCODConsole::isKeyPressed(TCODK_CONTROL);
+  bool ctrl = inputLog.isKeyPressed(TCODK_CONTROL);
   // if ( key.vk == TCODK_SHIFT ) isSprinting=key.pressed;
-  isSprinting = TCODConsole::isKeyPressed(TCODK_SHIFT);
+  isSprinting = inputLog.isKeyPressed(TCODK_SHIFT);
 
   // user input
   if (gameEngine->isGamePaused()) {
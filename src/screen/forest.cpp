@@ -33,6 +33,7 @@
 #include "map/building.hpp"
 #include "map/cell.hpp"
 #include "screen/mainmenu.hpp"
+#include "util/profiler.hpp"
 
 namespace screen {
 #define FOREST_W 400
@@ -164,22 +165,36 @@ static LayeredTerrain forestTypes[NB_FORESTS] = {
      }},
 };
 
-enum { DBG_HEIGHTMAP, DBG_SHADOWHEIGHT, DBG_FOV, DBG_NORMALMAP, DBG_CLOUDS, DBG_WATERCOEF, NB_DEBUGMAPS };
-static const char* debugMapNames[] = {"heightmap", "shadowheight", "fov", "normalmap", "clouds", "waterCoef"};
+enum {
+  DBG_HEIGHTMAP,
+  DBG_SHADOWHEIGHT,
+  DBG_FOV,
+  DBG_NORMALMAP,
+  DBG_CLOUDS,
+  DBG_WATERCOEF,
+  DBG_PROFILER,
+  NB_DEBUGMAPS
+};
+static const char* debugMapNames[] = {
+    "heightmap", "shadowheight", "fov", "normalmap", "clouds", "waterCoef", "profiler"};
+
+ForestScreen* ForestScreen::instance = NULL;
 
 ForestScreen::ForestScreen() {
-  forestRng = NULL;
+  instance = this;
+  canopyAspectRatio = 0.0f;
   debugMap = 0;
   fadeInLength = fadeOutLength = (int)(config.getFloatProperty("config.display.fadeTime") * 1000);
 }
 
 void ForestScreen::render() {
+  PROFILE_SCOPE("render");
   static bool debug = config.getBoolProperty("config.debug");
   // draw subcell ground
   int squaredFov = (int)(player.fovRange * player.fovRange * 4);
   int minx, maxx, miny, maxy;
   bool showDebugMap = false;
-  ground.clear(TCODColor::black);
+  frame.clear(TCODColor::black);
   base::Rect r1(xOffset * 2, yOffset * 2, CON_W * 2, CON_H * 2);
   base::Rect r2(0, 0, dungeon->width * 2, dungeon->height * 2);
   r1.intersect(r2);
@@ -188,76 +203,82 @@ void ForestScreen::render() {
   miny = (int)(r1.y - yOffset * 2);
   maxy = (int)(r1.y + r1.h - yOffset * 2);
   float fovRatio = 1.0f / (aspectRatio * aspectRatio);
-  for (int x = minx; x < maxx; x++) {
-    for (int y = miny; y < maxy; y++) {
-      int dungeon2x = x + xOffset * 2;
-      int dungeon2y = y + yOffset * 2;
-      TCODColor col;
-      int dx = (int)(dungeon2x - player.x * 2);
-      int dy = (int)(dungeon2y - player.y * 2);
-      /*
-                              // in fov range, you see under the tree tops
-                              // out of range, you see the tree tops
-                              if ( dx*dx+dy*dy <= squaredFov ) {
-                                      col=dungeon->getShadedGroundColor(dungeon2x,dungeon2y);
-                                      if ( ! dungeon->map2x->isInFov(dungeon2x,dungeon2y) ) col = col * 0.8;
-      */
-      if (dx * dx + dy * dy * fovRatio <= squaredFov && dungeon->map2x->isInFov(dungeon2x, dungeon2y)) {
-        col = dungeon->getShadedGroundColor(dungeon2x, dungeon2y);
-      } else {
-        col = dungeon->canopy->getPixel(dungeon2x, dungeon2y);
-        if (col.r == 0) {
+  bool showProfiler = debug && debugMap == DBG_PROFILER && TCODConsole::isKeyPressed(TCODK_TAB) &&
+                      TCODConsole::isKeyPressed(TCODK_SHIFT);
+  {
+    PROFILE_SCOPE("ground");
+    for (int x = minx; x < maxx; x++) {
+      for (int y = miny; y < maxy; y++) {
+        int dungeon2x = x + xOffset * 2;
+        int dungeon2y = y + yOffset * 2;
+        TCODColor col;
+        int dx = (int)(dungeon2x - player.x * 2);
+        int dy = (int)(dungeon2y - player.y * 2);
+        /*
+                                // in fov range, you see under the tree tops
+                                // out of range, you see the tree tops
+                                if ( dx*dx+dy*dy <= squaredFov ) {
+                                        col=dungeon->getShadedGroundColor(dungeon2x,dungeon2y);
+                                        if ( ! dungeon->map2x->isInFov(dungeon2x,dungeon2y) ) col = col * 0.8;
+        */
+        if (dx * dx + dy * dy * fovRatio <= squaredFov && dungeon->map2x->isInFov(dungeon2x, dungeon2y)) {
           col = dungeon->getShadedGroundColor(dungeon2x, dungeon2y);
         } else {
-          col = col * dungeon->getInterpolatedCloudCoef(dungeon2x, dungeon2y);
+          col = dungeon->canopy->getPixel(dungeon2x, dungeon2y);
+          if (col.r == 0) {
+            col = dungeon->getShadedGroundColor(dungeon2x, dungeon2y);
+          } else {
+            col = col * dungeon->getInterpolatedCloudCoef(dungeon2x, dungeon2y);
+          }
         }
-      }
 
-      // debug maps
-      if (debug && TCODConsole::isKeyPressed(TCODK_TAB) && TCODConsole::isKeyPressed(TCODK_SHIFT)) {
-        switch (debugMap) {
-          case DBG_HEIGHTMAP: {
-            float h = dungeon->hmap->getValue(dungeon2x, dungeon2y);
-            col = h * TCODColor::white;
-          } break;
-          case DBG_SHADOWHEIGHT: {
-            float h = dungeon->getShadowHeight(dungeon2x, dungeon2y);
-            col = h * TCODColor::white;
-          } break;
-          case DBG_FOV: {
-            col = dungeon->map2x->isInFov(dungeon2x, dungeon2y) ? TCODColor::lightGrey : TCODColor::darkGrey;
-          } break;
-          case DBG_NORMALMAP: {
-            float n[3];
-            dungeon->hmap->getNormal(dungeon2x, dungeon2y, n);
-            col = TCODColor((int)(128 + n[0] * 128), (int)(128 + n[1] * 128), (int)(128 + n[2] * 128));
-          } break;
-          case DBG_CLOUDS: {
-            float h = dungeon->getInterpolatedCloudCoef(dungeon2x, dungeon2y);
-            h = (h - 0.5f) / 1.2f;
-            col = h * TCODColor::white;
-          } break;
-          case DBG_WATERCOEF: {
-            float h = dungeon->getWaterCoef(dungeon2x, dungeon2y);
-            col = h * TCODColor::white;
-          } break;
+        // debug maps
+        if (!showProfiler && debug && TCODConsole::isKeyPressed(TCODK_TAB) && TCODConsole::isKeyPressed(TCODK_SHIFT)) {
+          switch (debugMap) {
+            case DBG_HEIGHTMAP: {
+              float h = dungeon->hmap->getValue(dungeon2x, dungeon2y);
+              col = h * TCODColor::white;
+            } break;
+            case DBG_SHADOWHEIGHT: {
+              float h = dungeon->getShadowHeight(dungeon2x, dungeon2y);
+              col = h * TCODColor::white;
+            } break;
+            case DBG_FOV: {
+              col = dungeon->map2x->isInFov(dungeon2x, dungeon2y) ? TCODColor::lightGrey : TCODColor::darkGrey;
+            } break;
+            case DBG_NORMALMAP: {
+              float n[3];
+              dungeon->hmap->getNormal(dungeon2x, dungeon2y, n);
+              col = TCODColor((int)(128 + n[0] * 128), (int)(128 + n[1] * 128), (int)(128 + n[2] * 128));
+            } break;
+            case DBG_CLOUDS: {
+              float h = dungeon->getInterpolatedCloudCoef(dungeon2x, dungeon2y);
+              h = (h - 0.5f) / 1.2f;
+              col = h * TCODColor::white;
+            } break;
+            case DBG_WATERCOEF: {
+              float h = dungeon->getWaterCoef(dungeon2x, dungeon2y);
+              col = h * TCODColor::white;
+            } break;
+          }
+          showDebugMap = true;
         }
-        showDebugMap = true;
-      }
 
-      ground.putPixel(x, y, col);
+        frame.putPixel(x, y, col);
+      }
     }
   }
   // render the subcell creatures
   dungeon->renderSubcellCreatures(lightMap);
   // draw ripples
-  if (!showDebugMap) rippleManager->renderRipples(ground);
+  if (!showDebugMap) rippleManager->renderRipples(frame);
   // render the fireballs
   for (spell::FireBall** it = fireballs.begin(); it != fireballs.end(); it++) {
-    (*it)->render(ground);
+    (*it)->render(frame);
   }
 
-  // blit it on console
+  // tone map and blit it on console
+  frame.toImage(ground);
   ground.blit2x(TCODConsole::root, 0, 0);
   // render the items
   dungeon->renderItems(lightMap);
@@ -291,6 +312,7 @@ void ForestScreen::render() {
     TCODConsole::root->setDefaultBackground(TCODColor::grey);
     TCODConsole::root->setDefaultForeground(TCODColor::white);
     TCODConsole::root->printEx(CON_W / 2, 0, TCOD_BKGND_MULTIPLY, TCOD_CENTER, debugMapNames[debugMap]);
+    if (showProfiler) util::Profiler::getInstance()->renderOverlay(TCODConsole::root, 1, 2);
   }
 
   // TCODConsole::root->print(0,2,"player pos %d %d\nfriend pos %d %d\n",player.x,player.y,fr->x,fr->y);
@@ -345,6 +367,11 @@ bool ForestScreen::update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
     } else if (k.c == 'i' && k.lalt && !k.pressed) {
       // debug mode : Alt-i = item
       dungeon->addItem(item::Item::getItem("short bronze blade", player.x, player.y - 1));
+    } else if (k.c == 't' && k.lalt && !k.pressed) {
+      // debug mode : Alt-t = dump the profiler trace
+      if (util::Profiler::getInstance()->exportChromeTrace("trace.json")) {
+        gui.log.info("Profiler trace saved to trace.json");
+      }
     }
   }
   if (k.vk == TCODK_ALT || k.lalt) lookOn = k.pressed;
@@ -358,7 +385,10 @@ bool ForestScreen::update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
   }
 
   // update player
-  player.update(elapsed, k, &mouse);
+  {
+    PROFILE_SCOPE("player");
+    player.update(elapsed, k, &mouse);
+  }
   xOffset = (int)(player.x - CON_W / 2);
   yOffset = (int)(player.y - CON_H / 2);
 
@@ -366,7 +396,10 @@ bool ForestScreen::update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
   dungeon->updateItems(elapsed, k, &mouse);
 
   // calculate player fov
-  dungeon->computeFov((int)player.x, (int)player.y);
+  {
+    PROFILE_SCOPE("fov");
+    dungeon->computeFov((int)player.x, (int)player.y);
+  }
 
   // update monsters
   if (fade != FADE_DOWN) {
@@ -393,13 +426,15 @@ bool ForestScreen::update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
   return true;
 }
 
-void ForestScreen::placeHouse(map::Dungeon* dungeon, int doorx, int doory, base::Entity::Direction dir) {
-  map::Building* building = map::Building::generate(9, 7, 2, forestRng);
-  building->applyTo(dungeon, doorx, doory);
-  building->setHuntingHide(dungeon);
+void ForestScreen::placeHouse(
+    util::GenerationContext* context, map::Dungeon* dungeon, int doorx, int doory, base::Entity::Direction dir) {
+  map::Building* building = map::Building::generate(9, 7, 2, &context->rng);
+  building->applyTo(dungeon, doorx, doory, false, &context->rng);
+  building->setHuntingHide(dungeon, &context->rng);
 }
 
-void ForestScreen::placeTree(map::Dungeon* dungeon, int x, int y, const item::ItemType* treeType) {
+void ForestScreen::placeTree(
+    util::GenerationContext* context, map::Dungeon* dungeon, int x, int y, const item::ItemType* treeType) {
   // trunk
   int dx = x / 2;
   int dy = y / 2;
@@ -410,17 +445,17 @@ void ForestScreen::placeTree(map::Dungeon* dungeon, int x, int y, const item::It
       dungeon->hasItemFlag(dx, dy + 1, item::ITEM_BUILD_NOT_BLOCK))
     return;
 
-  dungeon->addItem(item::Item::getItem(treeType, x / 2, y / 2));
+  dungeon->addItem(item::Item::getItem(treeType, x / 2, y / 2, true, &context->rng));
   // folliage
-  setCanopy(x, y, treeType);
+  setCanopy(dungeon, context, x, y, treeType);
   if (treeType->hasFeature(item::ITEM_FEAT_PRODUCES)) {
-    float odds = forestRng->getFloat(0.0, 30.0);
+    float odds = context->rng.getFloat(0.0, 30.0);
     if (odds <= 1.0) {
       // drop some fruit/twig
       int dx = x / 2;
       int dy = y / 2;
       dungeon->getClosestWalkable(&dx, &dy);
-      item::Item* it = treeType->produce(odds);
+      item::Item* it = treeType->produce(odds, &context->rng);
       if (it) {
         it->setPos(dx, dy);
         dungeon->addItem(it);
@@ -429,61 +464,67 @@ void ForestScreen::placeTree(map::Dungeon* dungeon, int x, int y, const item::It
   }
 }
 
-int housex, housey;
-void ForestScreen::generateMap(uint32_t seed) {
-  static TCODColor sunColor = TCODColor(250, 250, 255);
+map::Dungeon* ForestScreen::generateMap(util::GenerationContext* context) {
   DBG(("Forest generation start\n"));
-  forestRng = new TCODRandom(seed);
-  dungeon = new map::Dungeon(FOREST_W, FOREST_H);
-
-  saveGame.registerListener(CHA1_CHUNK_ID, base::PHASE_START, this);
-  saveGame.registerListener(DUNG_CHUNK_ID, base::PHASE_START, dungeon);
-  saveGame.registerListener(PLAY_CHUNK_ID, base::PHASE_START, &player);
+  // the layout uses the context rng so that it only depends on the seed
+  TCODRandom* forestRng = &context->rng;
+  map::Dungeon* forest = new map::Dungeon(FOREST_W, FOREST_H, context);
 
-  lightMap.clear(sunColor);
   for (int x = 1; x < FOREST_W - 1; x++) {
-    if (x % 40 == 0) displayProgress(0.4f + (float)(x) / FOREST_W * 0.1f);
+    if (x % 40 == 0) context->setProgress(0.4f + (float)(x) / FOREST_W * 0.1f);
     for (int y = 1; y < FOREST_H - 1; y++) {
-      dungeon->map->setProperties(x, y, true, true);
+      forest->map->setProperties(x, y, true, true);
     }
   }
   for (int x = 2; x < 2 * FOREST_W - 2; x++) {
-    if (x % 40 == 0) displayProgress(0.5f + (float)(x) / (2 * FOREST_W) * 0.1f);
+    if (x % 40 == 0) context->setProgress(0.5f + (float)(x) / (2 * FOREST_W) * 0.1f);
     for (int y = 2; y < 2 * FOREST_H - 2; y++) {
-      dungeon->map2x->setProperties(x, y, true, true);
+      forest->map2x->setProperties(x, y, true, true);
     }
   }
-  displayProgress(0.6f);
-  dungeon->hmap->addFbm(
+  context->setProgress(0.6f);
+  if (context->isCancelled()) {
+    delete forest;
+    return NULL;
+  }
+  forest->hmap->addFbm(
       new TCODNoise(2, forestRng), 2.20 * FOREST_W / 400, 2.20 * FOREST_W / 400, 0, 0, 4.0f, 1.0, 2.05);
-  dungeon->hmap->normalize();
+  forest->hmap->normalize();
   TCODNoise terrainNoise(2, 0.5f, 2.0f, forestRng);
 #ifndef NDEBUG
   float t0 = TCODSystem::getElapsedSeconds();
 #endif
-  housex = forestRng->getInt(20, dungeon->width - 20);
-  housey = forestRng->getInt(20, dungeon->height - 20);
+  int housex = forestRng->getInt(20, forest->width - 20);
+  int housey = forestRng->getInt(20, forest->height - 20);
   // don't put the house on water
-  while (dungeon->hasWater(housex, housey)) {
+  while (forest->hasWater(housex, housey)) {
     housex += 4;
-    if (housex > dungeon->width - 20) {
+    if (housex > forest->width - 20) {
       housex = 20;
       housey += 4;
-      if (housey > dungeon->height - 20) housey = 20;
+      if (housey > forest->height - 20) housey = 20;
     }
   }
-  placeHouse(dungeon, housex, housey, base::Entity::NORTH);
-  dungeon->saveShadowBeforeTree();
+  placeHouse(context, forest, housex, housey, base::Entity::NORTH);
+  forest->startx = housex;
+  forest->starty = housey + 10;
+  forest->saveShadowBeforeTree();
 
   for (int x = 2 * FOREST_W - 1; x >= 0; x--) {
     float f[2];
     f[0] = 2.5f * x / FOREST_W;
-    if (x % 40 == 0) displayProgress(0.6f + (float)(2 * FOREST_W - 1 - x) / (2 * FOREST_W) * 0.4f);
+    if (x % 40 == 0) {
+      context->setProgress(0.6f + (float)(2 * FOREST_W - 1 - x) / (2 * FOREST_W) * 0.4f);
+      if (context->isCancelled()) {
+        delete forest;
+        return NULL;
+      }
+    }
     for (int y = 0; y < 2 * FOREST_H - 1; y++) {
-      if (dungeon->getCell(x / 2, y / 2)->terrain == map::TERRAIN_WOODEN_FLOOR) continue;
+      if (forest->getCell(x / 2, y / 2)->terrain == map::TERRAIN_WOODEN_FLOOR) continue;
       f[1] = 2.5f * y / FOREST_H;
       float height = terrainNoise.getFbm(f, 5.0f);
-      float forestTypeId = (dungeon->hmap->getValue(x, y) * NB_FORESTS);
+      float forestTypeId = (forest->hmap->getValue(x, y) * NB_FORESTS);
       forestTypeId = MIN(NB_FORESTS - 1, forestTypeId);
       LayeredTerrain* forestType1 = &forestTypes[(int)forestTypeId];
       LayeredTerrain* forestType2 = forestType1;
@@ -520,7 +561,7 @@ void ForestScreen::generateMap(uint32_t seed) {
       if ((terrainTypeCoef < 0.25f && !swimmable2 && !map::terrainTypes[info2->terrain].swimmable) || swimmable1 ||
           map::terrainTypes[info1->terrain].swimmable) {
         TCODColor groundCol1 = TCODColor::lerp(map::terrainTypes[info1->terrain].color, nextColor1, layer1Height);
-        dungeon->setGroundColor(x, y, groundCol1);
+        forest->setGroundColor(x, y, groundCol1);
         /*
                 if ( map::terrainTypes[info1->terrain].swimmable && swimmable1 ) waterCoef=1.0f;
                 else if ( map::terrainTypes[info1->terrain].swimmable ) waterCoef=1.0f-layer1Height;
@@ -529,7 +570,7 @@ void ForestScreen::generateMap(uint32_t seed) {
         info = info1;
       } else if (terrainTypeCoef > 0.75f || swimmable2 || map::terrainTypes[info2->terrain].swimmable) {
         TCODColor groundCol2 = TCODColor::lerp(map::terrainTypes[info2->terrain].color, nextColor2, layer2Height);
-        dungeon->setGroundColor(x, y, groundCol2);
+        forest->setGroundColor(x, y, groundCol2);
         /*
                 if ( map::terrainTypes[info2->terrain].swimmable && swimmable2 ) waterCoef=1.0f;
                 else if ( map::terrainTypes[info2->terrain].swimmable ) waterCoef=1.0f-layer2Height;
@@ -557,14 +598,14 @@ else if ( swimmable2 ) waterCoef2=layer2Height;
           coef = 1.0f - waterCoef;
         else if (map::terrainTypes[info2->terrain].swimmable && swimmable2)
           coef = waterCoef;
-        dungeon->setGroundColor(x, y, TCODColor::lerp(groundCol1, groundCol2, coef));
+        forest->setGroundColor(x, y, TCODColor::lerp(groundCol1, groundCol2, coef));
         // waterCoef=waterCoef2*coef + waterCoef1*(1.0f-coef);
         info = (terrainTypeCoef <= 0.5f ? info1 : info2);
       }
       if (map::terrainTypes[info->terrain].ripples) waterCoef = MAX(0.01f, waterCoef);
-      dungeon->getSubCell(x, y)->waterCoef = waterCoef;
-      if ((x & 1) == 0 && (y & 1) == 0 && dungeon->getTerrainType(x / 2, y / 2) != map::TERRAIN_WOODEN_FLOOR) {
-        dungeon->setTerrainType(x / 2, y / 2, info->terrain);
+      forest->getSubCell(x, y)->waterCoef = waterCoef;
+      if ((x & 1) == 0 && (y & 1) == 0 && forest->getTerrainType(x / 2, y / 2) != map::TERRAIN_WOODEN_FLOOR) {
+        forest->setTerrainType(x / 2, y / 2, info->terrain);
         EntityProb* itemData = info->itemData;
         int count = MAX_ENTITY_PROB;
         while (count > 0 && (itemData->itemTypeName != NULL || itemData->creatureType != -1)) {
@@ -577,14 +618,14 @@ else if ( swimmable2 ) waterCoef2=layer2Height;
 
               } else {
                 if (type->isA("tree"))
-                  placeTree(dungeon, x, y, type);
+                  placeTree(context, forest, x, y, type);
                 else
-                  dungeon->addItem(item::Item::getItem(type, x / 2, y / 2));
+                  forest->addItem(item::Item::getItem(type, x / 2, y / 2, true, &context->rng));
               }
             } else {
               mob::Creature* cr = mob::Creature::getCreature((mob::CreatureTypeId)itemData->creatureType);
               cr->setPos(x / 2, y / 2);
-              dungeon->addCreature(cr);
+              forest->addCreature(cr);
             }
           }
           itemData++;
@@ -595,14 +636,27 @@ else if ( swimmable2 ) waterCoef2=layer2Height;
   }
 
   //	static float lightDir[3]={0.2f,0.0f,1.0f};
-  //	dungeon->computeOutdoorLight(lightDir, sunColor);
-  dungeon->smoothShadow();
-  dungeon->computeSpawnSources();
-//	dungeon->applyShadowMap();
+  //	forest->computeOutdoorLight(lightDir, sunColor);
+  forest->smoothShadow();
+  forest->computeSpawnSources(context->config.spawnSourceRange);
+//	forest->applyShadowMap();
 #ifndef NDEBUG
   float t1 = TCODSystem::getElapsedSeconds();
   DBG(("Forest generation end. %g sec\n", t1 - t0));
 #endif
+  return forest;
+}
+
+void ForestScreen::setMap(map::Dungeon* forest, float canopyAspectRatio) {
+  static TCODColor sunColor = TCODColor(250, 250, 255);
+  dungeon = forest;
+  this->canopyAspectRatio = canopyAspectRatio;
+  saveGame.registerListener(CHA1_CHUNK_ID, base::PHASE_START, this);
+  saveGame.registerListener(DUNG_CHUNK_ID, base::PHASE_START, dungeon);
+  saveGame.registerListener(PLAY_CHUNK_ID, base::PHASE_START, &player);
+  lightMap.clear(sunColor);
+  // the font has changed since the map was generated
+  if (canopyAspectRatio != aspectRatio) recomputeCanopy();
 }
 
 // SaveListener
@@ -618,8 +672,9 @@ void ForestScreen::loadMap(uint32_t seed) {
   DBG(("Forest loading start\n"));
   static TCODColor sunColor = TCODColor(250, 250, 255);
   lightMap.clear(sunColor);
-  forestRng = new TCODRandom(seed);
-  dungeon = new map::Dungeon(FOREST_W, FOREST_H);
+  base::ProgressBar progress(this);
+  util::GenerationContext context(seed, &progress);
+  dungeon = new map::Dungeon(FOREST_W, FOREST_H, &context);
 
   saveGame.registerListener(CHA1_CHUNK_ID, base::PHASE_START, this);
   saveGame.registerListener(DUNG_CHUNK_ID, base::PHASE_START, dungeon);
@@ -657,10 +712,20 @@ void ForestScreen::onActivate() {
   TCODConsole::setColorControl(TCOD_COLCTRL_2, ui::guiHighlightedText, TCODColor::black);
   GameEngine::onActivate();
   init();
-  MainMenu::instance->waitForForestGen();
-
   if (newGame) {
-    generateMap(saveGame.seed);
+    // most of the time the main menu has already generated the map in background
+    base::ProgressBar progress(this);
+    float canopyAspectRatio = aspectRatio;
+    map::Dungeon* forest = MainMenu::instance->waitForForestGen(&progress, &canopyAspectRatio);
+    if (!forest) {
+      util::GenerationContext context(saveGame.seed, &progress);
+      context.aspectRatio = aspectRatio;
+      forest = generateMap(&context);
+    }
+    // generateMap put the start position next to the house. setPlayerStartingPosition overwrites it
+    int px = forest->startx;
+    int py = forest->starty;
+    setMap(forest, canopyAspectRatio);
     dungeon->setPlayerStartingPosition();
     int fx, fy;
     fr = new mob::Friend();
@@ -669,11 +734,6 @@ void ForestScreen::onActivate() {
     knife->name_ = strdup("emerald pocketknife");
     knife->an_ = true;
     player.addToInventory(knife);
-    player.x = housex;
-    player.y = housey + 10;
-    int px, py;
-    px = (int)player.x;
-    py = (int)player.y;
     dungeon->getClosestWalkable(&px, &py, true, false);
     player.x = px;
     player.y = py;
@@ -695,6 +755,11 @@ void ForestScreen::onActivate() {
     gui.log.critical("Welcome to the Cave v" VERSION " ! %c?%c for help.", TCOD_COLCTRL_2, TCOD_COLCTRL_STOP);
   lookOn = false;
   rippleManager = new util::RippleManager(dungeon);
+  if (player.name[0] == 0 && headless) {
+    // nobody to type it
+    strcpy(player.name, "You");
+    util::TextGenerator::addGlobalValue("PLAYER_NAME", player.name);
+  }
   if (player.name[0] == 0) {
     if (userPref.nbLaunches == 1) {
       textInput.init("Welcome to The Cave !", "PageUp/PageDown to change font size\nPlease enter your name :", 60);
@@ -35,13 +35,18 @@ namespace screen {
 class ForestScreen : public base::GameEngine, public base::SaveListener {
  public:
   mob::Friend* fr;
+  static ForestScreen* instance;
 
   ForestScreen();
 
   void render() override;
   bool update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) override;
   void onEvent(const SDL_Event&) override{};
-  void generateMap(uint32_t seed);  // generate a new random map
+  // generate a new random map. only uses the context so that it can run on a worker thread.
+  // the house door is stored in the map start position. returns NULL if cancelled
+  static map::Dungeon* generateMap(util::GenerationContext* context);
+  // make a generated map the current one. canopyAspectRatio is the one the map was generated with
+  void setMap(map::Dungeon* forest, float canopyAspectRatio);
   void loadMap(uint32_t seed);  // load map from savegame
 
   void onFontChange();
@@ -51,12 +56,14 @@ class ForestScreen : public base::GameEngine, public base::SaveListener {
   void saveData(uint32_t chunkId, TCODZip* zip) override;
 
  protected:
-  TCODRandom* forestRng;
+  float canopyAspectRatio;  // font aspect ratio when the canopy was drawn
 
   void onActivate() override;
   void onDeactivate() override;
-  void placeTree(map::Dungeon* dungeon, int x, int y, const item::ItemType* treeType);
-  void placeHouse(map::Dungeon* dungeon, int doorx, int doory, base::Entity::Direction dir);
+  static void placeTree(
+      util::GenerationContext* context, map::Dungeon* dungeon, int x, int y, const item::ItemType* treeType);
+  static void placeHouse(
+      util::GenerationContext* context, map::Dungeon* dungeon, int doorx, int doory, base::Entity::Direction dir);
   int debugMap;
   ui::TextInput textInput;
 };
@@ -29,15 +29,21 @@
 #include <stdarg.h>
 #include <stdio.h>
 
+#include <memory>
+
 #include "base/aidirector.hpp"
 #include "main.hpp"
 #include "util/powerup.hpp"
+#include "util/profiler.hpp"
 
 namespace screen {
 Game::Game() : level(0), helpOn(false) {}
 
+Game::~Game() { cancelPrefetch(); }
+
 void Game::onInitialise() {
-  util::PowerupGraph::instance->setFontSize(8 + engine.getFontID() * 2);
+  // the powerup icons are drawn in the font
+  if (!headless) util::PowerupGraph::instance->setFontSize(8 + engine.getFontID() * 2);
   lightMap.fogRange = 15.0f;
 }
 
@@ -60,6 +66,7 @@ void Game::onActivate() {
 }
 
 void Game::render() {
+  PROFILE_SCOPE("render");
   static int nbLevels = config.getIntProperty("config.gameplay.nbLevels");
   static bool debug = config.getBoolProperty("config.debug");
   static TCODColor memoryWallColor = config.getColorProperty("config.display.memoryWallColor");
@@ -69,7 +76,7 @@ void Game::render() {
   TCODConsole::root->clear();
 
   // render the memory map
-  ground.clear(TCODColor::black);
+  frame.clear(TCODColor::black);
   for (int x = 0; x < CON_W; x++) {
     for (int y = 0; y < CON_H; y++) {
       int dungeonx = x + xOffset;
@@ -78,13 +85,13 @@ void Game::render() {
         if (dungeon->getMemory(dungeonx, dungeony)) {
           int dungeonx2x = dungeonx * 2;
           int dungeony2x = dungeony * 2;
-          if (!dungeon->map2x->isTransparent(dungeonx2x, dungeony2x)) ground.putPixel(x * 2, y * 2, memoryWallColor);
+          if (!dungeon->map2x->isTransparent(dungeonx2x, dungeony2x)) frame.putPixel(x * 2, y * 2, memoryWallColor);
           if (!dungeon->map2x->isTransparent(dungeonx2x + 1, dungeony2x))
-            ground.putPixel(x * 2 + 1, y * 2, memoryWallColor);
+            frame.putPixel(x * 2 + 1, y * 2, memoryWallColor);
           if (!dungeon->map2x->isTransparent(dungeonx2x, dungeony2x + 1))
-            ground.putPixel(x * 2, y * 2 + 1, memoryWallColor);
+            frame.putPixel(x * 2, y * 2 + 1, memoryWallColor);
           if (!dungeon->map2x->isTransparent(dungeonx2x + 1, dungeony2x + 1))
-            ground.putPixel(x * 2 + 1, y * 2 + 1, memoryWallColor);
+            frame.putPixel(x * 2 + 1, y * 2 + 1, memoryWallColor);
         }
       }
     }
@@ -168,19 +175,20 @@ void Game::render() {
   maxy2x = MIN(CON_H * 2 - 1, maxy2x);
 
   // shade the 2xground
-  lightMap.applyToImage(ground, minx2x, miny2x, maxx2x, maxy2x);
+  lightMap.applyToImage(frame, minx2x, miny2x, maxx2x, maxy2x);
 
   // render boss health bar
   if (bossSeen && !bossIsDead) {
     float lifeper = (float)(boss->life) / bossLife;
     for (int x = 120; x < 140; x++) {
       TCODColor col = (x - 120) < (int)(lifeper * 20) ? TCODColor::red : TCODColor::darkerRed;
-      ground.putPixel(x, 5, col);
-      ground.putPixel(x, 4, col);
+      frame.putPixel(x, 5, col);
+      frame.putPixel(x, 4, col);
     }
   }
 
-  // blit it on console
+  // tone map and blit it on console
+  frame.toImage(ground);
   ground.blit2x(TCODConsole::root, 0, 0);
 
   // render the corpses
@@ -246,6 +254,9 @@ void Game::render() {
   }
   if (debug) {
     TCODConsole::root->print(2, CON_H - 4, "%d", dungeon->creatures.size());
+    if (TCODConsole::isKeyPressed(TCODK_TAB) && TCODConsole::isKeyPressed(TCODK_SHIFT)) {
+      util::Profiler::getInstance()->renderOverlay(TCODConsole::root, 1, 4);
+    }
   }
   /*
   if ( isGamePaused() && pauseScreen ) {
@@ -283,7 +294,10 @@ bool Game::update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
   }
 
   // update player
-  player.update(elapsed, k, &mouse);
+  {
+    PROFILE_SCOPE("player");
+    player.update(elapsed, k, &mouse);
+  }
   if (isGamePaused()) return true;
 
   xOffset = (int)(player.x - CON_W / 2);
@@ -336,7 +350,10 @@ bool Game::update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
   }
 
   // calculate player fov
-  dungeon->computeFov((int)player.x, (int)player.y);
+  {
+    PROFILE_SCOPE("fov");
+    dungeon->computeFov((int)player.x, (int)player.y);
+  }
 
   // update monsters
   if (fade != FADE_DOWN) {
@@ -400,6 +417,12 @@ bool Game::update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
       finalExplosion = 1.0f;
       k.c = 0;
     }
+    if (k.c == 't' && k.lalt && !k.pressed) {
+      // debug mode : Alt-t = dump the profiler trace
+      if (util::Profiler::getInstance()->exportChromeTrace("trace.json")) {
+        gui.log.info("Profiler trace saved to trace.json");
+      }
+    }
     // debug : change level with numpad +/-
     if (k.vk == TCODK_KPSUB && level > 0 && !k.pressed) {
       termLevel();
@@ -474,8 +497,17 @@ void Game::initLevel() {
 
   player.setLightColor(TCODColor::lerp(playerLightColor, playerLightColorEnd, (float)(level + 1) / nbLevels));
 
-  util::CaveGenerator caveGen(level);
-  dungeon = new map::Dungeon(level, &caveGen);
+  if (nextDungeon.isValid() && nextDungeonLevel == level && nextDungeonSeed == saveGame.seed) {
+    // most of the time the level is already there. else help the worker to finish it
+    dungeon = nextDungeon.get();
+    nextDungeon = util::TaskHandle<map::Dungeon*>();
+  } else {
+    cancelPrefetch();
+    util::GenerationContext context(saveGame.seed + level);
+    dungeon = generateLevel(level, &context);
+  }
+  player.setPos(dungeon->startx, dungeon->starty);
+  if (level < nbLevels - 1) prefetchLevel(level + 1);
   if (level == nbLevels - 1) {
     // boss
     boss = (mob::Boss*)mob::Creature::getCreature(mob::CREATURE_ZEEPOH);
@@ -487,6 +519,30 @@ void Game::initLevel() {
   }
 }
 
+// only uses the context so that it can run on any thread
+map::Dungeon* Game::generateLevel(int level, util::GenerationContext* context) {
+  util::CaveGenerator caveGen(level, context);
+  return new map::Dungeon(level, &caveGen, context);
+}
+
+void Game::prefetchLevel(int level) {
+  cancelPrefetch();
+  uint32_t seed = saveGame.seed;
+  nextDungeonLevel = level;
+  nextDungeonSeed = seed;
+  // one context per level : the result only depends on the seed. it reads the config so it's created here
+  auto context = std::make_shared<util::GenerationContext>(seed + level);
+  nextDungeon =
+      threadPool->getScheduler().submitLong([level, context]() { return generateLevel(level, context.get()); });
+}
+
+void Game::cancelPrefetch() {
+  if (!nextDungeon.isValid()) return;
+  // drop the job if no worker has started it. else wait for the generation and throw the level away
+  if (!nextDungeon.cancel()) delete nextDungeon.get();
+  nextDungeon = util::TaskHandle<map::Dungeon*>();
+}
+
 void Game::termLevel() {
   player.termLevel();
   delete dungeon;
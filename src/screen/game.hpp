@@ -28,11 +28,14 @@
 
 #include "base/gameengine.hpp"
 #include "mob/boss.hpp"
+#include "util/gencontext.hpp"
+#include "util/scheduler.hpp"
 
 namespace screen {
 class Game : public base::GameEngine {
  public:
   Game();
+  ~Game() override;
 
   void render() override;
   bool update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) override;
@@ -44,9 +47,16 @@ class Game : public base::GameEngine {
   float finalExplosion;
 
   bool helpOn;
+  // next level, generated on a worker thread while the current one is played
+  util::TaskHandle<map::Dungeon*> nextDungeon;
+  int nextDungeonLevel = -1;
+  uint32_t nextDungeonSeed = 0;
 
   void initLevel();
   void termLevel();
+  void prefetchLevel(int level);
+  void cancelPrefetch();
+  static map::Dungeon* generateLevel(int level, util::GenerationContext* context);
   void onInitialise() override;
   void onActivate() override;
 };
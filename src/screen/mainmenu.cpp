@@ -28,8 +28,12 @@
 #include <math.h>
 #include <stdio.h>
 
+#include <memory>
+
 #include "constants.hpp"
 #include "main.hpp"
+#include "screen/forest.hpp"
+#include "screen/school.hpp"
 #include "util/subcell.hpp"
 
 namespace screen {
@@ -49,45 +53,50 @@ static const char* menuNames[MENU_NB_ITEMS] = {"New game", "Continue", "Exit"};
 
 MainMenu::MainMenu() : Screen(0), selectedItem(0), elapsed(0.0f), noiseZ(0.0f) {
   instance = this;
-  worldGenJobId = -1;
   fadeInLength = (int)(config.getFloatProperty("config.display.fadeTime") * 1000);
   fadeOutLength = fadeInLength / 2;
 }
 
-struct WorldGenThreadData {
-  TCOD_semaphore_t worldDone;
-  uint32_t seed;
-};
-
-int generateWorld(void* dat) {
-  uint32_t seed = (uint32_t)(uintptr_t)dat;
-  if (config.getBoolProperty("config.debug")) {
-    printf("World seed : %d\n", seed);
+// start generating the new game maps on the worker threads while the player reads the menu and the story.
+// saved games are still loaded when the chapter starts
+void MainMenu::startGeneration(uint32_t seed) {
+  static bool debug = config.getBoolProperty("config.debug");
+  cancelGeneration();
+  if (!threadPool->isMultiThreadEnabled()) return;
+  util::Scheduler& scheduler = threadPool->getScheduler();
+  if (ForestScreen::instance) {
+    if (debug) printf("Forest seed : %d\n", seed);
+    auto context = std::make_shared<util::GenerationContext>(seed, &forestProgress);
+    // font aspect ratio, to get round trees
+    int charw, charh;
+    TCODSystem::getCharSize(&charw, &charh);
+    context->aspectRatio = (float)(charw) / charh;
+    forestAspectRatio = context->aspectRatio;
+    forestGen = scheduler.submitLong([context]() { return ForestScreen::generateMap(context.get()); });
   }
-  // DISABLED
-  //	SchoolScreen::instance->generateWorld(seed);
-  //	TCODSystem::unlockSemaphore(data->worldDone);
-  return 0;
-}
-
-int generateForest(void* dat) {
-  uint32_t seed = (uint32_t)(uintptr_t)dat;
-  if (config.getBoolProperty("config.debug")) {
-    printf("Forest seed : %d\n", seed);
+  if (SchoolScreen::instance) {
+    if (debug) printf("World seed : %d\n", seed);
+    util::Progress* progress = &worldProgress;
+    worldGen = scheduler.submitLong([seed, progress]() { SchoolScreen::instance->generateWorld(seed, progress); });
   }
-  //	ForestScreen::instance->generateMap(seed);
-  //	TCODSystem::unlockSemaphore(data->worldDone);
-  return 0;
 }
 
-int loadForest(void* dat) {
-  uint32_t seed = (uint32_t)(uintptr_t)dat;
-  if (config.getBoolProperty("config.debug")) {
-    printf("Forest seed : %d\n", seed);
+// the player changed their choice. stop the jobs as soon as possible and throw away their result
+void MainMenu::cancelGeneration() {
+  // cancel both before waiting. a worker may already run the other job.
+  // a job still queued is dropped instead of running on this thread
+  forestProgress.cancel();
+  worldProgress.cancel();
+  if (forestGen.isValid() && !forestGen.cancel()) {
+    delete forestGen.get();
+    forestGen = util::TaskHandle<map::Dungeon*>();
   }
-  //	ForestScreen::instance->loadMap(seed);
-  //	TCODSystem::unlockSemaphore(data->worldDone);
-  return 0;
+  if (worldGen.isValid() && !worldGen.cancel()) {
+    worldGen.wait();
+    worldGen = util::TaskHandle<void>();
+  }
+  forestProgress.reset();
+  worldProgress.reset();
 }
 
 void MainMenu::onInitialise() {
@@ -98,7 +107,6 @@ void MainMenu::onInitialise() {
   titlex = CON_W - titlew / 2;
   titley = CON_H / 3 + 28;
   fire = new util::Fire(titlew, titleh + 10);
-  worldDone = TCODSystem::newSemaphore(0);
   rock = new TCODImage("data/img/rock.png");
   rockNormal = new TCODImage("data/img/rock_n.png");
 }
@@ -113,11 +121,7 @@ void MainMenu::onActivate() {
   elapsed = 0.0f;
   smokeElapsed = 0.0f;
   noiseZ += 0.1f;
-  static WorldGenThreadData data;
-  data.worldDone = worldDone;
-  data.seed = saveGame.seed;
-  forestGenJobId = threadPool->addJob(newGame ? generateForest : loadForest, (void*)data.seed);
-  worldGenJobId = threadPool->addJob(generateWorld, &data);
+  if (newGame) startGeneration(saveGame.seed);
   menu.push(MENU_NEW_GAME);
   if (!newGame) {
     menu.push(MENU_CONTINUE);
@@ -326,12 +330,6 @@ bool MainMenu::update(float el, TCOD_key_t k, TCOD_mouse_t mouse) {
           engine.deactivateAll();
           // new game
           if (!newGame) {
-            // cancel the background generation for the saved game
-            if (threadPool->isMultiThreadEnabled()) {
-              // TODO : being able to cancel the jobs
-              waitForForestGen();
-              waitForWorldGen();
-            }
             saveGame.init();
             newGame = true;
             delete rng;
@@ -339,11 +337,7 @@ bool MainMenu::update(float el, TCOD_key_t k, TCOD_mouse_t mouse) {
               printf("New random seed : %d\n", saveGame.seed);
             }
             rng = new TCODRandom(saveGame.seed, TCOD_RNG_CMWC);
-            static WorldGenThreadData data;
-            data.worldDone = worldDone;
-            data.seed = saveGame.seed;
-            forestGenJobId = threadPool->addJob(generateForest, (void*)data.seed);
-            worldGenJobId = threadPool->addJob(generateWorld, &data);
+            startGeneration(saveGame.seed);
           }
           engine.activateModule("chapter1Story");
           return false;
@@ -390,11 +384,20 @@ bool MainMenu::update(float el, TCOD_key_t k, TCOD_mouse_t mouse) {
 }
 
 void MainMenu::waitForWorldGen() {
-  // TCODSystem::lockSemaphore(worldDone);
-  // threadPool->waitUntilFinished(worldGenJobId);
+  if (!worldGen.isValid()) return;
+  worldGen.wait();
+  worldGen = util::TaskHandle<void>();
 }
-void MainMenu::waitForForestGen() {
-  // TCODSystem::lockSemaphore(worldDone);
-  // threadPool->waitUntilFinished(forestGenJobId);
+
+map::Dungeon* MainMenu::waitForForestGen(util::Progress* display, float* canopyAspectRatio) {
+  if (!forestGen.isValid()) return NULL;
+  while (!forestGen.isDone() && threadPool->getScheduler().getNbWorkers() > 0) {
+    display->set(forestProgress.get());
+    TCODSystem::sleepMilli(10);
+  }
+  map::Dungeon* forest = forestGen.get();
+  forestGen = util::TaskHandle<map::Dungeon*>();
+  if (forest) *canopyAspectRatio = forestAspectRatio;
+  return forest;
 }
 }  // namespace screen
@@ -26,8 +26,11 @@
 #pragma once
 #include <libtcod.hpp>
 
+#include "map/dungeon.hpp"
 #include "screen.hpp"
 #include "util/fire.hpp"
+#include "util/progress.hpp"
+#include "util/scheduler.hpp"
 
 namespace screen {
 enum MenuItemId { MENU_NEW_GAME, MENU_CONTINUE, MENU_EXIT, MENU_NB_ITEMS };
@@ -40,23 +43,29 @@ class MainMenu : public Screen {
   void onEvent(const SDL_Event&) override{};
   bool update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) override;
   void waitForWorldGen();
-  void waitForForestGen();
+  // returns the forest generated in background, or NULL if there is none.
+  // display receives the generation progress while waiting.
+  // canopyAspectRatio receives the font aspect ratio the trees were drawn with
+  map::Dungeon* waitForForestGen(util::Progress* display, float* canopyAspectRatio);
 
  protected:
   void onInitialise() override;
   void onActivate() override;
   void computeSmoke(float z, TCODImage* img, int miny, int maxy);
+  void startGeneration(uint32_t seed);
+  void cancelGeneration();
   TCODList<MenuItemId> menu;
   int selectedItem;
   float elapsed;
   float smokeElapsed;
   float noiseZ;
   TCODImage* img;
-  int worldGenJobId;
-  int forestGenJobId;
   // for background world generation
-  TCOD_thread_t backgroundThread;
-  TCOD_semaphore_t worldDone;
+  util::TaskHandle<map::Dungeon*> forestGen;
+  float forestAspectRatio = 1.0f;
+  util::TaskHandle<void> worldGen;
+  util::Progress forestProgress;
+  util::Progress worldProgress;
   // title position & size
   int titlex, titley, titlew, titleh;
   util::Fire* fire;
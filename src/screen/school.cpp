@@ -67,8 +67,9 @@ SchoolScreen::SchoolScreen()
   instance = this;
 }
 
-void SchoolScreen::generateWorld(uint32_t seed) {
+void SchoolScreen::generateWorld(uint32_t seed, util::Progress* progress) {
   static float lightDir[3] = {1.0f, 1.0f, 0.0f};
+  worldGenerated = false;
 
   if (!world) {
     // load resources
@@ -98,8 +99,17 @@ void SchoolScreen::generateWorld(uint32_t seed) {
       }
     }
   }
-  schoolRng = new TCODRandom(seed);
-  worldGen.generate(schoolRng);
+  if (progress && progress->isCancelled()) return;
+  // the previous text generator uses the previous rng
+  delete textGen;
+  textGen = NULL;
+  schoolRng = std::make_unique<TCODRandom>(seed);
+  if (progress) progress->set(0.1f);
+  worldGen.generate(schoolRng.get());
+  if (progress) {
+    if (progress->isCancelled()) return;
+    progress->set(0.8f);
+  }
   worldGen.computeSunLight(lightDir);
   static bool firstActivation = true;
   if (config.getBoolProperty("config.debug") && firstActivation) {
@@ -123,15 +133,15 @@ void SchoolScreen::generateWorld(uint32_t seed) {
     }
     worldimg.save("world_shaded.png");
   }
-  textGen = new util::TextGenerator("data/cfg/school.txg", schoolRng);
-  textGen->setLocalFunction("RANDOM_INT", new util::RandomIntFunc(schoolRng));
-  textGen->setLocalFunction("RANDOM_NAME", new util::RandomNameFunc(schoolRng));
+  textGen = new util::TextGenerator("data/cfg/school.txg", schoolRng.get());
+  textGen->setLocalFunction("RANDOM_INT", new util::RandomIntFunc(schoolRng.get()));
+  textGen->setLocalFunction("RANDOM_NAME", new util::RandomNameFunc(schoolRng.get()));
 
   // find suitable position for schools
   for (int i = 0; i < NB_SCHOOLS; i++) {
     School* sch = &school[i];
-    sch->x = rng->getInt(44, worldGen.getWidth() - 44);
-    sch->y = rng->getInt(44, worldGen.getHeight() - 44);
+    sch->x = schoolRng->getInt(44, worldGen.getWidth() - 44);
+    sch->y = schoolRng->getInt(44, worldGen.getHeight() - 44);
     sch->type = (ESchool)i;
     while (!isPosOk(i)) {
       sch->x++;
@@ -144,7 +154,7 @@ void SchoolScreen::generateWorld(uint32_t seed) {
       }
     }
     // generate school name
-    strcpy(sch->name, util::NameGenerator::generateRandomName(schoolRng));
+    strcpy(sch->name, util::NameGenerator::generateRandomName(schoolRng.get()));
     // determin terrain type
     int terrain1 = getTerrainType(sch->x, sch->y, 16);
     int terrain2 = getTerrainType(sch->x, sch->y, 4);
@@ -162,12 +172,14 @@ void SchoolScreen::generateWorld(uint32_t seed) {
       sch->terrain = School::SNOW;
     strcpy(sch->desc, genSchoolDescription(sch));
   }
+  if (progress) progress->set(1.0f);
   worldGenerated = true;
 }
 
 void SchoolScreen::onActivate() {
   engine.setKeyboardMode(UMBRA_KEYBOARD_RELEASED);
-  if (!worldGenerated) MainMenu::instance->waitForWorldGen();
+  MainMenu::instance->waitForWorldGen();
+  if (!worldGenerated) generateWorld(saveGame.seed);
   selectSchool(0);
   offx = rng->getFloat(MAP_WIDTH, util::HM_WIDTH - MAP_WIDTH - 1);
   offy = rng->getFloat(MAP_WIDTH, util::HM_HEIGHT - MAP_HEIGHT - 1);
@@ -26,8 +26,11 @@
 #pragma once
 #include <libtcod.hpp>
 
+#include <memory>
+
 #include "constants.hpp"
 #include "screen.hpp"
+#include "util/progress.hpp"
 #include "util/textgen.hpp"
 #include "util/worldgen.hpp"
 
@@ -52,7 +55,8 @@ class SchoolScreen : public Screen {
   SchoolScreen();
   void render() override;
   bool update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) override;
-  void generateWorld(uint32_t seed);
+  // can run on a worker thread. gives up if progress is cancelled
+  void generateWorld(uint32_t seed, util::Progress* progress = NULL);
 
  protected:
   School school[NB_SCHOOLS];
@@ -72,7 +76,7 @@ class SchoolScreen : public Screen {
   float fisheyey[MAP_WIDTH][MAP_HEIGHT];
   bool worldGenerated;
   util::TextGenerator* textGen;
-  TCODRandom* schoolRng;
+  std::unique_ptr<TCODRandom> schoolRng;
 
   bool isPosOk(int schoolNum) const;
   int getTerrainType(int x, int y, int range) const;
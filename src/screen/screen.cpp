@@ -27,6 +27,7 @@
 
 #include "constants.hpp"
 #include "main.hpp"
+#include "util/profiler.hpp"
 
 namespace screen {
 int SCREEN_MAIN_MENU;
@@ -91,15 +92,57 @@ void Screen::prepareImage(TCODImage* img) const {
   }
 }
 
+// input of the current engine tick, shared by all the active screens and dialogs
+static UmbraModule* tickOwner = nullptr;
+static float tickElapsed = 0.0f;
+static TCOD_key_t tickKey{};
+static TCOD_mouse_t tickMouse{};
+
+bool Screen::beginTick(float* elapsed, TCOD_key_t* k, TCOD_mouse_t* mouse) {
+  PROFILE_FRAME();
+  bool ok = inputLog.processFrame(elapsed, k, mouse);
+  tickElapsed = *elapsed;
+  tickKey = *k;
+  tickMouse = *mouse;
+  return ok;
+}
+
+bool Screen::updateTick(UmbraModule* module, const TCOD_key_t& k, const TCOD_mouse_t& mouse) {
+  if (tickOwner && tickOwner != module && tickOwner->getActive()) return true;
+  static float timeScale = config.getFloatProperty("config.gameplay.timeScale");
+  tickOwner = module;
+  float elapsed = TCODSystem::getLastFrameLength() * timeScale;
+  TCOD_key_t key = k;
+  TCOD_mouse_t ms = mouse;
+  if (!beginTick(&elapsed, &key, &ms)) {
+    // end of the replay
+    tickOwner = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void Screen::getTickInput(float* elapsed, TCOD_key_t* k, TCOD_mouse_t* mouse) {
+  *elapsed = tickElapsed;
+  *k = tickKey;
+  *mouse = tickMouse;
+}
+
 bool Screen::update() {
+  if (!updateTick(this, key_, ms_)) {
+    engine.deactivateAll();
+    return false;
+  }
   if (timefix > 0) {
     // this is the frame where activate has been called.
     // it might be unusually long. skip update to avoid jerky animation
     timefix = 0.0f;
     return true;
   }
-  static float timeScale = config.getFloatProperty("config.gameplay.timeScale");
-  float elapsed = TCODSystem::getLastFrameLength() * timeScale;
+  return step(tickElapsed, tickKey, tickMouse);
+}
+
+bool Screen::step(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
   if (fade == FADE_UP) {
     fadeLvl += elapsed * 1000.0f / fadeInLength;
     if (fadeLvl >= 1.0f) {
@@ -134,7 +177,8 @@ bool Screen::update() {
     }
     if (fadeEnded) fadeLvl = 0.0f;
   }
-  return update(elapsed, key_, ms_);
+  PROFILE_SCOPE("update");
+  return update(elapsed, k, mouse);
 }
 
 void Screen::setFadeIn(int lengthInMilli, TCODColor col) {
@@ -37,6 +37,16 @@ class Screen : public UmbraModule {
   void keyboard(TCOD_key_t& key) override { key_ = key; }
   void mouse(TCOD_mouse_t& ms) override { ms_ = ms; }
   bool update(void) override;
+  // one simulation step : fading then update. called each frame, or directly by the headless runner
+  bool step(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse);
+  // once per engine tick, before the screens step : starts the profiler frame and records or replays the input.
+  // returns false at the end of the replay
+  static bool beginTick(float* elapsed, TCOD_key_t* k, TCOD_mouse_t* mouse);
+  // umbra owns the main loop : the first active module (screen or dialog) to update in a frame starts the engine
+  // tick with its live input. returns false at the end of the replay
+  static bool updateTick(UmbraModule* module, const TCOD_key_t& k, const TCOD_mouse_t& mouse);
+  // frame time and input of the current engine tick, as recorded or replayed
+  static void getTickInput(float* elapsed, TCOD_key_t* k, TCOD_mouse_t* mouse);
 
   void setFadeIn(int lengthInMilli, TCODColor col = TCODColor::black);  // set fade lengths in milliseconds
   void setFadeOut(int lengthInMilli, TCODColor col = TCODColor::black);  // set fade lengths in milliseconds
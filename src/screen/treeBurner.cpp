@@ -28,11 +28,14 @@
 #include <math.h>
 #include <stdio.h>
 
+#include <vector>
+
 #include "base/entity.hpp"
 #include "main.hpp"
 #include "map/building.hpp"
 #include "map/cell.hpp"
 #include "util/powerup.hpp"
+#include "util/profiler.hpp"
 
 namespace screen {
 #define FOREST_W 400
@@ -109,10 +112,11 @@ enum {
   DBG_NORMALMAP,
   DBG_CLOUDS,
   DBG_WATERCOEF,
+  DBG_PROFILER,
   NB_DEBUGMAPS
 };
 static const char* debugMapNames[] = {
-    "lightmap", "heightmap", "shadowheight", "shadowmap", "fov", "normalmap", "clouds", "waterCoef"};
+    "lightmap", "heightmap", "shadowheight", "shadowmap", "fov", "normalmap", "clouds", "waterCoef", "profiler"};
 
 TreeBurner::TreeBurner() {
   forestRng = NULL;
@@ -122,12 +126,13 @@ TreeBurner::TreeBurner() {
 }
 
 void TreeBurner::render() {
+  PROFILE_SCOPE("render");
   static bool debug = config.getBoolProperty("config.debug");
   // draw subcell ground
   int squaredFov = (int)(player.fovRange * player.fovRange * 4);
   int minx, maxx, miny, maxy;
   bool showDebugMap = false;
-  ground.clear(TCODColor::black);
+  frame.clear(TCODColor::black);
   base::Rect r1(xOffset * 2, yOffset * 2, CON_W * 2, CON_H * 2);
   base::Rect r2(0, 0, dungeon->width * 2, dungeon->height * 2);
   r1.intersect(r2);
@@ -136,27 +141,29 @@ void TreeBurner::render() {
   miny = (int)(r1.y - yOffset * 2);
   maxy = (int)(r1.y + r1.h - yOffset * 2);
   float fovRatio = 1.0f / (aspectRatio * aspectRatio);
-  for (int x = minx; x < maxx; x++) {
+  bool showProfiler = debug && debugMap == DBG_PROFILER && TCODConsole::isKeyPressed(TCODK_TAB) &&
+                      TCODConsole::isKeyPressed(TCODK_SHIFT);
+  // sun light : darkest of the shadows and the clouds
+  {
+    PROFILE_SCOPE("ground");
+    std::vector<float> sunlight(MAX(0, maxx - minx));
     for (int y = miny; y < maxy; y++) {
-      int dungeon2x = x + xOffset * 2;
-      int dungeon2y = y + yOffset * 2;
-      TCODColor col = dungeon->getGroundColor(dungeon2x, dungeon2y);
-
-      ground.putPixel(x, y, col);
-      float intensity = dungeon->getShadow(dungeon2x, dungeon2y);
-      float cloudIntensity = dungeon->getInterpolatedCloudCoef(dungeon2x, dungeon2y);
-      intensity = MIN(intensity, cloudIntensity);
-      TCODColor lightCol = dungeon->getAmbient();
-      if (intensity < 1.0f) {
-        lightCol = lightCol * intensity;
+      for (int x = minx; x < maxx; x++) {
+        int dungeon2x = x + xOffset * 2;
+        int dungeon2y = y + yOffset * 2;
+        frame.putPixel(x, y, dungeon->getGroundColor(dungeon2x, dungeon2y));
+        float intensity = dungeon->getShadow(dungeon2x, dungeon2y);
+        float cloudIntensity = dungeon->getInterpolatedCloudCoef(dungeon2x, dungeon2y);
+        intensity = MIN(intensity, cloudIntensity);
+        sunlight[x - minx] = MIN(intensity, 1.0f);
       }
-      lightMap.setColor2x(x, y, lightCol);
+      if (maxx > minx) lightMap.setColors2x(minx, y, maxx - minx, sunlight.data(), dungeon->getAmbient());
     }
   }
   // render the subcell creatures
   dungeon->renderSubcellCreatures(lightMap);
   // draw ripples
-  rippleManager->renderRipples(ground);
+  rippleManager->renderRipples(frame);
 
   // render the lights
   dungeon->renderLightsToLightMap(lightMap);
@@ -166,7 +173,7 @@ void TreeBurner::render() {
     (*it)->render(lightMap);
   }
   // apply light map
-  lightMap.applyToImageOutdoor(ground);
+  lightMap.applyToImageOutdoor(frame);
 
   // render canopy
   map::Building* playerBuilding = dungeon->getCell(player.x, player.y)->building;
@@ -176,7 +183,7 @@ void TreeBurner::render() {
       int dungeon2y = y + yOffset * 2;
       TCODColor col;
       // debug maps
-      if (debug && TCODConsole::isKeyPressed(TCODK_TAB) && TCODConsole::isKeyPressed(TCODK_SHIFT)) {
+      if (!showProfiler && debug && TCODConsole::isKeyPressed(TCODK_TAB) && TCODConsole::isKeyPressed(TCODK_SHIFT)) {
         switch (debugMap) {
           case DBG_LIGHTMAP: {
             col = lightMap.getColor2x(x, y);
@@ -211,7 +218,7 @@ void TreeBurner::render() {
             col = h * TCODColor::white;
           } break;
         }
-        ground.putPixel(x, y, col);
+        frame.putPixel(x, y, col);
         showDebugMap = true;
       }
 
@@ -225,14 +232,14 @@ void TreeBurner::render() {
         if (col.r != 0) {
           col = col * dungeon->getInterpolatedCloudCoef(dungeon2x, dungeon2y);
           col = col * dungeon->getAmbient();
-          ground.putPixel(x, y, col);
+          frame.putPixel(x, y, col);
         }
       }
     }
   }
 
   if (!showDebugMap) {
-    fireManager->renderFire(ground);
+    fireManager->renderFire(frame);
   }
   // render boss health bar
   static int bossLife = config.getIntProperty("config.creatures.villageHead.life");
@@ -240,12 +247,13 @@ void TreeBurner::render() {
     float lifeper = (float)(boss->life) / bossLife;
     for (int x = 70; x < 90; x++) {
       TCODColor col = (x - 70) < (int)(lifeper * 20) ? TCODColor::red : TCODColor::darkerRed;
-      ground.putPixel(x, 5, col);
-      ground.putPixel(x, 4, col);
+      frame.putPixel(x, 5, col);
+      frame.putPixel(x, 4, col);
     }
   }
 
-  // blit it on console
+  // tone map and blit it on console
+  frame.toImage(ground);
   ground.blit2x(TCODConsole::root, 0, 0);
   // render the corpses
   dungeon->renderCorpses(lightMap);
@@ -284,6 +292,7 @@ void TreeBurner::render() {
     TCODConsole::root->setDefaultBackground(TCODColor::grey);
     TCODConsole::root->setDefaultForeground(TCODColor::white);
     TCODConsole::root->printEx(CON_W / 2, 0, TCOD_BKGND_MULTIPLY, TCOD_CENTER, debugMapNames[debugMap]);
+    if (showProfiler) util::Profiler::getInstance()->renderOverlay(TCODConsole::root, 1, 2);
   }
 
   if (bossIsDead && player.life > 0) {
@@ -336,6 +345,11 @@ bool TreeBurner::update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
       boss->life = 0;
       bossSeen = true;
       bossIsDead = true;
+    } else if (k.c == 't' && k.lalt && !k.pressed) {
+      // debug mode : Alt-t = dump the profiler trace
+      if (util::Profiler::getInstance()->exportChromeTrace("trace.json")) {
+        gui.log.info("Profiler trace saved to trace.json");
+      }
     }
   }
   if (k.vk == TCODK_ALT || k.lalt) lookOn = k.pressed;
@@ -349,7 +363,10 @@ bool TreeBurner::update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
   }
 
   // update player
-  player.update(elapsed, k, &mouse);
+  {
+    PROFILE_SCOPE("player");
+    player.update(elapsed, k, &mouse);
+  }
   xOffset = (int)(player.x - CON_W / 2);
   yOffset = (int)(player.y - CON_H / 2);
 
@@ -381,7 +398,10 @@ bool TreeBurner::update(float elapsed, TCOD_key_t k, TCOD_mouse_t mouse) {
   dungeon->updateItems(elapsed, k, &mouse);
 
   // calculate player fov
-  dungeon->computeFov((int)player.x, (int)player.y);
+  {
+    PROFILE_SCOPE("fov");
+    dungeon->computeFov((int)player.x, (int)player.y);
+  }
 
   // update monsters
   if (fade != FADE_DOWN) {
@@ -422,7 +442,9 @@ void TreeBurner::placeTree(map::Dungeon* dungeon, int x, int y, const item::Item
 void TreeBurner::generateMap(uint32_t seed) {
   DBG(("Forest generation start\n"));
   forestRng = new TCODRandom(seed);
-  dungeon = new map::Dungeon(FOREST_W, FOREST_H);
+  base::ProgressBar progress(this);
+  util::GenerationContext context(seed, &progress);
+  dungeon = new map::Dungeon(FOREST_W, FOREST_H, &context);
 
   for (int x = 1; x < FOREST_W - 1; x++) {
     if (x % 40 == 0) displayProgress(0.4f + (float)(x) / FOREST_W * 0.1f);
@@ -148,18 +148,18 @@ void FireBall::render(map::LightMap& lightMap) {
   }
 }
 
-void FireBall::render(TCODImage& ground) {
+void FireBall::render(map::HDRImage& frame) {
   if (effect == FIREBALL_MOVE) {
     float curx = fx_ * 2 - gameEngine->xOffset * 2;
     float cury = fy_ * 2 - gameEngine->yOffset * 2;
-    TCODColor col = type_data_->lightColor;
+    map::HDRColor col = type_data_->lightColor;
     for (int i = 0; i < type_data_->trailLength; i++) {
       int icurx = (int)curx;
       int icury = (int)cury;
       if (IN_RECTANGLE(icurx, icury, CON_W * 2, CON_H * 2)) {
-        TCODColor lcol = ground.getPixel(icurx, icury);
+        map::HDRColor lcol = frame.getPixel(icurx, icury);
         lcol = lcol + col;
-        ground.putPixel(icurx, icury, lcol);
+        frame.putPixel(icurx, icury, lcol);
       }
       curx -= dx_;
       cury -= dy_;
@@ -171,9 +171,9 @@ void FireBall::render(TCODImage& ground) {
       int lmy = (int)((*it)->y) - gameEngine->yOffset * 2;
       if (IN_RECTANGLE(lmx, lmy, CON_W * 2, CON_H * 2)) {
         if (gameEngine->dungeon->map2x->isInFov((int)((*it)->x), (int)((*it)->y))) {
-          TCODColor lcol = ground.getPixel(lmx, lmy);
+          map::HDRColor lcol = frame.getPixel(lmx, lmy);
           lcol = lcol + light.color;
-          ground.putPixel(lmx, lmy, lcol);
+          frame.putPixel(lmx, lmy, lcol);
         }
       }
     }
@@ -367,29 +367,19 @@ bool FireBall::updateTorch(float elapsed) {
     // warm up adjacent items
     heat_timer_ = 0.0f;
     float radius = current_range_;
-    for (int tx = -(int)floor(radius); tx <= (int)ceil(radius); tx++) {
-      if ((int)(x) + tx >= 0 && (int)(x) + tx < dungeon->width) {
-        int dy = (int)(sqrtf(radius * radius - tx * tx));
-        for (int ty = -dy; ty <= dy; ty++) {
-          if ((int)(y) + ty >= 0 && (int)(y) + ty < dungeon->height) {
-            auto* items = dungeon->getItems((int)(x) + tx, (int)(y) + ty);
-            for (item::Item* it : *items) {
-              // found an adjacent item
-              item::ItemFeature* fireFeat = it->getFeature(item::ITEM_FEAT_FIRE_EFFECT);
-              if (fireFeat) {
-                // item is affected by fire
-                it->fire_resistance_ -= damage / 4;
-              }
-            }
-            mob::Creature* cr = dungeon->getCreature((int)(x) + tx, (int)(y) + ty);
-            if (cr) {
-              cr->burn = true;
-              cr->takeDamage(damage / 4);
-            }
-          }
-        }
+    float heat = damage / 4;
+    dungeon->forEachItemInRadius((int)x, (int)y, radius, [heat](item::Item* it) {
+      // found an adjacent item
+      item::ItemFeature* fireFeat = it->getFeature(item::ITEM_FEAT_FIRE_EFFECT);
+      if (fireFeat) {
+        // item is affected by fire
+        it->fire_resistance_ -= heat;
       }
-    }
+    });
+    dungeon->forEachCreatureInRadius((int)x, (int)y, radius, [heat](mob::Creature* cr) {
+      cr->burn = true;
+      cr->takeDamage(heat);
+    });
   }
   if (fx_life_ < 0.25f) {
     light.color = type_data_->lightColor * fx_life_ * 4;
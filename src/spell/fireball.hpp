@@ -53,7 +53,7 @@ class FireBall : public base::Entity, public base::NoisyThing {
   ~FireBall();
 
   void render(map::LightMap& lightMap);
-  void render(TCODImage& ground);
+  void render(map::HDRImage& frame);
   bool update(float elapsed);
 
  protected:
@@ -27,6 +27,7 @@
 #include "ui/dialog.hpp"
 
 #include "main.hpp"
+#include "screen/screen.hpp"
 #include "util/subcell.hpp"
 
 namespace ui {
@@ -210,8 +211,18 @@ void Scroller::save(TCODZip* zip) { zip->putInt(scrollOffset); }
 void Scroller::load(TCODZip* zip) { scrollOffset = zip->getInt(); }
 
 bool Dialog::update() {
-  static float timeScale = config.getFloatProperty("config.gameplay.timeScale");
-  float elapsed = TCODSystem::getLastFrameLength() * timeScale;
+  if (!screen::Screen::updateTick(this, key_, ms_)) {
+    engine.deactivateAll();
+    return false;
+  }
+  float elapsed;
+  TCOD_key_t k;
+  TCOD_mouse_t ms;
+  screen::Screen::getTickInput(&elapsed, &k, &ms);
+  TCOD_key_t widgetKey = k;
+  TCOD_mouse_t widgetMouse = ms;
+  UmbraWidget::keyboard(widgetKey);
+  UmbraWidget::mouse(widgetMouse);
   if (isMaximizable() && minimiseButton.mouseDown && !waitRelease) {
     if (isMinimized)
       setMaximized();
@@ -225,7 +236,7 @@ bool Dialog::update() {
   }
   if (!UmbraWidget::update()) return false;
   internalUpdate();
-  return update(elapsed, key_, ms_);
+  return update(elapsed, k, ms);
 }
 
 void Dialog::onActivate() {
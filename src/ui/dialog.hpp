@@ -139,14 +139,9 @@ class Scroller {
 class Dialog : public UmbraWidget {
  public:
   Dialog() : flags(0), isMinimized(false), waitRelease(false) {}
-  void keyboard(TCOD_key_t& key) override {
-    key_ = key;
-    UmbraWidget::keyboard(key);
-  }
-  void mouse(TCOD_mouse_t& ms) override {
-    ms_ = ms;
-    UmbraWidget::mouse(ms);
-  }
+  // the live input only starts the engine tick. the widget sees the recorded or replayed input in update
+  void keyboard(TCOD_key_t& key) override { key_ = key; }
+  void mouse(TCOD_mouse_t& ms) override { ms_ = ms; }
   bool update(void) override;
   virtual bool update(float elapsed, TCOD_key_t& k, TCOD_mouse_t& mouse) = 0;
   void setMaximized();
@@ -40,11 +40,11 @@ void CaveGenerator::initData(int size) {
   ground = new TCODImage(size2x, size2x);
 }
 
-CaveGenerator::CaveGenerator(int level) : level(level) {
+CaveGenerator::CaveGenerator(int level, GenerationContext* context) : rng(&context->rng), level(level) {
   // get dungeons min/max size from config
-  static int nbLevels = config.getIntProperty("config.gameplay.nbLevels");
-  static int minSize = config.getIntProperty("config.gameplay.dungeonMinSize");
-  static int maxSize = config.getIntProperty("config.gameplay.dungeonMaxSize");
+  int nbLevels = context->config.nbLevels;
+  int minSize = context->config.dungeonMinSize;
+  int maxSize = context->config.dungeonMaxSize;
 
   initData(minSize + (maxSize - minSize) * (level + 1) / nbLevels);
 
@@ -92,7 +92,7 @@ CaveGenerator::CaveGenerator(int level) : level(level) {
     if (level < 2 * nbLevels / 3)
       cavecell = CellularAutomata(cell);
     else
-      cavecell = CellularAutomata(size, size, 40);
+      cavecell = CellularAutomata(size, size, 40, rng);
     // cavecell.generate(&CellularAutomata::CAFunc_dig,1);
     cavecell.generate(&CellularAutomata::CAFunc_cave, 4);
     cavecell.generate(&CellularAutomata::CAFunc_cave2, 3);
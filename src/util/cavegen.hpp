@@ -26,10 +26,13 @@
 #pragma once
 #include <libtcod.hpp>
 
+#include "util/gencontext.hpp"
+
 namespace util {
 class CaveGenerator : public ITCODBspCallback {
  public:
-  CaveGenerator(int level);  // bsp / cellular automate dungeon
+  // bsp / cellular automate dungeon. only uses the context so that it can run on any thread
+  CaveGenerator(int level, GenerationContext* context);
 
   // the final dungeon map
   TCODMap* map = nullptr;  // normal resolution for pathfinding
@@ -38,6 +41,7 @@ class CaveGenerator : public ITCODBspCallback {
   int size;
   int size2x;  // well.. size*2
   TCODImage* ground = nullptr;  // ground color (subcell rez)
+  TCODRandom* rng = nullptr;  // random generator for this level
 
   // dungeon generator stuff
   bool visitNode(TCODBsp* node, void* userData) override;
@@ -65,7 +65,7 @@ void CellularAutomata::apply(TCODMap* map) {
   }
 }
 
-void CellularAutomata::randomize(int per) {
+void CellularAutomata::randomize(int per, TCODRandom* rng) {
   for (int px = min_x_; px <= max_x_; ++px) {
     for (int py = min_y_; py <= max_x_; ++py) {
       if (rng->getInt(0, 100) < per)
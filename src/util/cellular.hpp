@@ -33,11 +33,11 @@ class CellularAutomata {
   typedef bool (CellularAutomata::*CAFunc)(int x, int y, void* userData);
   CellularAutomata() = default;
   CellularAutomata(int w, int h) : w_{w}, h_{h}, min_x_{0}, min_y_{0}, max_x_{w - 1}, max_y_{h - 1}, data_(w * h) {}
-  CellularAutomata(int w, int h, int per) : CellularAutomata{w, h} { randomize(per); }
+  CellularAutomata(int w, int h, int per, TCODRandom* rng) : CellularAutomata{w, h} { randomize(per, rng); }
   CellularAutomata(TCODMap* map);
   CellularAutomata(CellularAutomata& c1, CellularAutomata& c2, float morphCoef);
   // per % of cells are empty
-  void randomize(int per);
+  void randomize(int per, TCODRandom* rng);
   void generate(CAFunc func, int nbLoops, void* userData = NULL);
   // number of active cells at given range
   int count(int x, int y, int range);
@@ -32,13 +32,13 @@
 namespace util {
 // returns a value between 0.5 and 1.2
 // 50% chances between 0.5 and 1.0 (clouds), 50% chances between 1.0 and 1.2 (clear sky)
-static inline float noiseFunc(float* f) {
+float CloudBox::noiseFunc(float* f) {
   /*
   float ret = 0.5f * (1.0f + noise2d.getFbm(f,4.0f)); // 0.0  - 1.0
   ret = 1.2f - 0.3f * ret; // 0.8 - 1.2
   if ( ret < 1.0f ) ret *= 0.75f + 2.5f * (ret-0.9f); // 0.5 - 1.0
   */
-  float ret = noise2d.getFbm(f, 4.0f);
+  float ret = noise->getFbm(f, 4.0f);
   if (ret < 0.0f)
     ret = 1.0f + ret * 0.5f;  // 0.5 - 1.0
   else
@@ -46,7 +46,9 @@ static inline float noiseFunc(float* f) {
   return ret;
 }
 
-CloudBox::CloudBox(int width, int height) : width(width), height(height), xOffset(0.0f), xTotalOffset(0.0f) {
+CloudBox::CloudBox(int width, int height, GenerationContext* context)
+    : width(width), height(height), xOffset(0.0f), xTotalOffset(0.0f) {
+  noise = new TCODNoise(2, &context->noiseRng);
   data = new float[width * height];
   highOctaveNoise = new float[width * height];
   float f[2];
@@ -56,7 +58,7 @@ CloudBox::CloudBox(int width, int height) : width(width), height(height), xOffse
   float f2[3];
   float* hoval = highOctaveNoise;
   for (int y = 0; y < height; y++) {
-    if (y % 40 == 0) gameEngine->displayProgress(0.1f + (float)y / height * 0.3f);
+    if (y % 40 == 0) context->setProgress(0.1f + (float)y / height * 0.3f);
     f[1] = (6.0f * y) / height;
     f2[2] = f[1] * 15.0f;
     for (int x = 0; x < width; x++) {
@@ -66,7 +68,7 @@ CloudBox::CloudBox(int width, int height) : width(width), height(height), xOffse
       f2[1] = 15.0f * sinf(angle);
       *val = noiseFunc(f);
       val++;
-      *hoval = 0.3f * noise3d.getFbm(f2, 8.0f);
+      *hoval = 0.3f * context->noise3d.getFbm(f2, 8.0f);
       hoval++;
     }
   }
@@ -81,7 +83,10 @@ CloudBox::CloudBox(int width, int height) : width(width), height(height), xOffse
   TCODColor::genMap(cloudColorMap, 4, up, upKeys);
 }
 
-CloudBox::~CloudBox() { delete[] data; }
+CloudBox::~CloudBox() {
+  delete[] data;
+  delete noise;
+}
 
 float CloudBox::getData(float* pdata, int x, int y) {
   int realX = (x + x0) % width;
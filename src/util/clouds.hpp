@@ -26,10 +26,12 @@
 #pragma once
 #include <libtcod.hpp>
 
+#include "util/gencontext.hpp"
+
 namespace util {
 class CloudBox {
  public:
-  CloudBox(int width, int height);
+  CloudBox(int width, int height, GenerationContext* context);
   ~CloudBox();
   float getInterpolatedThickness(int x, int y);
   float getThickness(int x, int y);
@@ -41,6 +43,8 @@ class CloudBox {
   float *data, xOffset, xTotalOffset;
   float* highOctaveNoise = nullptr;
   TCODColor cloudColorMap[256];
+  TCODNoise* noise = nullptr;  // owned so that the clouds keep scrolling after the generation context is gone
+  float noiseFunc(float* f);
   float getNoisierThickness(int x, int y);
   float getData(float* data, int x, int y);
   float getInterpolatedData(float* data, int x, int y);
@@ -30,6 +30,7 @@
 
 #include "constants.hpp"
 #include "main.hpp"
+#include "util/profiler.hpp"
 
 // #define FIRE_DEBUG
 
@@ -183,6 +184,7 @@ void FireManager::removeZone(int x, int y, int w, int h) {
 }
 
 void FireManager::update(float elapsed) {
+  PROFILE_SCOPE("fire");
   static float zoneDecay = config.getFloatProperty("config.fireManager.zoneDecay");
   el += elapsed;
   if (el < UPDATE_DELAY) return;
@@ -267,7 +269,7 @@ void FireManager::update(float elapsed) {
   */
 }
 
-void FireManager::renderFire(TCODImage& ground) {
+void FireManager::renderFire(map::HDRImage& frame) {
   int dx = gameEngine->xOffset * 2;
   int dy = gameEngine->yOffset * 2;
   screenFireZone.x = MAX(dx, screenFireZone.x);
@@ -279,8 +281,8 @@ void FireManager::renderFire(TCODImage& ground) {
       uint8_t v = get(x, y);
       if (v > 0) {
         map::HDRColor col = fireColor[v];
-        col = col * 1.5f + ground.getPixel(x - dx, y - dy);
-        ground.putPixel(x - dx, y - dy, col);
+        col = col * 1.5f + frame.getPixel(x - dx, y - dy);
+        frame.putPixel(x - dx, y - dy, col);
       }
     }
   }
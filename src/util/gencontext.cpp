@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "util/gencontext.hpp"
+
+#include "main.hpp"
+
+namespace util {
+void GenerationConfig::load(TCODParser& parser) {
+  debug = parser.getBoolProperty("config.debug");
+  nbLevels = parser.getIntProperty("config.gameplay.nbLevels");
+  dungeonMinSize = parser.getIntProperty("config.gameplay.dungeonMinSize");
+  dungeonMaxSize = parser.getIntProperty("config.gameplay.dungeonMaxSize");
+  spawnSourceRange = parser.getIntProperty("config.aidirector.spawnSourceRange");
+  treeRadius = parser.getIntProperty("config.display.treeRadius");
+  groundColor = parser.getColorProperty("config.display.groundColor");
+  memoryWallColor = parser.getColorProperty("config.display.memoryWallColor");
+}
+
+GenerationContext::GenerationContext(uint32_t seed, Progress* progress)
+    : seed(seed),
+      rng(seed, TCOD_RNG_CMWC),
+      detailRng(seed ^ 0x5bd1e995, TCOD_RNG_CMWC),
+      noiseRng(seed ^ 0x9e3779b9, TCOD_RNG_CMWC),
+      noise2d(2, &noiseRng),
+      noise3d(3, &noiseRng),
+      progress(progress) {
+  config.load(::config);
+}
+}  // namespace util
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <libtcod.hpp>
+
+#include "util/progress.hpp"
+
+namespace util {
+// config values used by map generation, read once on the main thread
+struct GenerationConfig {
+  bool debug;
+  int nbLevels;
+  int dungeonMinSize;
+  int dungeonMaxSize;
+  int spawnSourceRange;
+  int treeRadius;
+  TCODColor groundColor;
+  TCODColor memoryWallColor;
+
+  void load(TCODParser& parser);
+};
+
+// everything a map generator needs from the outside world. each generation job owns its context
+// so that several maps can be generated at the same time, on any thread.
+// must be created on the main thread because it reads the config.
+class GenerationContext {
+ public:
+  GenerationContext(uint32_t seed, Progress* progress = NULL);
+
+  uint32_t seed;
+  TCODRandom rng;  // map layout
+  TCODRandom detailRng;  // cosmetic details. doesn't shift the layout when they change
+  TCODRandom noiseRng;
+  TCODNoise noise2d;
+  TCODNoise noise3d;
+  GenerationConfig config;
+  float aspectRatio = 1.0f;  // font char width / height, for round trees
+
+  inline void setProgress(float value) {
+    if (progress) progress->set(value);
+  }
+  inline bool isCancelled() const { return progress && progress->isCancelled(); }
+
+ protected:
+  Progress* progress;
+};
+}  // namespace util
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "util/parallel.hpp"
+
+#include "main.hpp"
+
+namespace util {
+Scheduler* getDefaultScheduler() { return ::threadPool ? &::threadPool->getScheduler() : NULL; }
+
+std::vector<Tile> makeTiles(int width, int height, int tileSize, int halo) {
+  std::vector<Tile> tiles;
+  for (int y = 0; y < height; y += tileSize) {
+    for (int x = 0; x < width; x += tileSize) {
+      Tile tile;
+      tile.minx = x;
+      tile.miny = y;
+      tile.maxx = std::min(x + tileSize, width);
+      tile.maxy = std::min(y + tileSize, height);
+      tile.hminx = std::max(0, tile.minx - halo);
+      tile.hminy = std::max(0, tile.miny - halo);
+      tile.hmaxx = std::min(width, tile.maxx + halo);
+      tile.hmaxy = std::min(height, tile.maxy + halo);
+      tiles.push_back(tile);
+    }
+  }
+  return tiles;
+}
+}  // namespace util
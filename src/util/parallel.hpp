@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "util/scheduler.hpp"
+
+namespace util {
+// scheduler used by the parallel loops. NULL if the thread pool is not created yet
+Scheduler* getDefaultScheduler();
+
+// run f(i) for i in [0, count[ on the worker threads and the calling thread
+template <typename F>
+void parallelFor(int count, F&& f) {
+  Scheduler* scheduler = getDefaultScheduler();
+  int nbWorkers = scheduler ? scheduler->getNbWorkers() : 0;
+  if (nbWorkers == 0 || count <= 1) {
+    for (int i = 0; i < count; i++) f(i);
+    return;
+  }
+  std::atomic<int> next{0};
+  auto loop = [&next, &f, count]() {
+    for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) f(i);
+  };
+  std::vector<TaskHandle<void>> helpers;
+  int nbHelpers = std::min(nbWorkers, count - 1);
+  for (int i = 0; i < nbHelpers; i++) helpers.push_back(scheduler->submit(loop));
+  loop();
+  for (TaskHandle<void>& helper : helpers) helper.wait();
+}
+
+// a rectangle of a 2D grid processed by one task
+struct Tile {
+  int minx, miny, maxx, maxy;  // cells written by the tile. max excluded
+  int hminx, hminy, hmaxx, hmaxy;  // cells read by the tile, including the halo, clamped to the grid
+};
+
+std::vector<Tile> makeTiles(int width, int height, int tileSize, int halo);
+
+// run f(tile) on every tile of a width x height grid
+template <typename F>
+void parallelFor2D(int width, int height, F&& f, int tileSize = 64) {
+  std::vector<Tile> tiles = makeTiles(width, height, tileSize, 0);
+  parallelFor((int)tiles.size(), [&](int i) { f(tiles[i]); });
+}
+
+// copy of a tile neighbourhood, taken before anyone writes to the grid
+template <typename T>
+class HaloBuffer {
+ public:
+  template <typename Get>
+  void load(const Tile& tile, Get& get) {
+    minx = tile.hminx;
+    miny = tile.hminy;
+    w = tile.hmaxx - tile.hminx;
+    data.resize(w * (tile.hmaxy - tile.hminy));
+    for (int y = tile.hminy; y < tile.hmaxy; y++) {
+      for (int x = tile.hminx; x < tile.hmaxx; x++) data[(x - minx) + (y - miny) * w] = get(x, y);
+    }
+  }
+  const T& operator()(int x, int y) const { return data[(x - minx) + (y - miny) * w]; }
+
+ protected:
+  int minx = 0, miny = 0, w = 0;
+  std::vector<T> data;
+};
+
+// in place stencil reading at most halo cells around the written cell.
+// every tile first snapshots its neighbourhood with get(x,y), then f(tile, buffer) writes the tile from the snapshot
+// so the result only depends on the original grid, whatever the tile order.
+template <typename T, typename Get, typename F>
+void parallelStencil2D(int width, int height, int halo, Get&& get, F&& f, int tileSize = 64) {
+  std::vector<Tile> tiles = makeTiles(width, height, tileSize, halo);
+  std::vector<HaloBuffer<T>> buffers(tiles.size());
+  parallelFor((int)tiles.size(), [&](int i) { buffers[i].load(tiles[i], get); });
+  parallelFor((int)tiles.size(), [&](int i) { f(tiles[i], (const HaloBuffer<T>&)buffers[i]); });
+}
+}  // namespace util
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "util/profiler.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace util {
+// open scopes of the current thread
+struct OpenScope {
+  const char* name;
+  int64_t start;
+};
+static thread_local std::vector<OpenScope> openScopes;
+static thread_local int threadId = -1;
+static std::atomic<int> nbThreads{1};  // 0 is the thread running the frames
+
+Profiler* Profiler::getInstance() {
+  static Profiler instance;
+  return &instance;
+}
+
+Profiler::Profiler() : origin(std::chrono::steady_clock::now()) {}
+
+int64_t Profiler::now() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Profiler::beginFrame() {
+  threadId = 0;
+  int64_t t = now();
+  std::lock_guard<std::mutex> lock(mutex);
+  Frame& previous = frames[currentFrame];
+  if (previous.start > 0) {
+    previous.duration = t - previous.start;
+    currentFrame = (currentFrame + 1) % NB_FRAMES;
+    nbFrames = std::min(nbFrames + 1, NB_FRAMES - 1);
+  }
+  Frame& frame = frames[currentFrame];
+  frame.start = t;
+  frame.duration = 0;
+  frame.events.clear();
+  frame.counters.clear();
+}
+
+void Profiler::begin(const char* name) { openScopes.push_back({name, now()}); }
+
+void Profiler::end() {
+  if (openScopes.empty()) return;
+  OpenScope scope = openScopes.back();
+  openScopes.pop_back();
+  if (threadId < 0) threadId = nbThreads++;
+  int64_t t = now();
+  std::lock_guard<std::mutex> lock(mutex);
+  frames[currentFrame].events.push_back({scope.name, threadId, (int)openScopes.size(), scope.start, t - scope.start});
+}
+
+void Profiler::counter(const char* name, int64_t value) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<Counter>& counters = frames[currentFrame].counters;
+  for (Counter& c : counters) {
+    if (strcmp(c.name, name) == 0) {
+      c.value = value;
+      return;
+    }
+  }
+  counters.push_back({name, value});
+}
+
+void Profiler::renderOverlay(TCODConsole* con, int x, int y) const {
+  struct Stat {
+    const char* name;
+    int64_t total;  // accumulated over all frames
+    int64_t max;  // worst frame. a scope can run several times per frame
+    int64_t inFrame;
+  };
+  std::vector<Stat> stats;
+  std::vector<Stat> counters;  // same fields, in counter units
+  int64_t frameTotal = 0, frameMax = 0;
+  // time outside the update and render scopes : console flush and event polling done by umbra
+  int64_t otherTotal = 0, otherMax = 0;
+  int n;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    n = nbFrames;
+    if (n == 0) return;
+    for (int i = 1; i <= n; i++) {
+      const Frame& frame = frames[(currentFrame - i + NB_FRAMES) % NB_FRAMES];
+      frameTotal += frame.duration;
+      frameMax = std::max(frameMax, frame.duration);
+      for (Stat& s : stats) s.inFrame = 0;
+      int64_t scoped = 0;
+      for (const Event& ev : frame.events) {
+        auto it =
+            std::find_if(stats.begin(), stats.end(), [&ev](const Stat& s) { return strcmp(s.name, ev.name) == 0; });
+        if (it == stats.end()) {
+          stats.push_back({ev.name, 0, 0, 0});
+          it = stats.end() - 1;
+        }
+        it->inFrame += ev.duration;
+        if (ev.depth == 0 && ev.thread == 0) scoped += ev.duration;
+      }
+      for (Stat& s : stats) {
+        s.total += s.inFrame;
+        s.max = std::max(s.max, s.inFrame);
+      }
+      for (const Counter& c : frame.counters) {
+        auto it = std::find_if(
+            counters.begin(), counters.end(), [&c](const Stat& s) { return strcmp(s.name, c.name) == 0; });
+        if (it == counters.end()) {
+          counters.push_back({c.name, 0, 0, 0});
+          it = counters.end() - 1;
+        }
+        it->total += c.value;
+        it->max = std::max(it->max, c.value);
+      }
+      otherTotal += frame.duration - scoped;
+      otherMax = std::max(otherMax, frame.duration - scoped);
+    }
+  }
+  con->setDefaultBackground(TCODColor::black);
+  con->setDefaultForeground(TCODColor::white);
+  con->printEx(x, y, TCOD_BKGND_SET, TCOD_LEFT, "%-22s %6s %6s", "ms", "avg", "max");
+  con->setDefaultForeground(TCODColor::lightYellow);
+  con->printEx(x, y + 1, TCOD_BKGND_SET, TCOD_LEFT, "%-22s %6.2f %6.2f", "frame", frameTotal * 0.001f / n,
+               frameMax * 0.001f);
+  con->printEx(x, y + 2, TCOD_BKGND_SET, TCOD_LEFT, "%-22s %6.2f %6.2f", "flush/events", otherTotal * 0.001f / n,
+               otherMax * 0.001f);
+  con->setDefaultForeground(TCODColor::lightGrey);
+  int cy = y + 3;
+  for (const Stat& s : stats) {
+    con->printEx(x, cy++, TCOD_BKGND_SET, TCOD_LEFT, "%-22.22s %6.2f %6.2f", s.name, s.total * 0.001f / n,
+                 s.max * 0.001f);
+  }
+  con->setDefaultForeground(TCODColor::lightBlue);
+  for (const Stat& s : counters) {
+    con->printEx(x, cy++, TCOD_BKGND_SET, TCOD_LEFT, "%-22.22s %6.1f %6lld", s.name, (float)s.total / n,
+                 (long long)s.max);
+  }
+}
+
+bool Profiler::exportChromeTrace(const char* filename) const {
+  FILE* f = fopen(filename, "wt");
+  if (!f) return false;
+  std::lock_guard<std::mutex> lock(mutex);
+  fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+  for (int i = nbFrames; i >= 1; i--) {
+    const Frame& frame = frames[(currentFrame - i + NB_FRAMES) % NB_FRAMES];
+    fprintf(
+        f,
+        "%s{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%lld,\"dur\":%lld}",
+        first ? "" : ",\n",
+        (long long)frame.start,
+        (long long)frame.duration);
+    first = false;
+    for (const Event& ev : frame.events) {
+      fprintf(
+          f,
+          ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}",
+          ev.name,
+          ev.thread,
+          (long long)ev.start,
+          (long long)ev.duration);
+    }
+    for (const Counter& c : frame.counters) {
+      fprintf(
+          f,
+          ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%lld,\"args\":{\"value\":%lld}}",
+          c.name,
+          (long long)frame.start,
+          (long long)c.value);
+    }
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+  return true;
+}
+}  // namespace util
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <libtcod.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace util {
+// frame profiler. scopes are recorded in a ring buffer of the last frames
+// which can be displayed as an overlay or exported as a chrome trace (chrome://tracing, perfetto).
+// use the PROFILE_SCOPE macro. it compiles out when NO_PROFILER is defined (release builds)
+class Profiler {
+ public:
+  static Profiler* getInstance();
+
+  // called at the start of each frame
+  void beginFrame();
+  // scopes. name must be a string literal. can be called from any thread
+  void begin(const char* name);
+  void end();
+  // value of a counter in the current frame. name must be a string literal
+  void counter(const char* name, int64_t value);
+  // average and max time of each scope over the buffered frames
+  void renderOverlay(TCODConsole* con, int x, int y) const;
+  bool exportChromeTrace(const char* filename) const;
+
+ protected:
+  static constexpr int NB_FRAMES = 128;
+  struct Event {
+    const char* name;
+    int thread;  // 0 is the thread calling beginFrame
+    int depth;
+    int64_t start;  // microseconds since the profiler creation
+    int64_t duration;
+  };
+  struct Counter {
+    const char* name;
+    int64_t value;
+  };
+  struct Frame {
+    int64_t start = 0;
+    int64_t duration = 0;
+    std::vector<Event> events;
+    std::vector<Counter> counters;
+  };
+
+  Profiler();
+  int64_t now() const;
+
+  std::chrono::steady_clock::time_point origin;
+  mutable std::mutex mutex;
+  Frame frames[NB_FRAMES];
+  int currentFrame = 0;
+  int nbFrames = 0;  // number of complete frames in the ring buffer
+};
+
+class ProfileScope {
+ public:
+  explicit ProfileScope(const char* name) { Profiler::getInstance()->begin(name); }
+  ~ProfileScope() { Profiler::getInstance()->end(); }
+};
+}  // namespace util
+
+#ifndef NO_PROFILER
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(name) util::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FRAME() util::Profiler::getInstance()->beginFrame()
+#define PROFILE_COUNTER(name, value) util::Profiler::getInstance()->counter(name, value)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FRAME()
+#define PROFILE_COUNTER(name, value)
+#endif
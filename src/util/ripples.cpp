@@ -33,6 +33,7 @@
 #include "main.hpp"
 #include "map/dungeon.hpp"
 #include "mob/fish.hpp"
+#include "util/profiler.hpp"
 
 namespace util {
 // range below which fishes try to get away from each other
@@ -172,6 +173,7 @@ void RippleManager::startRipple(int dungeonx, int dungeony, float height) {
 }
 
 bool RippleManager::updateRipples(float elapsed) {
+  PROFILE_SCOPE("ripples");
   // compute visible part of the dungeon
   base::Rect visibleZone;
   visibleZone.x = gameEngine->xOffset;
@@ -287,7 +289,7 @@ bool RippleManager::updateRipples(float elapsed) {
   return updated;
 }
 
-void RippleManager::renderRipples(TCODImage& ground) {
+void RippleManager::renderRipples(map::HDRImage& frame) {
   if (zones.size() == 0) init();
   // compute visible part of the dungeon
   base::Rect visibleZone;
@@ -326,9 +328,9 @@ void RippleManager::renderRipples(TCODImage& ground) {
             float f[3] = {static_cast<float>(zx2), static_cast<float>(zy2), elCoef};
             xOffset += noise3d.get(f) * 0.3f;
             if (ABS(xOffset) < 250 && ABS(yOffset) < 250) {
-              TCODColor col = ground.getPixel(groundx + (int)(xOffset * 2), groundy + (int)(yOffset * 2));
+              map::HDRColor col = frame.getPixel(groundx + (int)(xOffset * 2), groundy + (int)(yOffset * 2));
               col = col + TCODColor::white * xOffset * 0.1f;
-              ground.putPixel(groundx, groundy, col);
+              frame.putPixel(groundx, groundy, col);
             }
           }
         }
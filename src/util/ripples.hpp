@@ -31,7 +31,8 @@
 
 namespace map {
 class Dungeon;
-}
+class HDRImage;
+}  // namespace map
 
 namespace mob {
 class Shoal;
@@ -52,7 +53,7 @@ class RippleManager {
   RippleManager(map::Dungeon* dungeon);
   void startRipple(int dungeonx, int dungeony, float height = 0.0f);
   bool updateRipples(float elapsed);
-  void renderRipples(TCODImage& ground);
+  void renderRipples(map::HDRImage& frame);
 
  protected:
   map::Dungeon* dungeon = nullptr;
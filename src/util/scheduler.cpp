@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "util/scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace util {
+// worker the current thread belongs to, if any
+static thread_local Scheduler* currentScheduler = nullptr;
+static thread_local int currentWorker = -1;
+
+WorkStealingDeque::WorkStealingDeque(int capacity) : buffer(new Buffer(capacity)) {}
+
+WorkStealingDeque::~WorkStealingDeque() {
+  delete buffer.load(std::memory_order_relaxed);
+  for (Buffer* old : retired) delete old;
+}
+
+WorkStealingDeque::Buffer* WorkStealingDeque::grow(Buffer* old, int64_t b, int64_t t) {
+  Buffer* bigger = new Buffer(old->capacity() * 2);
+  for (int64_t i = t; i < b; i++) bigger->put(i, old->get(i));
+  retired.push_back(old);
+  buffer.store(bigger, std::memory_order_release);
+  return bigger;
+}
+
+void WorkStealingDeque::push(Task* task) {
+  int64_t b = bottom.load(std::memory_order_relaxed);
+  int64_t t = top.load(std::memory_order_acquire);
+  Buffer* buf = buffer.load(std::memory_order_relaxed);
+  if (b - t > buf->capacity() - 1) buf = grow(buf, b, t);
+  buf->put(b, task);
+  std::atomic_thread_fence(std::memory_order_release);
+  bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+Task* WorkStealingDeque::pop() {
+  int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+  Buffer* buf = buffer.load(std::memory_order_relaxed);
+  bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t t = top.load(std::memory_order_relaxed);
+  if (t > b) {
+    // empty
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  Task* task = buf->get(b);
+  if (t == b) {
+    // last item. race against thieves
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) task = nullptr;
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+  return task;
+}
+
+Task* WorkStealingDeque::steal() {
+  int64_t t = top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t b = bottom.load(std::memory_order_acquire);
+  if (t >= b) return nullptr;
+  Buffer* buf = buffer.load(std::memory_order_acquire);
+  Task* task = buf->get(t);
+  if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+  return task;
+}
+
+bool WorkStealingDeque::isEmpty() const {
+  return top.load(std::memory_order_acquire) >= bottom.load(std::memory_order_acquire);
+}
+
+Scheduler::Scheduler(int nbWorkers) {
+  for (int i = 0; i < nbWorkers; i++) deques.push_back(std::make_unique<WorkStealingDeque>());
+  for (int i = 0; i < nbWorkers; i++) workers.emplace_back(&Scheduler::workerLoop, this, i);
+}
+
+Scheduler::~Scheduler() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  sleepCond.notify_all();
+  for (std::thread& worker : workers) worker.join();
+  // drop tasks that never ran. the workers are joined so stealing from their deques can't fail
+  while (Task* task = findWork()) task->release();
+  for (auto& deque : deques)
+    while (Task* task = deque->steal()) task->release();
+  while (Task* task = findLongJob()) task->release();
+}
+
+void Scheduler::schedule(Task* task) {
+  if (currentScheduler == this && currentWorker >= 0) {
+    deques[currentWorker]->push(task);
+  } else {
+    std::lock_guard<std::mutex> lock(injectMutex);
+    injected.push_back(task);
+    queuedInjected.fetch_add(1, std::memory_order_release);
+  }
+  queued.fetch_add(1, std::memory_order_release);
+  {
+    // empty critical section so that a worker can't miss the wakeup between its check and its wait
+    std::lock_guard<std::mutex> lock(sleepMutex);
+  }
+  sleepCond.notify_one();
+  doneCond.notify_all();
+}
+
+void Scheduler::scheduleLong(Task* task) {
+  {
+    std::lock_guard<std::mutex> lock(injectMutex);
+    longJobs.push_back(task);
+  }
+  queuedLong.fetch_add(1, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+  }
+  // the waiters are not woken up : they don't pick long jobs
+  sleepCond.notify_one();
+}
+
+Task* Scheduler::findWork() {
+  Task* task = nullptr;
+  bool isWorker = currentScheduler == this && currentWorker >= 0;
+  if (isWorker) task = deques[currentWorker]->pop();
+  if (!task) {
+    std::lock_guard<std::mutex> lock(injectMutex);
+    if (!injected.empty()) {
+      task = injected.front();
+      injected.pop_front();
+      queuedInjected.fetch_sub(1, std::memory_order_acq_rel);
+    }
+  }
+  if (!task && isWorker) {
+    // steal from the other workers, starting after ourself to spread contention.
+    // the other threads don't : the deques also hold the subtasks of the long jobs
+    int nbDeques = (int)deques.size();
+    for (int i = 1; i < nbDeques && !task; i++) task = deques[(currentWorker + i) % nbDeques]->steal();
+  }
+  if (task) queued.fetch_sub(1, std::memory_order_acq_rel);
+  return task;
+}
+
+Task* Scheduler::findLongJob() {
+  std::lock_guard<std::mutex> lock(injectMutex);
+  if (longJobs.empty()) return nullptr;
+  Task* task = longJobs.front();
+  longJobs.pop_front();
+  queuedLong.fetch_sub(1, std::memory_order_acq_rel);
+  return task;
+}
+
+void Scheduler::run(Task* task) {
+  task->execute();
+  std::vector<Task*> continuations;
+  {
+    std::lock_guard<std::mutex> lock(task->continuationMutex);
+    task->done.store(true, std::memory_order_release);
+    continuations.swap(task->continuations);
+  }
+  for (Task* cont : continuations) schedule(cont);
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+  }
+  doneCond.notify_all();
+  task->release();
+}
+
+void Scheduler::addContinuation(Task* parent, Task* cont) {
+  {
+    std::lock_guard<std::mutex> lock(parent->continuationMutex);
+    if (!parent->isDone()) {
+      parent->continuations.push_back(cont);
+      return;
+    }
+  }
+  schedule(cont);
+}
+
+bool Scheduler::cancel(Task* task) {
+  {
+    std::lock_guard<std::mutex> lock(injectMutex);
+    auto it = std::find(longJobs.begin(), longJobs.end(), task);
+    if (it == longJobs.end()) return false;
+    longJobs.erase(it);
+  }
+  queuedLong.fetch_sub(1, std::memory_order_acq_rel);
+  task->release();  // reference owned by the queue
+  return true;
+}
+
+void Scheduler::wait(Task* task) {
+  Scheduler* prevScheduler = currentScheduler;
+  if (!currentScheduler) currentScheduler = this;
+  bool claimed = false;
+  {
+    // a long job only runs inline on the thread waiting for it
+    std::lock_guard<std::mutex> lock(injectMutex);
+    auto it = std::find(longJobs.begin(), longJobs.end(), task);
+    if (it != longJobs.end()) {
+      longJobs.erase(it);
+      queuedLong.fetch_sub(1, std::memory_order_acq_rel);
+      claimed = true;
+    }
+  }
+  if (claimed) run(task);
+  while (!task->isDone()) {
+    if (Task* work = findWork()) {
+      run(work);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    // the timeout only guards against a task stolen by a worker which finishes between our checks
+    std::atomic<int>& available = currentScheduler == this && currentWorker >= 0 ? queued : queuedInjected;
+    doneCond.wait_for(lock, std::chrono::milliseconds(1),
+                      [&] { return task->isDone() || available.load(std::memory_order_acquire) > 0; });
+  }
+  currentScheduler = prevScheduler;
+}
+
+void Scheduler::workerLoop(int id) {
+  currentScheduler = this;
+  currentWorker = id;
+  while (true) {
+    // a worker waiting inside a task never gets here, so it doesn't start a long job in the middle of it
+    Task* task = findWork();
+    if (!task) task = findLongJob();
+    if (task) {
+      run(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    sleepCond.wait(lock, [this] {
+      return stopping || queued.load(std::memory_order_acquire) + queuedLong.load(std::memory_order_acquire) > 0;
+    });
+    if (stopping) return;
+  }
+}
+}  // namespace util
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2010 Jice
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * The name of Jice may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Jice ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL Jice BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace util {
+class Scheduler;
+
+// a unit of work. reference counted : the scheduler queues and every TaskHandle hold a reference
+class Task {
+ public:
+  virtual ~Task() = default;
+  bool isDone() const { return done.load(std::memory_order_acquire); }
+
+ protected:
+  friend class Scheduler;
+  template <typename T>
+  friend class TaskHandle;
+
+  virtual void execute() = 0;
+  void addRef() { refs.fetch_add(1, std::memory_order_relaxed); }
+  void release() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+  }
+
+  std::atomic<int> refs{1};
+  std::atomic<bool> done{false};
+  std::mutex continuationMutex;
+  std::vector<Task*> continuations;  // scheduled when this task completes
+};
+
+template <typename T>
+class TaskImpl : public Task {
+ public:
+  explicit TaskImpl(std::function<T()> fn) : fn(std::move(fn)) {}
+  T& getResult() { return *result; }
+
+ protected:
+  void execute() override {
+    result.emplace(fn());
+    fn = nullptr;
+  }
+  std::function<T()> fn;
+  std::optional<T> result;
+};
+
+template <>
+class TaskImpl<void> : public Task {
+ public:
+  explicit TaskImpl(std::function<void()> fn) : fn(std::move(fn)) {}
+  void getResult() {}
+
+ protected:
+  void execute() override {
+    fn();
+    fn = nullptr;
+  }
+  std::function<void()> fn;
+};
+
+// Chase-Lev deque. only the owner worker pushes and pops (LIFO), other threads steal (FIFO)
+class WorkStealingDeque {
+ public:
+  explicit WorkStealingDeque(int capacity = 1024);
+  ~WorkStealingDeque();
+  void push(Task* task);
+  Task* pop();
+  Task* steal();
+  bool isEmpty() const;
+
+ protected:
+  struct Buffer {
+    explicit Buffer(int64_t capacity) : mask(capacity - 1), slots(new std::atomic<Task*>[capacity]) {}
+    ~Buffer() { delete[] slots; }
+    int64_t capacity() const { return mask + 1; }
+    Task* get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+    void put(int64_t i, Task* task) { slots[i & mask].store(task, std::memory_order_relaxed); }
+    int64_t mask;
+    std::atomic<Task*>* slots;
+  };
+  Buffer* grow(Buffer* buffer, int64_t bottom, int64_t top);
+
+  std::atomic<int64_t> top{0};
+  std::atomic<int64_t> bottom{0};
+  std::atomic<Buffer*> buffer;
+  // buffers replaced by grow. thieves may still read them so they are only freed with the deque
+  std::vector<Buffer*> retired;
+};
+
+// typed handle on a scheduled task
+template <typename T>
+class TaskHandle {
+ public:
+  TaskHandle() = default;
+  TaskHandle(Scheduler* scheduler, TaskImpl<T>* task) : scheduler(scheduler), task(task) {}
+  TaskHandle(const TaskHandle& other) : scheduler(other.scheduler), task(other.task) {
+    if (task) task->addRef();
+  }
+  TaskHandle(TaskHandle&& other) noexcept : scheduler(other.scheduler), task(other.task) { other.task = nullptr; }
+  TaskHandle& operator=(TaskHandle other) noexcept {
+    std::swap(scheduler, other.scheduler);
+    std::swap(task, other.task);
+    return *this;
+  }
+  ~TaskHandle() {
+    if (task) task->release();
+  }
+
+  bool isValid() const { return task != nullptr; }
+  bool isDone() const { return task && task->isDone(); }
+  // block until the task is done. the calling thread runs pending tasks meanwhile
+  void wait() const;
+  // drop a long job that no thread has started. the handle becomes invalid.
+  // returns false if the task is running or done : wait for it instead
+  bool cancel();
+  // wait and return the task result
+  decltype(auto) get() const {
+    wait();
+    return task->getResult();
+  }
+  // schedule f(result) (or f() for void tasks) once this task is done
+  template <typename F>
+  auto then(F&& f) const;
+
+ protected:
+  friend class Scheduler;
+  Scheduler* scheduler = nullptr;
+  TaskImpl<T>* task = nullptr;
+};
+
+class Scheduler {
+ public:
+  // nbWorkers == 0 : tasks only run when some thread waits for them
+  explicit Scheduler(int nbWorkers);
+  ~Scheduler();
+
+  template <typename F>
+  auto submit(F&& f) -> TaskHandle<std::invoke_result_t<F>> {
+    using R = std::invoke_result_t<F>;
+    TaskImpl<R>* task = new TaskImpl<R>(std::function<R()>(std::forward<F>(f)));
+    task->addRef();  // reference owned by the queue
+    schedule(task);
+    return TaskHandle<R>(this, task);
+  }
+  // a job lasting several frames, like a level generation. only the workers pick it, when they have nothing else
+  // to do, or the thread waiting for this very job. so waiting for a short task never runs it inline
+  template <typename F>
+  auto submitLong(F&& f) -> TaskHandle<std::invoke_result_t<F>> {
+    using R = std::invoke_result_t<F>;
+    TaskImpl<R>* task = new TaskImpl<R>(std::function<R()>(std::forward<F>(f)));
+    task->addRef();  // reference owned by the queue
+    scheduleLong(task);
+    return TaskHandle<R>(this, task);
+  }
+  // register cont to be scheduled when parent is done
+  void addContinuation(Task* parent, Task* cont);
+  // remove a long job from the queue if no thread has started it
+  bool cancel(Task* task);
+  // run pending tasks until task is done, starting with task itself if it is a long job still queued. a thread that
+  // is not a worker runs the injected tasks, submitted by any of the threads that are not workers, not only its own
+  void wait(Task* task);
+  int getNbWorkers() const { return (int)workers.size(); }
+
+ protected:
+  void schedule(Task* task);
+  void scheduleLong(Task* task);
+  Task* findWork();
+  Task* findLongJob();
+  void run(Task* task);
+  void workerLoop(int id);
+
+  std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+  std::vector<std::thread> workers;
+  // tasks submitted from threads that are not workers of this scheduler
+  std::mutex injectMutex;
+  std::deque<Task*> injected;
+  std::deque<Task*> longJobs;  // also protected by injectMutex
+  // idle workers and waiters sleep here
+  std::mutex sleepMutex;
+  std::condition_variable sleepCond;
+  std::condition_variable doneCond;
+  std::atomic<int> queued{0};
+  std::atomic<int> queuedInjected{0};  // the part of queued the other threads can pick
+  std::atomic<int> queuedLong{0};
+  std::atomic<bool> stopping{false};
+};
+
+template <typename T>
+void TaskHandle<T>::wait() const {
+  if (task && !task->isDone()) scheduler->wait(task);
+}
+
+template <typename T>
+bool TaskHandle<T>::cancel() {
+  if (!task || !scheduler->cancel(task)) return false;
+  task->release();
+  task = nullptr;
+  return true;
+}
+
+template <typename T>
+template <typename F>
+auto TaskHandle<T>::then(F&& f) const {
+  TaskHandle<T> parent(*this);
+  if constexpr (std::is_void_v<T>) {
+    using R = std::invoke_result_t<F>;
+    TaskImpl<R>* cont = new TaskImpl<R>([parent, f = std::forward<F>(f)]() mutable { return f(); });
+    cont->addRef();
+    scheduler->addContinuation(task, cont);
+    return TaskHandle<R>(scheduler, cont);
+  } else {
+    using R = std::invoke_result_t<F, T&>;
+    TaskImpl<R>* cont =
+        new TaskImpl<R>([parent, f = std::forward<F>(f)]() mutable { return f(parent.task->getResult()); });
+    cont->addRef();
+    scheduler->addContinuation(task, cont);
+    return TaskHandle<R>(scheduler, cont);
+  }
+}
+}  // namespace util
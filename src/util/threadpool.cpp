@@ -30,42 +30,8 @@
 #include "main.hpp"
 
 namespace util {
-static TCOD_semaphore_t sem = NULL;
-static TCOD_mutex_t todoMutex = NULL;
-static TCOD_mutex_t finishedMutex = NULL;
-static TCODList<ThreadData*> todoList;
-static TCODList<ThreadData*> finished;
-static int jobId = 0;
 ThreadPool* threadPool = nullptr;
 
-int thread_pool_func(void* dat) {
-  // wait for something to do
-  do {
-    TCODSystem::lockSemaphore(sem);
-    // do some job
-    if (todoList.size() > 0) {
-      // get some job from todo list
-      TCODSystem::mutexIn(todoMutex);
-      ThreadData* data = NULL;
-      if (todoList.size() > 0) {
-        data = todoList.get(0);
-        todoList.remove(data);
-      }
-      TCODSystem::mutexOut(todoMutex);
-      if (data && data->job != NULL) {
-        // do the job
-        data->jobResult = data->job(data->jobData);
-        TCODSystem::unlockSemaphore(data->sem);
-        // and put the result in finished list
-        TCODSystem::mutexIn(finishedMutex);
-        finished.push(data);
-        TCODSystem::mutexOut(finishedMutex);
-      }
-    }
-  } while (true);
-  return 0;
-}
-
 ThreadPool::ThreadPool() {
   static bool multithread = config.getBoolProperty("config.multithread");
   static int threadPoolSize = config.getIntProperty("config.threadPoolSize");
@@ -83,13 +49,13 @@ ThreadPool::ThreadPool() {
       printf("Background threads pool size : %d\n", nbThreads);
     }
   }
-  sem = TCODSystem::newSemaphore(0);
-  todoMutex = TCODSystem::newMutex();
-  finishedMutex = TCODSystem::newMutex();
-  // start all the threads and put them in idle state
-  for (int i = 0; i < nbThreads; i++) {
-    threads.push(TCODSystem::newThread(thread_pool_func, NULL));
-  }
+  // without worker, jobs are run by the thread calling waitUntilFinished
+  scheduler = new Scheduler(nbThreads);
+}
+
+ThreadPool::~ThreadPool() {
+  jobs.clear();
+  delete scheduler;
 }
 
 bool ThreadPool::isMultiThreadEnabled() {
@@ -98,56 +64,31 @@ bool ThreadPool::isMultiThreadEnabled() {
 }
 
 int ThreadPool::addJob(thread_job_t job, void* jobData) {
-  ThreadData* data = new ThreadData();
-  data->job = job;
-  data->jobData = jobData;
-  data->sem = TCODSystem::newSemaphore(0);
-  TCODSystem::mutexIn(todoMutex);
-  data->id = jobId++;
-  todoList.push(data);
-  TCODSystem::mutexOut(todoMutex);
-  TCODSystem::unlockSemaphore(sem);
-  return data->id;
+  TaskHandle<int> handle = scheduler->submit([job, jobData]() { return job(jobData); });
+  std::lock_guard<std::mutex> lock(jobsMutex);
+  int id = nextJobId++;
+  jobs[id] = std::move(handle);
+  return id;
 }
 
 bool ThreadPool::isFinished(int jobId) {
-  TCODSystem::mutexIn(finishedMutex);
-  for (ThreadData** it = finished.begin(); it != finished.end(); it++) {
-    if ((*it)->id == jobId) {
-      finished.remove(it);
-      TCODSystem::mutexOut(finishedMutex);
-      TCODSystem::deleteSemaphore((*it)->sem);
-      delete (*it);
-      return true;
-    }
-  }
-  TCODSystem::mutexOut(finishedMutex);
-  return false;
+  std::lock_guard<std::mutex> lock(jobsMutex);
+  auto it = jobs.find(jobId);
+  if (it == jobs.end() || !it->second.isDone()) return false;
+  jobs.erase(it);
+  return true;
 }
 
 void ThreadPool::waitUntilFinished(int jobId) {
-  if (isFinished(jobId)) return;  // job already finished
-  TCODSystem::mutexIn(todoMutex);
-  for (ThreadData** it = todoList.begin(); it != todoList.end(); it++) {
-    if ((*it)->id == jobId) {
-      // wait for job to finish
-      TCODSystem::mutexOut(todoMutex);
-      if (threads.size() == 0) {
-        // no thread ! do it yourself, pal!
-        (*it)->job((*it)->jobData);
-        TCODSystem::mutexIn(todoMutex);
-        todoList.remove(it);
-        TCODSystem::mutexOut(todoMutex);
-        TCODSystem::deleteSemaphore((*it)->sem);
-        delete (*it);
-      } else {
-        // wait for the thread to finished the job
-        TCODSystem::lockSemaphore((*it)->sem);
-        isFinished(jobId);  // todo release resources
-      }
-      return;
-    }
+  TaskHandle<int> handle;
+  {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    auto it = jobs.find(jobId);
+    if (it == jobs.end()) return;  // unknown job or already finished
+    handle = it->second;
   }
-  TCODSystem::mutexOut(todoMutex);
+  // help running the queued jobs rather than sleeping
+  handle.wait();
+  isFinished(jobId);
 }
 }  // namespace util
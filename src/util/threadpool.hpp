@@ -25,28 +25,30 @@
  */
 #pragma once
 #include <libtcod.hpp>
+#include <mutex>
+#include <unordered_map>
+
+#include "util/scheduler.hpp"
 
 namespace util {
 typedef int (*thread_job_t)(void* dat);
 
-struct ThreadData {
-  int id;
-  void* jobData = nullptr;
-  TCOD_semaphore_t sem;
-  thread_job_t job;
-  int jobResult;
-};
-
+// legacy job API on top of the work stealing scheduler
 class ThreadPool {
  public:
   ThreadPool();
+  ~ThreadPool();
   int addJob(thread_job_t job, void* data);
   bool isFinished(int jobId);
   bool isMultiThreadEnabled();
   void waitUntilFinished(int jobId);
+  Scheduler& getScheduler() { return *scheduler; }
 
  protected:
-  TCODList<TCOD_thread_t> threads;
+  Scheduler* scheduler;
+  std::mutex jobsMutex;
+  std::unordered_map<int, TaskHandle<int>> jobs;
+  int nextJobId = 0;
   int nbCores;
 };
 }  // namespace util